@@ -0,0 +1,529 @@
+#include "../include/Common.hpp"
+#include "../include/Animation.hpp"
+#include "../include/Animator.hpp"
+#include "../include/ObjLoader.hpp"
+#include "../include/TextureCooker.hpp"
+#include <assimp/postprocess.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <new>
+
+using namespace std;
+
+// 창 없이 Bone / Animation / Animator 와 OBJ 파싱, 탄젠트 생성, 텍스처 쿠킹의 비용만 잰다. (GL 컨텍스트를 만들지 않는다)
+
+// 스레드마다 따로 세어서 측정 구간(worker) 안의 할당만 더한다.
+static thread_local size_t  t_allocations = 0;
+
+void*   operator new(size_t size)
+{
+    ++t_allocations;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return (ptr);
+    throw std::bad_alloc();
+};
+
+void    operator delete(void* ptr) noexcept
+{ std::free(ptr); };
+
+void    operator delete(void* ptr, size_t) noexcept
+{ std::free(ptr); };
+
+struct Rig
+{
+    std::string                     name;
+    std::unique_ptr<Animation>      clip;
+    BoneRemap                       remap;
+};
+
+struct Result
+{
+    double  nsPerBone;
+    double  allocationsPerFrame;
+    double  msPerFrame;
+};
+
+// 길이가 keyCount 인 트랙을 가진 boneCount 개짜리 bone 사슬(4 갈래)을 만든다.
+std::unique_ptr<Rig>    CreateSyntheticRig(int boneCount, int keyCount)
+{
+    std::vector<aiNode*>    nodes;
+    for (int i = 0; i < boneCount; ++i)
+        nodes.push_back(new aiNode("bone_" + std::to_string(i)));
+    for (int i = 0; i < boneCount; ++i)
+    {
+        std::vector<aiNode*>    children;
+        for (int child = i * 4 + 1; child <= i * 4 + 4 && child < boneCount; ++child)
+            children.push_back(nodes[child]);
+        nodes[i]->mNumChildren = static_cast<unsigned int>(children.size());
+        nodes[i]->mChildren = children.empty() ? nullptr : new aiNode*[children.size()];
+        for (size_t c = 0; c < children.size(); ++c)
+        {
+            nodes[i]->mChildren[c] = children[c];
+            children[c]->mParent = nodes[i];
+        }
+    }
+
+    aiAnimation animation;
+    animation.mDuration = keyCount - 1;
+    animation.mTicksPerSecond = 30.0;
+    animation.mNumChannels = boneCount;
+    animation.mChannels = new aiNodeAnim*[boneCount];
+    for (int i = 0; i < boneCount; ++i)
+    {
+        aiNodeAnim* channel = new aiNodeAnim();
+        channel->mNodeName = nodes[i]->mName;
+        channel->mNumPositionKeys = keyCount;
+        channel->mNumRotationKeys = keyCount;
+        channel->mNumScalingKeys = keyCount;
+        channel->mPositionKeys = new aiVectorKey[keyCount];
+        channel->mRotationKeys = new aiQuatKey[keyCount];
+        channel->mScalingKeys = new aiVectorKey[keyCount];
+        for (int key = 0; key < keyCount; ++key)
+        {
+            float   phase = static_cast<float>(key + i) * 0.1f;
+            channel->mPositionKeys[key] = aiVectorKey(key, aiVector3D(0.0f, 1.0f + 0.01f * std::sin(phase), 0.0f));
+            channel->mRotationKeys[key] = aiQuatKey(key, aiQuaternion(aiVector3D(0.0f, 0.0f, 1.0f), 0.2f * std::sin(phase)));
+            channel->mScalingKeys[key] = aiVectorKey(key, aiVector3D(1.0f, 1.0f, 1.0f));
+        }
+        animation.mChannels[i] = channel;
+    }
+
+    std::unique_ptr<Rig>    rig = std::unique_ptr<Rig>(new Rig());
+    rig->name = "synthetic";
+    rig->clip = std::unique_ptr<Animation>(new Animation(&animation, nodes[0]));
+
+    std::map<std::string, BoneInfo> boneInfoMap;
+    for (int i = 0; i < boneCount; ++i)
+        boneInfoMap[nodes[i]->mName.C_Str()] = BoneInfo { i, glm::mat4(1.0f) };
+    rig->remap = rig->clip->BuildRemap(boneInfoMap);
+    delete nodes[0];
+    return (rig);
+};
+
+// 리그의 bone 정보만 Assimp 로 읽는다. (AniModel 처럼 텍스처나 GL 버퍼는 만들지 않는다)
+std::unique_ptr<Rig>    LoadRig(const std::string& rigPath, const std::string& clipPath)
+{
+    Assimp::Importer    importer;
+    const aiScene*      scene = importer.ReadFile(rigPath, 0);
+    if (!scene || !scene->mRootNode)
+        throw std::string("Error: Failed to load rig: ") + rigPath;
+
+    std::map<std::string, BoneInfo> boneInfoMap;
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m)
+    {
+        for (unsigned int b = 0; b < scene->mMeshes[m]->mNumBones; ++b)
+        {
+            const aiBone*   bone = scene->mMeshes[m]->mBones[b];
+            if (boneInfoMap.find(bone->mName.C_Str()) != boneInfoMap.end())
+                continue ;
+            int id = static_cast<int>(boneInfoMap.size());
+            boneInfoMap[bone->mName.C_Str()] = BoneInfo { id, AssimpGLMHelpers::ConvertMatrixToGLMFormat(bone->mOffsetMatrix) };
+        }
+    }
+
+    std::unique_ptr<Rig>    rig = std::unique_ptr<Rig>(new Rig());
+    rig->name = std::filesystem::path(clipPath).filename().string();
+    rig->clip = std::unique_ptr<Animation>(new Animation(clipPath));
+    rig->remap = rig->clip->BuildRemap(boneInfoMap);
+    return (rig);
+};
+
+Result  Run(const Rig& rig, int animatorCount, int frameCount, int threadCount)
+{
+    const float             dt = 1.0f / 60.0f;
+    std::vector<Animator>   animators(animatorCount, Animator(rig.clip.get(), &rig.remap));
+    for (int i = 0; i < animatorCount; ++i)
+        animators[i].UpdateAnimation(dt * (i % 60));
+
+    std::atomic<size_t> allocated { 0 };
+    auto    worker = [&](int begin, int end)
+    {
+        size_t  before = t_allocations;
+        for (int frame = 0; frame < frameCount; ++frame)
+            for (int i = begin; i < end; ++i)
+                animators[i].UpdateAnimation(dt);
+        allocated += t_allocations - before;
+    };
+
+    auto    start = std::chrono::steady_clock::now();
+    if (threadCount <= 1)
+        worker(0, animatorCount);
+    else
+    {
+        std::vector<std::thread>    threads;
+        int                         chunk = (animatorCount + threadCount - 1) / threadCount;
+        for (int t = 0; t < threadCount; ++t)
+            threads.emplace_back(worker, std::min(t * chunk, animatorCount), std::min((t + 1) * chunk, animatorCount));
+        for (auto& thread : threads)
+            thread.join();
+    }
+    auto    end = std::chrono::steady_clock::now();
+
+    double  ns = std::chrono::duration<double, std::nano>(end - start).count();
+    double  bones = static_cast<double>(frameCount) * animatorCount * rig.clip->GetNodes().size();
+    Result  result;
+    result.nsPerBone = ns / bones;
+    result.allocationsPerFrame = static_cast<double>(allocated.load()) / frameCount;
+    result.msPerFrame = ns / frameCount / 1.0e6;
+    return (result);
+};
+
+int     FrameCountFor(int animatorCount, bool quick)
+{
+    int budget = quick ? 2000 : 20000;
+    return (std::max(3, std::min(200, budget / animatorCount)));
+};
+
+void    PrintHeader(const std::string& title)
+{
+    std::cout << "\n== " << title << "\n"
+            << std::setw(10) << "bones" << std::setw(10) << "keys" << std::setw(10) << "animators"
+            << std::setw(10) << "threads" << std::setw(14) << "ns/bone" << std::setw(14) << "alloc/frame"
+            << std::setw(14) << "ms/frame" << std::setw(10) << "speedup" << std::endl;
+};
+
+void    PrintRow(const Rig& rig, int animators, int threads, const Result& result, double baseline)
+{
+    size_t  keys = rig.clip->GetBones().empty() ? 0 : rig.clip->GetBones().front().GetRotationKeys().size();
+    std::cout << std::fixed << std::setprecision(2)
+            << std::setw(10) << rig.clip->GetNodes().size() << std::setw(10) << keys
+            << std::setw(10) << animators << std::setw(10) << threads
+            << std::setw(14) << result.nsPerBone << std::setw(14) << result.allocationsPerFrame
+            << std::setw(14) << result.msPerFrame << std::setw(10) << baseline / result.msPerFrame << std::endl;
+};
+
+// size x size 격자를 quad 면, 상대 인덱스 없이 쓴다. 재질은 행마다 번갈아 두 개
+std::string CreateSyntheticObj(int size)
+{
+    std::filesystem::path   path = std::filesystem::temp_directory_path() / ("bench_grid_" + std::to_string(size) + ".obj");
+    std::ofstream           file(path);
+    file << std::fixed << std::setprecision(6);
+    for (int y = 0; y <= size; ++y)
+        for (int x = 0; x <= size; ++x)
+        {
+            float   u = static_cast<float>(x) / size, v = static_cast<float>(y) / size;
+            file << "v " << u * 10.0f - 5.0f << " " << std::sin(u * 6.28f) * std::cos(v * 6.28f) << " " << v * 10.0f - 5.0f << "\n"
+                << "vt " << u << " " << v << "\n"
+                << "vn 0.000000 1.000000 0.000000\n";
+        }
+    for (int y = 0; y < size; ++y)
+    {
+        file << "usemtl grid_" << (y & 1) << "\n";
+        for (int x = 0; x < size; ++x)
+        {
+            int a = y * (size + 1) + x + 1, b = a + 1, c = a + size + 2, d = a + size + 1;
+            file << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " "
+                << c << "/" << c << "/" << c << " " << d << "/" << d << "/" << d << "\n";
+        }
+    }
+    return (path.string());
+};
+
+// 삼각형 하나의 세 꼭짓점 (위치, UV, 노멀). 순서와 나뉜 메쉬가 달라도 비교할 수 있게 정렬해 둔다.
+using   ObjTriangle = std::array<float, 24>;
+
+// 감긴 방향은 두고 가장 작은 꼭짓점이 앞에 오도록 돌린다. 정렬 키는 1e-4 로 반올림해서 파서 사이의 마지막 자리 차이를 없앤다.
+void    AddTriangle(const std::array<const float*, 3>& corners, std::vector<ObjTriangle>& triangles)
+{
+    auto    key = [](const float* corner)
+    {
+        std::array<float, 8>    rounded;
+        for (int i = 0; i < 8; ++i)
+            rounded[i] = std::round(corner[i] * 1e4f);
+        return (rounded);
+    };
+    int first = 0;
+    for (int i = 1; i < 3; ++i)
+        if (key(corners[i]) < key(corners[first]))
+            first = i;
+    ObjTriangle triangle;
+    for (int i = 0; i < 3; ++i)
+        std::copy(corners[(first + i) % 3], corners[(first + i) % 3] + 8, triangle.begin() + i * 8);
+    triangles.push_back(triangle);
+};
+
+void    SortTriangles(std::vector<ObjTriangle>& triangles)
+{
+    std::sort(triangles.begin(), triangles.end(), [](const ObjTriangle& a, const ObjTriangle& b)
+    {
+        for (int i = 0; i < 24; ++i)
+        {
+            float   x = std::round(a[i] * 1e4f), y = std::round(b[i] * 1e4f);
+            if (x != y)
+                return (x < y);
+        }
+        return (false);
+    });
+};
+
+std::vector<ObjTriangle>    CollectTriangles(const std::vector<MeshData>& meshData)
+{
+    std::vector<ObjTriangle>    triangles;
+    for (const auto& data : meshData)
+        for (size_t i = 0; i + 2 < data.indices.size(); i += 3)
+        {
+            std::array<std::array<float, 8>, 3> corners;
+            for (int c = 0; c < 3; ++c)
+            {
+                const mVertex&  vertex = data.vertices[data.indices[i + c]];
+                corners[c] = { vertex.position.x, vertex.position.y, vertex.position.z, vertex.texCoords.x,
+                            vertex.texCoords.y, vertex.normal.x, vertex.normal.y, vertex.normal.z };
+            }
+            AddTriangle({ corners[0].data(), corners[1].data(), corners[2].data() }, triangles);
+        }
+    SortTriangles(triangles);
+    return (triangles);
+};
+
+// Model::convertMesh 와 같이 노멀 / UV 가 없으면 0 으로 본다.
+std::vector<ObjTriangle>    CollectTriangles(const aiScene* scene)
+{
+    std::vector<ObjTriangle>    triangles;
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m)
+    {
+        const aiMesh*   mesh = scene->mMeshes[m];
+        for (unsigned int f = 0; f < mesh->mNumFaces; ++f)
+        {
+            if (mesh->mFaces[f].mNumIndices != 3)
+                continue ;
+            std::array<std::array<float, 8>, 3> corners {};
+            for (int c = 0; c < 3; ++c)
+            {
+                unsigned int    index = mesh->mFaces[f].mIndices[c];
+                corners[c][0] = mesh->mVertices[index].x;
+                corners[c][1] = mesh->mVertices[index].y;
+                corners[c][2] = mesh->mVertices[index].z;
+                if (mesh->mTextureCoords[0])
+                {
+                    corners[c][3] = mesh->mTextureCoords[0][index].x;
+                    corners[c][4] = mesh->mTextureCoords[0][index].y;
+                }
+                if (mesh->HasNormals())
+                {
+                    corners[c][5] = mesh->mNormals[index].x;
+                    corners[c][6] = mesh->mNormals[index].y;
+                    corners[c][7] = mesh->mNormals[index].z;
+                }
+            }
+            AddTriangle({ corners[0].data(), corners[1].data(), corners[2].data() }, triangles);
+        }
+    }
+    SortTriangles(triangles);
+    return (triangles);
+};
+
+bool    MatchTriangles(const std::vector<ObjTriangle>& a, const std::vector<ObjTriangle>& b)
+{
+    if (a.size() != b.size())
+        return (false);
+    for (size_t i = 0; i < a.size(); ++i)
+        for (int j = 0; j < 24; ++j)
+            if (std::fabs(a[i][j] - b[i][j]) > 1e-4f)
+                return (false);
+    return (true);
+};
+
+// 같은 파일을 ObjLoader 와 Assimp (Model 과 같은 후처리) 로 읽어 MB/s 를 재고,
+// 삼각형마다 위치 / UV / 노멀이 같은지 비교한다. 탄젠트는 둘 다 TangentSpace 가 만드므로 보지 않는다.
+void    BenchmarkObj(const std::string& path, bool quick)
+{
+    // Model::prepare 와 같은 플래그. 탄젠트는 Model 도 Assimp 대신 TangentSpace 로 만든다.
+    const unsigned int  importFlags = aiProcess_Triangulate | aiProcess_FlipUVs;
+    const int           repeats = quick ? 1 : 5;
+    double              megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+    double              objSeconds = 1e30, assimpSeconds = 1e30;
+    std::vector<ObjTriangle>    objTriangles, assimpTriangles;
+    for (int i = 0; i < repeats; ++i)
+    {
+        auto    start = std::chrono::steady_clock::now();
+        std::vector<MeshData>   meshData = ObjLoader::Load(path);
+        objSeconds = std::min(objSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if (i + 1 == repeats)
+            objTriangles = CollectTriangles(meshData);
+    }
+    for (int i = 0; i < repeats; ++i)
+    {
+        Assimp::Importer    importer;
+        auto                start = std::chrono::steady_clock::now();
+        const aiScene*      scene = importer.ReadFile(path, importFlags);
+        assimpSeconds = std::min(assimpSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if (!scene)
+            throw std::string("Error: Failed to load OBJ: ") + path;
+        if (i + 1 == repeats)
+            assimpTriangles = CollectTriangles(scene);
+    }
+    std::cout << "\n== obj: " << std::filesystem::path(path).filename().string() << "\n"
+            << std::setw(10) << "MB" << std::setw(14) << "ObjLoader" << std::setw(14) << "Assimp"
+            << std::setw(10) << "speedup" << std::setw(14) << "triangles" << std::setw(10) << "match" << "\n"
+            << std::fixed << std::setprecision(2)
+            << std::setw(10) << megabytes << std::setw(10) << megabytes / objSeconds << "MB/s"
+            << std::setw(10) << megabytes / assimpSeconds << "MB/s" << std::setw(10) << assimpSeconds / objSeconds
+            << std::setw(14) << objTriangles.size()
+            << std::setw(10) << (MatchTriangles(objTriangles, assimpTriangles) ? "yes" : "NO")
+            << std::endl;
+};
+
+// ObjLoader 결과에 탄젠트를 다시 만들어 삼각형 처리량을 잰다. 반복마다 결과가 비트 단위로 같은지도 본다.
+void    BenchmarkTangents(const std::string& path, bool quick)
+{
+    const int               repeats = quick ? 1 : 5;
+    std::vector<MeshData>   meshData = ObjLoader::Load(path);
+    std::vector<mVertex>    reference;
+    size_t                  triangles = 0;
+    double                  seconds = 1e30;
+    bool                    deterministic = true;
+    for (const auto& data : meshData)
+        triangles += data.indices.size() / 3;
+    for (int i = 0; i < repeats + 1; ++i)
+    {
+        auto    start = std::chrono::steady_clock::now();
+        for (auto& data : meshData)
+            TangentSpace::GenerateTangents(data);
+        seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        std::vector<mVertex>    vertices;
+        for (const auto& data : meshData)
+            vertices.insert(vertices.end(), data.vertices.begin(), data.vertices.end());
+        if (i == 0)
+            reference.swap(vertices);
+        else
+            deterministic = deterministic
+                            && std::memcmp(reference.data(), vertices.data(), vertices.size() * sizeof(mVertex)) == 0;
+    }
+    std::cout << std::setw(10) << "tangents" << std::setw(10) << seconds * 1000.0 << "ms"
+            << std::setw(10) << triangles / seconds / 1e6 << "Mtri/s" << std::setw(14) << triangles
+            << std::setw(10) << (deterministic ? "yes" : "NO") << std::endl;
+};
+
+// 합성 이미지를 형식마다 mip 사슬까지 쿠킹한다. ratio 는 RGBA8 + glGenerateMipmap 으로 올렸을 때와 비교한 VRAM 비율
+void    BenchmarkTextureCook(bool quick)
+{
+    const int   size = quick ? 512 : 2048;
+    const int   repeats = quick ? 1 : 3;
+    const std::vector<std::pair<int, GLenum>>   formats = {
+        { 1, TextureCooker::BC4 }, { 2, TextureCooker::BC5 }, { 3, TextureCooker::BC1 },
+        { 4, TextureCooker::BC3 }, { 4, TextureCooker::BC7 } };
+    std::cout << "\n== texture cook: " << size << "x" << size << "\n"
+            << std::setw(10) << "channels" << std::setw(10) << "format" << std::setw(14) << "ms"
+            << std::setw(14) << "Mpix/s" << std::setw(14) << "bytes" << std::setw(10) << "ratio" << std::endl;
+    for (const auto& format : formats)
+    {
+        DecodedImage    image;
+        image.width = size;
+        image.height = size;
+        image.channels = format.first;
+        image.pixels.reset(static_cast<unsigned char*>(std::malloc(static_cast<size_t>(size) * size * format.first)));
+        for (int y = 0; y < size; ++y)
+            for (int x = 0; x < size; ++x)
+                for (int c = 0; c < format.first; ++c)
+                    image.pixels.get()[(static_cast<size_t>(y) * size + x) * format.first + c] = static_cast<unsigned char>(
+                        127.5f + 127.0f * std::sin(x * 0.02f * (c + 1)) * std::cos(y * 0.03f) + ((x ^ y) & 15));
+
+        double  seconds = 1e30;
+        size_t  bytes = 0;
+        for (int i = 0; i < repeats; ++i)
+        {
+            auto    start = std::chrono::steady_clock::now();
+            std::shared_ptr<CookedTexture>  cooked = TextureCooker::Cook(image, format.second);
+            seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            bytes = cooked->GetByteSize();
+        }
+        double  uncompressed = static_cast<double>(size) * size * 4 * 4 / 3;
+        std::cout << std::setw(10) << format.first << std::setw(10) << std::hex << format.second << std::dec
+                << std::setw(14) << seconds * 1000.0 << std::setw(14) << size * size / seconds / 1e6
+                << std::setw(14) << bytes << std::setw(10) << bytes / uncompressed << std::endl;
+    }
+};
+
+int     main_process(int argc, char** argv)
+{
+    bool                        quick = false;
+    std::vector<std::string>    paths, objPaths;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--quick")
+            quick = true;
+        else if (ObjLoader::CanLoad(argv[i]))
+            objPaths.push_back(argv[i]);
+        else
+            paths.push_back(argv[i]);
+    }
+    if (paths.empty() && std::filesystem::exists("./image/vampire/dancing_vampire.dae"))
+        paths.push_back("./image/vampire/dancing_vampire.dae");
+
+    const std::vector<int>  animatorCounts = { 1, 10, 100, 1000, 10000 };
+    const std::vector<int>  boneCounts = { 16, 64, 128 };
+    const std::vector<int>  keyCounts = { 30, 300, 3000 };
+    int                     hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    PrintHeader("synthetic rigs: bone count x clip length x animators");
+    for (int bones : boneCounts)
+        for (int keys : keyCounts)
+        {
+            std::unique_ptr<Rig>    rig = CreateSyntheticRig(bones, keys);
+            for (int animators : animatorCounts)
+            {
+                int     frames = FrameCountFor(animators, quick);
+                Result  result = Run(*rig, animators, frames, 1);
+                PrintRow(*rig, animators, 1, result, result.msPerFrame);
+            }
+        }
+
+    // 첫 번째 인자는 리그, 나머지는 그 리그의 클립. 인자가 하나면 리그 파일의 클립을 쓴다.
+    std::vector<std::unique_ptr<Rig>>   rigs;
+    for (size_t i = (paths.size() > 1 ? 1 : 0); i < paths.size(); ++i)
+        rigs.push_back(LoadRig(paths[0], paths[i]));
+    for (auto& rig : rigs)
+    {
+        PrintHeader("rig: " + rig->name);
+        for (int animators : animatorCounts)
+        {
+            Result  result = Run(*rig, animators, FrameCountFor(animators, quick), 1);
+            PrintRow(*rig, animators, 1, result, result.msPerFrame);
+        }
+    }
+
+    std::unique_ptr<Rig>    scalingRig = rigs.empty() ? CreateSyntheticRig(64, 300) : std::move(rigs.front());
+    int                     scalingAnimators = 10000;
+    int                     frames = FrameCountFor(scalingAnimators, quick);
+    PrintHeader("thread scaling: " + scalingRig->name);
+    double  baseline = 0.0;
+    for (int threads = 1; threads <= hardwareThreads; threads *= 2)
+    {
+        Result  result = Run(*scalingRig, scalingAnimators, frames, threads);
+        if (threads == 1)
+            baseline = result.msPerFrame;
+        PrintRow(*scalingRig, scalingAnimators, threads, result, baseline);
+    }
+
+    if (objPaths.empty() && std::filesystem::exists("./image/backpack/backpack.obj"))
+        objPaths.push_back("./image/backpack/backpack.obj");
+    // 합성 격자는 512 면 약 45MB 다. 재고 나면 지운다.
+    std::string syntheticObj = CreateSyntheticObj(quick ? 256 : 512);
+    objPaths.push_back(syntheticObj);
+    for (const auto& path : objPaths)
+    {
+        BenchmarkObj(path, quick);
+        BenchmarkTangents(path, quick);
+    }
+    std::error_code error;
+    std::filesystem::remove(syntheticObj, error);
+    BenchmarkTextureCook(quick);
+    return (0);
+};
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return main_process(argc, argv);
+    }
+    catch(const string& err)
+    {
+        std::cerr << err << '\n';
+        return -1;
+    }
+};
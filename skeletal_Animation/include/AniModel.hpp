@@ -4,117 +4,406 @@
 #include "Common.hpp"
 #include "Program.hpp"
 #include "Mesh.hpp"
+#include "MeshCache.hpp"
+#include "ModelUpload.hpp"
+#include "MeshOptimizer.hpp"
+#include "GlbLoader.hpp"
+#include "TangentSpace.hpp"
 #include "AssimpGLMHelpers.hpp"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-unsigned int    TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
-
-struct  BoneInfo
-{
-    int         id;
-    glm::mat4   offset;
-};
-
 class AniModel
 {
 public:
-    static std::unique_ptr<AniModel>   LoadModel(const std::string& path);
-
-    ~AniModel() {};
+    static std::unique_ptr<AniModel>   LoadModel(const std::string& path, float weldEpsilon = 0.0f,
+                                            bool packBuffers = true, bool keepCollision = false);
+    static std::unique_ptr<AniModel>   LoadModelAsync(const std::string& path, float weldEpsilon = 0.0f,
+                                            bool packBuffers = true, bool keepCollision = false);
+
+    ~AniModel();
+    bool    Update(UploadBudget& budget);
+    bool    IsReady(void) const { return (this->ready); };
     void    draw(Program* program);
+    void    draw(Program* program, const glm::mat4& model, const glm::vec3& cameraPos,
+                float fovy = 45.0f, float viewportHeight = height);
+    void    drawInstanced(Program* program, GLsizei instanceCount);
+    void    drawInstanced(Program* program, GLsizei instanceCount, const glm::mat4& model, const glm::vec3& cameraPos,
+                        float fovy = 45.0f, float viewportHeight = height);
 
+    // 비동기 로딩이면 IsReady 가 true 가 된 뒤에만 채워져 있다.
     auto&   GetBoneInfoMap(void) { return (this->boneInfoMap); };
     int&    GetBoneCount(void) { return (this->boneCount); };
 
 private:
-    std::vector<mTexture>   textures_loaded;
+    std::unordered_map<std::string, mTexture>   textures_loaded;
     std::vector<Mesh>   meshes;
     std::string         directory;
+    bool                packBuffers { true };
+    bool                keepCollision { false };
+    std::unique_ptr<ModelBuffer>    buffer;
+    std::unique_ptr<TextureBatch>   textureBatch;
+    std::unique_ptr<PendingModel>   pending;
+    std::future<void>               loading;
+    bool                            ready { false };
 
     std::map<std::string, BoneInfo> boneInfoMap;
     int                             boneCount{ 0 };
 
+    // 큰 메쉬의 정점 / 면 변환을 나누는 단위
+    static constexpr size_t CONVERT_GRAIN = 16384;
+
     AniModel() {};
-    void    init(const std::string& path);
-    void    processNode(aiNode* node, const aiScene* scene);
-    Mesh    processMesh(aiMesh* mesh, const aiScene* scene);
+    void    init(const std::string& path, float weldEpsilon);
+    void    prepare(const std::string& path, float weldEpsilon);
+    bool    upload(UploadBudget& budget);
+    void    loadCache(std::unique_ptr<MeshCache> cache);
+    void    importScene(const std::string& path, unsigned int importFlags, std::vector<MeshData>& meshData);
+    void    loadGlb(std::vector<MeshData>& meshData);
+    void    processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sourceMeshes);
+    void    convertMeshes(const std::vector<aiMesh*>& sourceMeshes, const aiScene* scene, std::vector<MeshData>& meshData);
+    void    convertMesh(const aiMesh* mesh, MeshData& data);
+    std::vector<mTexture>   loadMeshTextures(const aiMesh* mesh, const aiScene* scene);
     std::vector<mTexture>   loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
+    mTexture    loadTexture(const std::string& path, const std::string& typeName);
+    void        uploadTextures(std::vector<MeshData>& meshData);
+    bool        createMeshes(PendingModel& pending, UploadBudget& budget);
 
     void    SetVertexBoneDataDefault(mVertex& vertex);
     void    SetVertexBoneData(mVertex& vertex, int boneID, float weight);
-    void    ExtractBoneWeightForVertices(std::vector<mVertex>& vertices, aiMesh* mesh, const aiScene* scene);
+    void    RegisterBones(const aiMesh* mesh);
+    void    ExtractBoneWeightForVertices(std::vector<mVertex>& vertices, const aiMesh* mesh);
 };
 
-std::unique_ptr<AniModel>   AniModel::LoadModel(const std::string& path)
+std::unique_ptr<AniModel>   AniModel::LoadModel(const std::string& path, float weldEpsilon, bool packBuffers,
+                                        bool keepCollision)
 {
     std::unique_ptr<AniModel>  model = std::unique_ptr<AniModel>(new AniModel());
-    model->init(path);
+    model->packBuffers = packBuffers;
+    model->keepCollision = keepCollision;
+    model->init(path, weldEpsilon);
     return (std::move(model));
 };
 
+// 파싱과 변환은 작업자 스레드에서 돌리고 바로 돌아온다. GL 업로드는 Update 가 프레임마다 나눠서 한다.
+std::unique_ptr<AniModel>   AniModel::LoadModelAsync(const std::string& path, float weldEpsilon, bool packBuffers,
+                                            bool keepCollision)
+{
+    std::unique_ptr<AniModel>  model = std::unique_ptr<AniModel>(new AniModel());
+    model->packBuffers = packBuffers;
+    model->keepCollision = keepCollision;
+    AniModel*  target = model.get();
+    model->loading = ThreadPool::Get().Submit([target, path, weldEpsilon]() { target->prepare(path, weldEpsilon); });
+    return (std::move(model));
+};
+
+AniModel::~AniModel()
+{
+    if (this->loading.valid())
+        this->loading.wait();
+};
+
+// 컨텍스트 스레드에서 매 프레임 부른다. 준비가 끝났으면 budget 안에서 텍스처, 메쉬 순서로 올린다.
+bool    AniModel::Update(UploadBudget& budget)
+{
+    if (this->ready)
+        return (true);
+    if (this->loading.valid())
+    {
+        if (this->loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return (false);
+        // 작업자 스레드에서 던진 오류를 여기서 다시 던진다.
+        this->loading.get();
+    }
+    return (upload(budget));
+};
+
 void    AniModel::draw(Program* program)
 {
+    if (!this->ready)
+    {
+        ModelPlaceholder::Draw(program);
+        return ;
+    }
+    Mesh::BeginMaterials(program);
+    if (this->buffer)
+        this->buffer->Bind();
     for (auto& mesh : this->meshes)
-        mesh.Draw(program);
+        mesh.Draw();
+    if (this->buffer)
+        glBindVertexArray(0);
+};
+
+// 메쉬가 화면에서 차지하는 크기를 텍스처 스트리머에 남기고 그린다. 스키닝 전 (바인드 포즈) 의 구로 잰다.
+void    AniModel::draw(Program* program, const glm::mat4& model, const glm::vec3& cameraPos,
+                    float fovy, float viewportHeight)
+{
+    if (this->ready)
+        for (const auto& mesh : this->meshes)
+            mesh.RequestTextureDetail(model, cameraPos, fovy, viewportHeight);
+    draw(program);
 };
 
-void    AniModel::init(const std::string& path)
+void    AniModel::drawInstanced(Program* program, GLsizei instanceCount)
+{
+    if (!this->ready)
+    {
+        ModelPlaceholder::Draw(program, instanceCount);
+        return ;
+    }
+    Mesh::BeginMaterials(program);
+    if (this->buffer)
+        this->buffer->Bind();
+    for (auto& mesh : this->meshes)
+        mesh.DrawInstanced(instanceCount);
+    if (this->buffer)
+        glBindVertexArray(0);
+};
+
+// model 은 카메라에 가장 가까운 인스턴스의 변환이다. 가장 자세한 레벨이 필요한 인스턴스 기준으로 요청한다.
+void    AniModel::drawInstanced(Program* program, GLsizei instanceCount, const glm::mat4& model,
+                            const glm::vec3& cameraPos, float fovy, float viewportHeight)
+{
+    if (this->ready)
+        for (const auto& mesh : this->meshes)
+            mesh.RequestTextureDetail(model, cameraPos, fovy, viewportHeight);
+    drawInstanced(program, instanceCount);
+};
+
+// 동기 로딩. 텍스처 디코딩을 기다린 뒤 예산 제한 없이 한 번에 올린다. 큐에 넣은 픽셀도 여기서 다 올린다.
+void    AniModel::init(const std::string& path, float weldEpsilon)
+{
+    UploadBudget    budget;
+    prepare(path, weldEpsilon);
+    uploadTextures(this->pending->meshData);
+    this->pending->texturesUploaded = true;
+    upload(budget);
+    TextureUploader::Get().Flush();
+};
+
+// GL 호출 없이 메쉬 데이터를 만들어 pending 에 둔다. 비동기 로딩에서는 작업자 스레드에서 돈다.
+void    AniModel::prepare(const std::string& path, float weldEpsilon)
+{
+    // 탄젠트는 Assimp 대신 TangentSpace 가 MikkTSpace 규칙으로 만든다.
+    const unsigned int  importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals;
+    // 스키닝으로 정점이 움직이므로 바인드 포즈 기준의 LOD 오차나 meshlet 경계는 만들지 않는다.
+    MeshImportOptions   options;
+    options.weldEpsilon = weldEpsilon;
+
+    this->directory = path.substr(0, path.find_last_of('/'));
+    this->textureBatch = std::unique_ptr<TextureBatch>(new TextureBatch(this->directory, true));
+    this->pending = std::unique_ptr<PendingModel>(new PendingModel());
+    // 캐시에서 읽어도 내장 텍스처는 GLB 에서 디코딩하므로 먼저 연다.
+    if (GlbFile::CanLoad(path))
+        this->pending->glb = GlbFile::Open(path);
+    std::unique_ptr<MeshCache>  cache = MeshCache::Open(path, importFlags, options);
+    if (cache)
+    {
+        loadCache(std::move(cache));
+        return ;
+    }
+
+    std::vector<MeshData>   meshData;
+    if (this->pending->glb)
+        loadGlb(meshData);
+    else
+        importScene(path, importFlags, meshData);
+    // 메쉬끼리는 서로 독립이므로 최적화도 메쉬마다 작업자 스레드에서 돌린다.
+    std::vector<MeshOptimizeReport> reports(meshData.size());
+    ThreadPool::Get().ParallelFor(meshData.size(), 1, [&meshData, &reports, &options](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            reports[i] = MeshOptimizer::Optimize(meshData[i], options);
+    });
+    for (size_t i = 0; i < reports.size(); ++i)
+        MeshOptimizer::PrintReport(path + "[" + std::to_string(i) + "]", reports[i]);
+    MeshOptimizer::PrintWeldSummary(path, reports);
+    if (!MeshCache::Write(path, importFlags, options, meshData, &this->boneInfoMap))
+        std::cout << "Mesh cache failed to write for: " << path << std::endl;
+    for (const auto& data : meshData)
+        this->pending->sources.push_back(MeshSource { data.vertices.data(), data.vertices.size(),
+                                                    data.indices.data(), data.indices.size(), GL_UNSIGNED_INT });
+    this->pending->meshData = std::move(meshData);
+};
+
+// 텍스처를 먼저 다 올리고, 메쉬는 하나씩 올린다. 예산이 떨어지면 false 를 돌려주고 다음 프레임에 이어서 한다.
+bool    AniModel::upload(UploadBudget& budget)
+{
+    PendingModel&   pending = *this->pending;
+    if (!pending.texturesUploaded)
+    {
+        if (!this->textureBatch->UploadReady(budget))
+            return (false);
+        uploadTextures(pending.meshData);
+        pending.texturesUploaded = true;
+    }
+    if (!createMeshes(pending, budget))
+        return (false);
+    this->pending.reset();
+    this->textureBatch.reset();
+    this->ready = true;
+    return (true);
+};
+
+void    AniModel::importScene(const std::string& path, unsigned int importFlags, std::vector<MeshData>& meshData)
 {
     Assimp::Importer    import;
-    const aiScene*  scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
+    const aiScene*  scene = import.ReadFile(path, importFlags);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
         throw (import.GetErrorString());
-    this->directory = path.substr(0, path.find_last_of('/'));
-    processNode(scene->mRootNode, scene);
+    std::vector<aiMesh*>    sourceMeshes;
+    processNode(scene->mRootNode, scene, sourceMeshes);
+    convertMeshes(sourceMeshes, scene, meshData);
 };
 
-void    AniModel::processNode(aiNode* node, const aiScene* scene)
+// skin 의 joint 는 GlbLoader 가 boneInfoMap 에 등록한다. 역바인드 행렬이 곧 bone offset 이다.
+void    AniModel::loadGlb(std::vector<MeshData>& meshData)
 {
-    for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+    meshData = GlbLoader::LoadSkinned(*this->pending->glb, this->boneInfoMap, this->boneCount);
+    for (auto& data : meshData)
+        for (auto& texture : data.textures)
+            texture = loadTexture(texture.path, texture.type);
+};
+
+// 캐시의 정점/인덱스는 맵핑된 그대로 GPU 에 올린다. (Assimp 파싱, 정점 변환 없음)
+void    AniModel::loadCache(std::unique_ptr<MeshCache> cache)
+{
+    this->boneInfoMap = cache->GetBoneInfoMap();
+    this->boneCount = static_cast<int>(this->boneInfoMap.size());
+    std::vector<MeshData>&      meshData = this->pending->meshData;
+    std::vector<MeshSource>&    sources = this->pending->sources;
+    meshData.resize(cache->GetMeshCount());
+    for (size_t i = 0; i < cache->GetMeshCount(); ++i)
     {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        meshData[i].textures = cache->GetTextures(i);
+        for (auto& texture : meshData[i].textures)
+            texture = loadTexture(texture.path, texture.type);
+        meshData[i].lods = cache->GetLods(i);
+        meshData[i].bounds = cache->GetBounds(i);
+        meshData[i].meshlets = cache->GetMeshlets(i);
+        sources.push_back(MeshSource { cache->GetVertices(i), cache->GetVertexCount(i),
+                                    cache->GetIndices(i), cache->GetIndexCount(i), cache->GetIndexType(i) });
     }
+    this->pending->cache = std::move(cache);
+};
+
+// 공용 버퍼 모드면 모든 메쉬를 한 VBO/EBO 에 이어 붙이고, 아니면 메쉬마다 따로 만든다.
+// 올린 메쉬의 CPU 쪽 정점/인덱스는 바로 해제하고, keepCollision 이면 LOD0 의 위치와 인덱스만 남긴다.
+bool    AniModel::createMeshes(PendingModel& pending, UploadBudget& budget)
+{
+    if (this->packBuffers && !this->buffer)
+        this->buffer = ModelBuffer::Create(pending.sources);
+    this->meshes.reserve(pending.sources.size());
+    for (; pending.nextMesh < pending.sources.size(); ++pending.nextMesh)
+    {
+        if (budget.IsSpent())
+            return (false);
+        const MeshSource&   source = pending.sources[pending.nextMesh];
+        MeshData&           data = pending.meshData[pending.nextMesh];
+        if (this->buffer)
+        {
+            MeshRange   range = this->buffer->Append(source.vertices, source.vertexCount, source.indices,
+                                                    source.indexCount, source.indexType);
+            this->meshes.emplace_back(this->buffer->GetVAO(), this->buffer->GetDepthVAO(), this->buffer->GetIndexType(),
+                                    range, source.indexCount, std::move(data.textures));
+        }
+        else
+            this->meshes.emplace_back(source.vertices, source.vertexCount, source.indices, source.indexCount,
+                                    source.indexType, std::move(data.textures));
+        Mesh&   mesh = this->meshes.back();
+        mesh.SetLods(data.lods, data.bounds);
+        mesh.SetMeshlets(std::move(data.meshlets));
+        if (this->keepCollision)
+            mesh.SetCollision(Mesh::MakeCollision(source.vertices, source.vertexCount, source.indices,
+                                                data.lods.empty() ? source.indexCount : data.lods[0].indexCount,
+                                                source.indexType));
+        budget.Consume(source.GetByteSize());
+        std::vector<mVertex>().swap(data.vertices);
+        std::vector<GLuint>().swap(data.indices);
+    }
+    return (true);
+};
+
+void    AniModel::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sourceMeshes)
+{
+    for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+        sourceMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
     for (unsigned int i = 0; i < node->mNumChildren; ++i)
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, sourceMeshes);
 };
 
-Mesh    AniModel::processMesh(aiMesh* mesh, const aiScene* scene)
+// bone ID 는 메쉬 순서대로 매겨야 캐시와 애니메이션이 같은 번호를 보므로 여기서 먼저 차례로 등록한다.
+// 텍스처 목록도 모델의 공용 상태를 건드리므로 차례로 만들고, 정점 변환과 가중치만 작업자 스레드에서 돌린다.
+void    AniModel::convertMeshes(const std::vector<aiMesh*>& sourceMeshes, const aiScene* scene,
+                                std::vector<MeshData>& meshData)
 {
-    std::vector<mVertex>    vertices;
-    std::vector<GLuint>     indices;
-    std::vector<mTexture>   textures;
+    meshData.resize(sourceMeshes.size());
+    for (size_t i = 0; i < sourceMeshes.size(); ++i)
+    {
+        RegisterBones(sourceMeshes[i]);
+        meshData[i].textures = loadMeshTextures(sourceMeshes[i], scene);
+    }
+    ThreadPool::Get().ParallelFor(sourceMeshes.size(), 1, [this, &sourceMeshes, &meshData](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            convertMesh(sourceMeshes[i], meshData[i]);
+    });
+};
 
-    for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+// 출력 버퍼를 먼저 다 잡아 두고 구간마다 제자리에 쓴다. bone 가중치는 한 정점에 여러 bone 이 쓰므로 메쉬 단위로 한다.
+void    AniModel::convertMesh(const aiMesh* mesh, MeshData& data)
+{
+    data.vertices.resize(mesh->mNumVertices);
+    ThreadPool::Get().ParallelFor(mesh->mNumVertices, CONVERT_GRAIN, [this, mesh, &data](size_t begin, size_t end)
     {
-        mVertex vertex;
+        for (size_t i = begin; i < end; ++i)
+        {
+            mVertex&    vertex = data.vertices[i];
 
-        this->SetVertexBoneDataDefault(vertex);
+            this->SetVertexBoneDataDefault(vertex);
 
-        vertex.position = AssimpGLMHelpers::GetGLMVec(mesh->mVertices[i]);
-        vertex.normal = AssimpGLMHelpers::GetGLMVec(mesh->mNormals[i]);
+            vertex.position = AssimpGLMHelpers::GetGLMVec(mesh->mVertices[i]);
+            vertex.normal = AssimpGLMHelpers::GetGLMVec(mesh->mNormals[i]);
 
-        if(mesh->mTextureCoords[0])
-        {
-            glm::vec2   vec;
-            vec.x = mesh->mTextureCoords[0][i].x; 
-            vec.y = mesh->mTextureCoords[0][i].y;
-            vertex.texCoords = vec;
-            vertex.tangent = AssimpGLMHelpers::GetGLMVec(mesh->mTangents[0]);
+            vertex.tangent = glm::vec4(0.0f);
+            if(mesh->mTextureCoords[0])
+            {
+                glm::vec2   vec;
+                vec.x = mesh->mTextureCoords[0][i].x; 
+                vec.y = mesh->mTextureCoords[0][i].y;
+                vertex.texCoords = vec;
+            }
+            else
+                vertex.texCoords = glm::vec2(0.0f, 0.0f);
         }
-        else
-            vertex.texCoords = glm::vec2(0.0f, 0.0f);
-        vertices.push_back(vertex);
+    });
+
+    // 삼각형만 있으면 면 i 의 인덱스 위치가 3 * i 로 정해진다. 선이나 점이 섞여 있으면 차례로 채운다.
+    if (mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
+    {
+        for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
+            data.indices.insert(data.indices.end(), mesh->mFaces[i].mIndices,
+                                mesh->mFaces[i].mIndices + mesh->mFaces[i].mNumIndices);
     }
-    for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
+    else
     {
-        aiFace  face = mesh->mFaces[i];
-        for (unsigned int j = 0; j < face.mNumIndices; ++j)
-            indices.push_back(face.mIndices[j]);
+        data.indices.resize(static_cast<size_t>(mesh->mNumFaces) * 3);
+        ThreadPool::Get().ParallelFor(mesh->mNumFaces, CONVERT_GRAIN, [mesh, &data](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                std::copy(mesh->mFaces[i].mIndices, mesh->mFaces[i].mIndices + 3, &data.indices[i * 3]);
+        });
+        if (mesh->mTextureCoords[0])
+            TangentSpace::GenerateTangents(data);
     }
+    ExtractBoneWeightForVertices(data.vertices, mesh);
+};
+
+std::vector<mTexture>   AniModel::loadMeshTextures(const aiMesh* mesh, const aiScene* scene)
+{
+    std::vector<mTexture>   textures;
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
     std::vector<mTexture>   diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE,
                                                             "texture_diffuse");
@@ -129,8 +418,7 @@ Mesh    AniModel::processMesh(aiMesh* mesh, const aiScene* scene)
                                                             "texture_height");
 	textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-    ExtractBoneWeightForVertices(vertices, mesh, scene);
-    return (Mesh(vertices, indices, textures));
+    return (textures);
 };
 
 std::vector<mTexture>   AniModel::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
@@ -140,68 +428,56 @@ std::vector<mTexture>   AniModel::loadMaterialTextures(aiMaterial *mat, aiTextur
     {
         aiString    str;
         mat->GetTexture(type, i, &str);
-        bool    skip = false;
-        for (unsigned int j = 0; j < textures_loaded.size(); ++j)
-        {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-            {
-                textures.push_back(textures_loaded[j]);
-                skip = true;
-                break ;
-            }
-        }
-        if (!skip)
-        {
-            mTexture    texture;
-            texture.id = TextureFromFile(str.C_Str(), this->directory);
-            texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture);
-        }
+        textures.push_back(loadTexture(str.C_Str(), typeName));
     }
     return (textures);
 };
 
-unsigned int    TextureFromFile(const char *path, const std::string &directory, bool gamma)
+mTexture    AniModel::loadTexture(const std::string& path, const std::string& typeName)
 {
-    std::string filename = std::string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int    textureID;
-    glGenTextures(1, &textureID);
-
-    stbi_set_flip_vertically_on_load(true);
-    int width, height, nrComponents;
-    unsigned char   *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
+    auto    loaded = this->textures_loaded.find(path);
+    if (loaded != this->textures_loaded.end())
+        return (loaded->second);
+    mTexture    texture;
+    texture.id = 0;
+    texture.type = typeName;
+    texture.path = path;
+    this->textures_loaded[path] = texture;
+    const unsigned char*    data;
+    size_t                  size;
+    if (this->pending && this->pending->glb && this->pending->glb->GetEmbeddedImage(path, data, size))
+        this->textureBatch->Request(path, TextureRole::FromType(typeName), this->pending->glb, data, size);
     else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+        this->textureBatch->Request(path, TextureRole::FromType(typeName));
+    return (texture);
+};
 
-    return (textureID);
+// 디코딩은 loadTexture 에서 이미 시작됐다. 여기서는 기다렸다가 텍스처 배열로 묶어 올리기만 한다.
+void    AniModel::uploadTextures(std::vector<MeshData>& meshData)
+{
+    std::unordered_map<std::string, std::shared_ptr<TextureHandle>> handles = this->textureBatch->UploadAll();
+    std::unordered_map<std::string, TextureLayer>   layers = this->textureBatch->TakeLayers();
+    auto    resolve = [&handles, &layers](mTexture& texture)
+    {
+        auto    layer = layers.find(texture.path);
+        if (layer != layers.end())
+        {
+            texture.array = layer->second.array;
+            texture.layer = layer->second.layer;
+            texture.id = layer->second.array->Get();
+        }
+        auto    handle = handles.find(texture.path);
+        if (handle == handles.end())
+            return ;
+        texture.handle = handle->second;
+        texture.id = handle->second->Get();
+    };
+    for (auto& texture : this->textures_loaded)
+        resolve(texture.second);
+    for (auto& data : meshData)
+        for (auto& texture : data.textures)
+            resolve(texture);
+    this->textureBatch.reset();
 };
 
 void    AniModel::SetVertexBoneDataDefault(mVertex& vertex)
@@ -226,31 +502,36 @@ void    AniModel::SetVertexBoneData(mVertex& vertex, int boneID, float weight)
     }
 };
 
-void    AniModel::ExtractBoneWeightForVertices(std::vector<mVertex>& vertices, aiMesh* mesh, const aiScene* scene)
+void    AniModel::RegisterBones(const aiMesh* mesh)
 {
-    for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+    for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
     {
-        int boneID = -1;
         std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
-        if (this->boneInfoMap.find(boneName) == this->boneInfoMap.end())
-        {
-            BoneInfo    newBoneInfo;
-            newBoneInfo.id = this->boneCount;
-            newBoneInfo.offset = AssimpGLMHelpers::ConvertMatrixToGLMFormat(mesh->mBones[boneIndex]->mOffsetMatrix);
-            this->boneInfoMap[boneName] = newBoneInfo;
-            boneID = this->boneCount;
-            ++this->boneCount;
-        }
-        else
-            boneID = this->boneInfoMap[boneName].id;
-        assert(boneID != -1);
+        if (this->boneInfoMap.find(boneName) != this->boneInfoMap.end())
+            continue ;
+        BoneInfo    newBoneInfo;
+        newBoneInfo.id = this->boneCount;
+        newBoneInfo.offset = AssimpGLMHelpers::ConvertMatrixToGLMFormat(mesh->mBones[boneIndex]->mOffsetMatrix);
+        this->boneInfoMap[boneName] = newBoneInfo;
+        ++this->boneCount;
+    }
+};
+
+// RegisterBones 가 끝난 뒤 작업자 스레드에서 부르므로 boneInfoMap 은 읽기만 한다.
+void    AniModel::ExtractBoneWeightForVertices(std::vector<mVertex>& vertices, const aiMesh* mesh)
+{
+    for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+    {
+        auto    boneInfo = this->boneInfoMap.find(mesh->mBones[boneIndex]->mName.C_Str());
+        assert(boneInfo != this->boneInfoMap.end());
+        int     boneID = boneInfo->second.id;
         auto    weights = mesh->mBones[boneIndex]->mWeights;
         int     numWeights = mesh->mBones[boneIndex]->mNumWeights;
         for (int weightIndex = 0; weightIndex < numWeights; ++weightIndex)
         {
             int     vertexID = weights[weightIndex].mVertexId;
             float   weight = weights[weightIndex].mWeight;
-            assert(vertexID <= vertices.size());
+            assert(static_cast<size_t>(vertexID) < vertices.size());
             SetVertexBoneData(vertices[vertexID], boneID, weight);
         }
     }
@@ -14,29 +14,61 @@ struct AssimpNodeData
     std::vector<AssimpNodeData> children;
 };
 
+// 계층 구조를 부모가 항상 자식보다 앞에 오도록 펼친 것 (GPU 버퍼로 올리기 위함)
+struct AnimationNode
+{
+    std::string name;
+    glm::mat4   transformation;
+    int         parent;
+    int         track;
+};
+
+// 클립의 노드 순서 -> 모델의 bone id / offset. 같은 골격의 클립끼리 공유된다.
+struct BoneRemap
+{
+    std::vector<int>        boneIDs;
+    std::vector<glm::mat4>  offsets;
+    int                     boneCount;
+};
+
 class Animation
 {
 public:
     Animation() = default;
     Animation(const std::string& animationPath, AniModel* model);
+    Animation(const std::string& animationPath);
+    Animation(const aiAnimation* animation, const aiNode* root);
     ~Animation() {};
 
     Bone*   FindBone(const std::string& name);
+    BoneRemap   BuildRemap(const std::map<std::string, BoneInfo>& modelBoneInfoMap) const;
 
     inline float    GetDuration(void) const { return (this->duration); };
     inline float    GetTicksPerSecond(void) const { return (this->ticksPerSecond); };
     inline const AssimpNodeData& GetRootNode(void) const { return (this->rootNode); };
+    inline const std::vector<Bone>&             GetBones(void) const { return (this->bones); };
+    inline const std::vector<AnimationNode>&    GetNodes(void) const { return (this->nodes); };
+    inline uint64_t GetSignature(void) const { return (this->signature); };
     inline const std::map<std::string, BoneInfo>&   GetBoneIDMap(void)
     { return (this->boneInfoMap); };
 private:
     float   duration;
     int     ticksPerSecond;
+    uint64_t            signature { 0 };
     std::vector<Bone>   bones;
     AssimpNodeData      rootNode;
+    std::vector<AnimationNode>      nodes;
     std::map<std::string, BoneInfo> boneInfoMap;
 
     void    ReadMissingBones(const aiAnimation* animation, AniModel& model);
+    void    init(const aiAnimation* animation, const aiNode* root);
+    void    initGlb(const GlbFile& file);
+    void    ReadGlbHeirarchy(const GlbFile& file, AssimpNodeData& dest, int node, int depth);
+    void    ReadGlbTracks(const GlbFile& file, const JsonValue& animation);
+    void    ReadTracks(const aiAnimation* animation);
     void    ReadHeirarchyData(AssimpNodeData& dest, const aiNode* src);
+    void    FlattenHeirarchy(const AssimpNodeData& node, int parent);
+    void    ComputeSignature(void);
 };
 
 Animation::Animation(const std::string& animationPath, AniModel* model)
@@ -52,6 +84,159 @@ Animation::Animation(const std::string& animationPath, AniModel* model)
     // globalTransformation = globalTransformation.Inverse();
     ReadHeirarchyData(this->rootNode, scene->mRootNode);
     ReadMissingBones(animation, *model);
+    FlattenHeirarchy(this->rootNode, -1);
+    ComputeSignature();
+};
+
+// 모델 없이 클립만 읽는다. bone id 는 모델마다 BuildRemap 으로 따로 연결한다.
+Animation::Animation(const std::string& animationPath)
+{
+    if (GlbFile::CanLoad(animationPath))
+    {
+        initGlb(*GlbFile::Open(animationPath));
+        return ;
+    }
+    Assimp::Importer    importer;
+    const aiScene*      scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
+    if (!scene || !scene->mRootNode || scene->mNumAnimations == 0)
+        throw std::string("Error: Failed to load animation: ") + animationPath;
+    init(scene->mAnimations[0], scene->mRootNode);
+};
+
+Animation::Animation(const aiAnimation* animation, const aiNode* root)
+{ init(animation, root); };
+
+void    Animation::init(const aiAnimation* animation, const aiNode* root)
+{
+    this->duration = animation->mDuration;
+    this->ticksPerSecond = animation->mTicksPerSecond;
+    ReadHeirarchyData(this->rootNode, root);
+    ReadTracks(animation);
+    FlattenHeirarchy(this->rootNode, -1);
+    ComputeSignature();
+};
+
+// 첫 번째 애니메이션만 읽는다. Assimp glTF2 importer 처럼 tick 은 밀리초이고,
+// 루트 노드가 여럿이면 이름 "ROOT" 의 단위 변환 노드 아래에 모은다.
+void    Animation::initGlb(const GlbFile& file)
+{
+    const JsonValue&    animation = file.GetJson()["animations"][0];
+    if (!animation.IsObject())
+        throw std::string("Error: GLB has no animation");
+    std::vector<int>    roots = file.GetSceneRoots();
+    if (roots.size() == 1)
+        ReadGlbHeirarchy(file, this->rootNode, roots[0], 0);
+    else
+    {
+        this->rootNode.name = "ROOT";
+        this->rootNode.transformation = glm::mat4(1.0f);
+        this->rootNode.childrenCount = static_cast<int>(roots.size());
+        this->rootNode.children.resize(roots.size());
+        for (size_t i = 0; i < roots.size(); ++i)
+            ReadGlbHeirarchy(file, this->rootNode.children[i], roots[i], 1);
+    }
+    this->ticksPerSecond = 1000;
+    ReadGlbTracks(file, animation);
+    FlattenHeirarchy(this->rootNode, -1);
+    ComputeSignature();
+};
+
+void    Animation::ReadGlbHeirarchy(const GlbFile& file, AssimpNodeData& dest, int node, int depth)
+{
+    const JsonValue&    children = file.GetJson()["nodes"][node]["children"];
+    if (depth > 256)
+        throw std::string("Error: Invalid GLB node hierarchy");
+    dest.name = file.GetNodeName(node);
+    dest.transformation = file.GetLocalTransform(node);
+    dest.childrenCount = static_cast<int>(children.Size());
+    dest.children.resize(children.Size());
+    for (size_t i = 0; i < children.Size(); ++i)
+        ReadGlbHeirarchy(file, dest.children[i], children[i].GetInt(), depth + 1);
+};
+
+// 채널을 대상 노드별로 모아 Bone 하나로 만든다. 애니메이션하지 않는 성분은 노드의 기본 TRS 한 키로 채우고,
+// 클립보다 먼저 끝나는 트랙은 마지막 키를 클립 끝에 한 번 더 둔다. CUBICSPLINE 은 접선을 버리고 값만 쓴다.
+void    Animation::ReadGlbTracks(const GlbFile& file, const JsonValue& animation)
+{
+    struct Track
+    {
+        std::vector<KeyPosition>    position;
+        std::vector<KeyRotation>    rotation;
+        std::vector<KeyScale>       scale;
+    };
+    const JsonValue&        channels = animation["channels"];
+    const JsonValue&        samplers = animation["samplers"];
+    std::vector<int>        trackNodes;
+    std::vector<Track>      tracks;
+    float                   duration = 0.0f;
+    for (size_t i = 0; i < channels.Size(); ++i)
+    {
+        const JsonValue&    target = channels[i]["target"];
+        const JsonValue&    sampler = samplers[channels[i]["sampler"].GetInt()];
+        const std::string&  path = target["path"].GetString();
+        int                 node = target["node"].GetInt();
+        if (node < 0 || !sampler.IsObject() || (path != "translation" && path != "rotation" && path != "scale"))
+            continue ;
+        GlbAccessor input = file.GetAccessor(sampler["input"].GetInt());
+        GlbAccessor output = file.GetAccessor(sampler["output"].GetInt());
+        size_t      step = sampler["interpolation"].GetString() == "CUBICSPLINE" ? 3 : 1;
+        size_t      first = step == 3 ? 1 : 0;
+        if (output.count < input.count * step)
+            throw std::string("Error: GLB animation sampler output too short");
+
+        auto    slot = std::find(trackNodes.begin(), trackNodes.end(), node);
+        if (slot == trackNodes.end())
+        {
+            trackNodes.push_back(node);
+            tracks.emplace_back();
+            slot = trackNodes.end() - 1;
+        }
+        Track&  track = tracks[slot - trackNodes.begin()];
+        for (size_t key = 0; key < input.count; ++key)
+        {
+            float   time = input.ReadFloat(key, 0) * 1000.0f;
+            size_t  value = key * step + first;
+            duration = std::max(duration, time);
+            if (path == "translation")
+                track.position.push_back(KeyPosition { glm::vec3(output.ReadFloat(value, 0), output.ReadFloat(value, 1),
+                                                                output.ReadFloat(value, 2)), time });
+            else if (path == "rotation")
+                track.rotation.push_back(KeyRotation { glm::quat(output.ReadFloat(value, 3), output.ReadFloat(value, 0),
+                                                                output.ReadFloat(value, 1), output.ReadFloat(value, 2)), time });
+            else
+                track.scale.push_back(KeyScale { glm::vec3(output.ReadFloat(value, 0), output.ReadFloat(value, 1),
+                                                        output.ReadFloat(value, 2)), time });
+        }
+    }
+    this->duration = duration;
+
+    this->bones.reserve(tracks.size());
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+        const JsonValue&    node = file.GetJson()["nodes"][trackNodes[i]];
+        const JsonValue&    t = node["translation"];
+        const JsonValue&    r = node["rotation"];
+        const JsonValue&    s = node["scale"];
+        Track&              track = tracks[i];
+        if (track.position.empty())
+            track.position.push_back(KeyPosition { t.Size() == 3 ? glm::vec3(t[0].GetNumber(), t[1].GetNumber(), t[2].GetNumber())
+                                                                : glm::vec3(0.0f), 0.0f });
+        if (track.rotation.empty())
+            track.rotation.push_back(KeyRotation { r.Size() == 4 ? glm::quat(static_cast<float>(r[3].GetNumber()),
+                                    static_cast<float>(r[0].GetNumber()), static_cast<float>(r[1].GetNumber()),
+                                    static_cast<float>(r[2].GetNumber())) : glm::quat(1.0f, 0.0f, 0.0f, 0.0f), 0.0f });
+        if (track.scale.empty())
+            track.scale.push_back(KeyScale { s.Size() == 3 ? glm::vec3(s[0].GetNumber(1.0), s[1].GetNumber(1.0), s[2].GetNumber(1.0))
+                                                        : glm::vec3(1.0f), 0.0f });
+        if (track.position.size() > 1 && track.position.back().timeStamp < duration)
+            track.position.push_back(KeyPosition { track.position.back().position, duration });
+        if (track.rotation.size() > 1 && track.rotation.back().timeStamp < duration)
+            track.rotation.push_back(KeyRotation { track.rotation.back().orientation, duration });
+        if (track.scale.size() > 1 && track.scale.back().timeStamp < duration)
+            track.scale.push_back(KeyScale { track.scale.back().scale, duration });
+        this->bones.push_back(Bone(file.GetNodeName(trackNodes[i]), static_cast<int>(i), std::move(track.position),
+                                std::move(track.rotation), std::move(track.scale)));
+    }
 };
 
 Bone*   Animation::FindBone(const std::string& name)
@@ -86,6 +271,36 @@ void    Animation::ReadMissingBones(const aiAnimation* animation, AniModel& mode
     this->boneInfoMap = tmpBoneInfoMap;
 };
 
+void    Animation::ReadTracks(const aiAnimation* animation)
+{
+    this->bones.reserve(animation->mNumChannels);
+    for (unsigned int i = 0; i < animation->mNumChannels; ++i)
+    {
+        auto    channel = animation->mChannels[i];
+        this->bones.push_back(Bone(channel->mNodeName.data, static_cast<int>(i), channel));
+    }
+};
+
+BoneRemap   Animation::BuildRemap(const std::map<std::string, BoneInfo>& modelBoneInfoMap) const
+{
+    BoneRemap   remap;
+    remap.boneCount = 0;
+    for (const auto& boneInfo : modelBoneInfoMap)
+        remap.boneCount = std::max(remap.boneCount, boneInfo.second.id + 1);
+
+    remap.boneIDs.assign(this->nodes.size(), -1);
+    remap.offsets.assign(this->nodes.size(), glm::mat4(1.0f));
+    for (size_t i = 0; i < this->nodes.size(); ++i)
+    {
+        auto    iter = modelBoneInfoMap.find(this->nodes[i].name);
+        if (iter == modelBoneInfoMap.end())
+            continue ;
+        remap.boneIDs[i] = iter->second.id;
+        remap.offsets[i] = iter->second.offset;
+    }
+    return (remap);
+};
+
 void    Animation::ReadHeirarchyData(AssimpNodeData& dest, const aiNode* src)
 {
     assert(src);
@@ -93,7 +308,7 @@ void    Animation::ReadHeirarchyData(AssimpNodeData& dest, const aiNode* src)
     dest.name = src->mName.data;
     dest.transformation = AssimpGLMHelpers::ConvertMatrixToGLMFormat(src->mTransformation);
     dest.childrenCount = src->mNumChildren;
-    for (int i = 0; i < src->mNumChildren; ++i)
+    for (unsigned int i = 0; i < src->mNumChildren; ++i)
     {
         AssimpNodeData  newData;
         ReadHeirarchyData(newData, src->mChildren[i]);
@@ -101,4 +316,46 @@ void    Animation::ReadHeirarchyData(AssimpNodeData& dest, const aiNode* src)
     }
 };
 
+void    Animation::FlattenHeirarchy(const AssimpNodeData& node, int parent)
+{
+    AnimationNode   flat;
+    flat.name = node.name;
+    flat.transformation = node.transformation;
+    flat.parent = parent;
+    flat.track = -1;
+    for (size_t i = 0; i < this->bones.size(); ++i)
+    {
+        if (this->bones[i].GetBoneName() == node.name)
+        {
+            flat.track = static_cast<int>(i);
+            break ;
+        }
+    }
+    int index = static_cast<int>(this->nodes.size());
+    this->nodes.push_back(flat);
+    for (int i = 0; i < node.childrenCount; ++i)
+        FlattenHeirarchy(node.children[i], index);
+};
+
+// 노드 이름과 부모 관계로 만든 FNV-1a 해시. 같은 리그에서 나온 클립은 같은 값을 갖는다.
+void    Animation::ComputeSignature(void)
+{
+    uint64_t    hash = 14695981039346656037ull;
+    auto        feed = [&hash](const void* data, size_t size)
+    {
+        const unsigned char*    bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    for (const AnimationNode& node : this->nodes)
+    {
+        feed(node.name.c_str(), node.name.size() + 1);
+        feed(&node.parent, sizeof(node.parent));
+    }
+    this->signature = hash;
+};
+
 #endif
\ No newline at end of file
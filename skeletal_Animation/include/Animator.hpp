@@ -12,27 +12,38 @@ class Animator
 public:
     Animator() = default;
     Animator(Animation* animation);
+    Animator(Animation* animation, const BoneRemap* remap);
     ~Animator() = default;
 
     void    UpdateAnimation(float dt);
     void    PlayAnimation(Animation* pAnimation);
-    void    CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform);
+    void    PlayAnimation(Animation* pAnimation, const BoneRemap* remap);
     std::vector<glm::mat4>  GetFinalBoneMatrices(void) const
     { return (this->finalBoneMatrices); };
 private:
     std::vector<glm::mat4>  finalBoneMatrices;
+    std::vector<glm::mat4>  globalTransforms;
     Animation*              currentAnimation {nullptr};
+    const BoneRemap*        currentRemap {nullptr};
+    BoneRemap               ownRemap {};
     float                   currentTime {0.0f};
     float                   deltaTime {0.0f};
+
+    void    CalculateBoneTransform(void);
+    const BoneRemap&    GetRemap(void) const
+    { return (this->currentRemap ? *this->currentRemap : this->ownRemap); };
 };
 
 Animator::Animator(Animation* animation)
 {
-    this->currentTime = 0.0f;
-    this->currentAnimation = animation;
-    this->finalBoneMatrices.reserve(100);
-    for (int i = 0; i < 100; ++i)
-        this->finalBoneMatrices.push_back(glm::mat4(1.0f));
+    this->finalBoneMatrices.assign(100, glm::mat4(1.0f));
+    PlayAnimation(animation);
+};
+
+Animator::Animator(Animation* animation, const BoneRemap* remap)
+{
+    this->finalBoneMatrices.assign(100, glm::mat4(1.0f));
+    PlayAnimation(animation, remap);
 };
 
 void    Animator::UpdateAnimation(float dt)
@@ -42,38 +53,54 @@ void    Animator::UpdateAnimation(float dt)
     {
         this->currentTime += this->currentAnimation->GetTicksPerSecond() * dt;
         this->currentTime = fmod(this->currentTime, this->currentAnimation->GetDuration());
-        CalculateBoneTransform(&this->currentAnimation->GetRootNode(), glm::mat4(1.0f));
+        CalculateBoneTransform();
     }
 };
 
+// remap 을 받지 않으면 Animation 에 복사된 boneInfoMap 으로 자기 remap 을 만들어 쓴다.
 void    Animator::PlayAnimation(Animation* pAnimation)
+{
+    if (pAnimation)
+        this->ownRemap = pAnimation->BuildRemap(pAnimation->GetBoneIDMap());
+    PlayAnimation(pAnimation, nullptr);
+};
+
+void    Animator::PlayAnimation(Animation* pAnimation, const BoneRemap* remap)
 {
     this->currentAnimation = pAnimation;
+    this->currentRemap = remap;
     this->currentTime = 0.0f;
+    if (pAnimation)
+        this->globalTransforms.resize(pAnimation->GetNodes().size());
+    if (static_cast<int>(this->finalBoneMatrices.size()) < GetRemap().boneCount)
+        this->finalBoneMatrices.resize(GetRemap().boneCount, glm::mat4(1.0f));
 };
 
-void    Animator::CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+// 노드가 부모 -> 자식 순으로 펼쳐져 있으므로 재귀 없이 한 번 순회한다.
+// 공유된 Bone 은 읽기만 하므로 같은 클립을 여러 Animator 가 동시에 재생해도 된다.
+void    Animator::CalculateBoneTransform(void)
 {
-    std::string nodeName = node->name;
-    glm::mat4   nodeTransform = node->transformation;
-    Bone*       bone = this->currentAnimation->FindBone(nodeName);
-    if (bone)
-    {
-        bone->Update(this->currentTime);
-        nodeTransform = bone->GetLocalTransform();
-    }
+    const std::vector<AnimationNode>&   nodes = this->currentAnimation->GetNodes();
+    const std::vector<Bone>&            bones = this->currentAnimation->GetBones();
+    const BoneRemap&                    remap = GetRemap();
 
-    glm::mat4   globalTransformation = parentTransform * nodeTransform;
-    auto        boneInfoMap = this->currentAnimation->GetBoneIDMap();
-    if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+    for (size_t i = 0; i < nodes.size(); ++i)
     {
-        int index = boneInfoMap[nodeName].id;
-        glm::mat4   offset = boneInfoMap[nodeName].offset;
-        this->finalBoneMatrices[index] = globalTransformation * offset;
+        const AnimationNode&    node = nodes[i];
+        glm::mat4               nodeTransform = node.transformation;
+        if (node.track >= 0)
+            nodeTransform = bones[node.track].Sample(this->currentTime);
+
+        if (node.parent >= 0)
+            this->globalTransforms[i] = this->globalTransforms[node.parent] * nodeTransform;
+        else
+            this->globalTransforms[i] = nodeTransform;
+
+        int index = remap.boneIDs[i];
+        if (index >= 0)
+            this->finalBoneMatrices[index] = this->globalTransforms[i] * remap.offsets[i];
     }
-    for (int i = 0; i < node->childrenCount; ++i)
-        CalculateBoneTransform(&node->children[i], globalTransformation);
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,389 @@
+#ifndef BLOCKENCODER_HPP
+#define BLOCKENCODER_HPP
+
+#include "Common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// 4x4 RGBA8 블록 하나를 BC1 / BC3 / BC4 / BC5 / BC7 로 압축하는 CPU 인코더. GL 없이 돈다.
+// 블록 픽셀은 행 우선 16 개, 픽셀마다 RGBA 4 바이트다.
+// 끝점은 주성분 축의 양 끝에서 시작해 한 번 최소 제곱으로 다듬는다. (BC7 은 단일 구간 mode 6 만 쓴다)
+class BlockEncoder
+{
+public:
+    static void EncodeBC1(const unsigned char* block, unsigned char* out);
+    static void EncodeBC3(const unsigned char* block, unsigned char* out);
+    static void EncodeBC4(const unsigned char* block, int channel, unsigned char* out);
+    static void EncodeBC5(const unsigned char* block, unsigned char* out);
+    static void EncodeBC7(const unsigned char* block, unsigned char* out);
+private:
+    static void         principalAxis(const unsigned char* block, int channels, float* mean, float* axis);
+    static uint16_t     packColor565(const float* color);
+    static void         unpackColor565(uint16_t color, int* rgb);
+    static uint32_t     fitColorIndices(const unsigned char* block, const int palette[4][3], uint32_t& error);
+    static uint32_t     encodeBC1Endpoints(const unsigned char* block, const float* low, const float* high,
+                                        uint16_t& color0, uint16_t& color1, uint32_t& error);
+    static void         writeBits(unsigned char* out, int& position, uint32_t value, int count);
+    static uint32_t     encodeBC7Mode6(const unsigned char* block, const float* low, const float* high,
+                                    unsigned char* out);
+};
+
+// 평균과 공분산의 가장 큰 고유 벡터 (거듭제곱법). 색이 모두 같으면 축은 0 이다.
+void    BlockEncoder::principalAxis(const unsigned char* block, int channels, float* mean, float* axis)
+{
+    float   covariance[4][4] = {};
+    for (int c = 0; c < channels; ++c)
+    {
+        mean[c] = 0.0f;
+        for (int i = 0; i < 16; ++i)
+            mean[c] += block[i * 4 + c];
+        mean[c] /= 16.0f;
+    }
+    for (int i = 0; i < 16; ++i)
+        for (int a = 0; a < channels; ++a)
+            for (int b = a; b < channels; ++b)
+                covariance[a][b] += (block[i * 4 + a] - mean[a]) * (block[i * 4 + b] - mean[b]);
+    for (int a = 0; a < channels; ++a)
+        for (int b = 0; b < a; ++b)
+            covariance[a][b] = covariance[b][a];
+
+    for (int c = 0; c < channels; ++c)
+        axis[c] = covariance[c][c];
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float   next[4] = {}, length = 0.0f;
+        for (int a = 0; a < channels; ++a)
+        {
+            for (int b = 0; b < channels; ++b)
+                next[a] += covariance[a][b] * axis[b];
+            length = std::max(length, std::abs(next[a]));
+        }
+        if (length <= 0.0f)
+        {
+            std::fill(axis, axis + channels, 0.0f);
+            return ;
+        }
+        for (int c = 0; c < channels; ++c)
+            axis[c] = next[c] / length;
+    }
+};
+
+uint16_t    BlockEncoder::packColor565(const float* color)
+{
+    int r = std::max(0, std::min(31, static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f)));
+    int g = std::max(0, std::min(63, static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f)));
+    int b = std::max(0, std::min(31, static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f)));
+    return (static_cast<uint16_t>((r << 11) | (g << 5) | b));
+};
+
+void    BlockEncoder::unpackColor565(uint16_t color, int* rgb)
+{
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+};
+
+// 팔레트에서 가장 가까운 색의 번호를 2 비트씩 모은다.
+uint32_t    BlockEncoder::fitColorIndices(const unsigned char* block, const int palette[4][3], uint32_t& error)
+{
+    uint32_t    indices = 0;
+    error = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        uint32_t    best = ~0u;
+        int         bestIndex = 0;
+        for (int p = 0; p < 4; ++p)
+        {
+            int         dr = block[i * 4] - palette[p][0], dg = block[i * 4 + 1] - palette[p][1];
+            int         db = block[i * 4 + 2] - palette[p][2];
+            uint32_t    distance = static_cast<uint32_t>(dr * dr + dg * dg + db * db);
+            if (distance < best)
+            {
+                best = distance;
+                bestIndex = p;
+            }
+        }
+        error += best;
+        indices |= static_cast<uint32_t>(bestIndex) << (i * 2);
+    }
+    return (indices);
+};
+
+// color0 > color1 이면 4 색 모드다. 같으면 모든 픽셀이 color0 을 쓴다.
+uint32_t    BlockEncoder::encodeBC1Endpoints(const unsigned char* block, const float* low, const float* high,
+                                            uint16_t& color0, uint16_t& color1, uint32_t& error)
+{
+    color0 = packColor565(high);
+    color1 = packColor565(low);
+    if (color0 < color1)
+        std::swap(color0, color1);
+    int palette[4][3];
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+    if (color0 == color1)
+    {
+        for (int c = 0; c < 3; ++c)
+            palette[2][c] = palette[3][c] = palette[0][c];
+    }
+    else
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+    uint32_t    indices = fitColorIndices(block, palette, error);
+    return (color0 == color1 ? 0u : indices);
+};
+
+void    BlockEncoder::EncodeBC1(const unsigned char* block, unsigned char* out)
+{
+    float   mean[4], axis[4];
+    principalAxis(block, 3, mean, axis);
+    float   minimum = 0.0f, maximum = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float   t = 0.0f;
+        for (int c = 0; c < 3; ++c)
+            t += (block[i * 4 + c] - mean[c]) * axis[c];
+        minimum = std::min(minimum, t);
+        maximum = std::max(maximum, t);
+    }
+    // 양 끝을 조금 안쪽으로 당기면 양자화 오차가 줄어든다.
+    float   inset = (maximum - minimum) / 16.0f;
+    float   low[3], high[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        low[c] = std::max(0.0f, std::min(255.0f, mean[c] + (minimum + inset) * axis[c]));
+        high[c] = std::max(0.0f, std::min(255.0f, mean[c] + (maximum - inset) * axis[c]));
+    }
+
+    uint16_t    color0, color1;
+    uint32_t    error;
+    uint32_t    indices = encodeBC1Endpoints(block, low, high, color0, color1, error);
+
+    // 고른 번호로 끝점을 최소 제곱으로 다시 구해서 오차가 줄면 바꾼다.
+    static const float  weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    float   aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16 && error > 0; ++i)
+    {
+        float   w = weights[(indices >> (i * 2)) & 3];
+        aa += w * w;
+        ab += w * (1.0f - w);
+        bb += (1.0f - w) * (1.0f - w);
+        for (int c = 0; c < 3; ++c)
+        {
+            ax[c] += w * block[i * 4 + c];
+            bx[c] += (1.0f - w) * block[i * 4 + c];
+        }
+    }
+    float   det = aa * bb - ab * ab;
+    if (error > 0 && std::abs(det) > 1e-6f)
+    {
+        float   refinedHigh[3], refinedLow[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            refinedHigh[c] = std::max(0.0f, std::min(255.0f, (ax[c] * bb - bx[c] * ab) / det));
+            refinedLow[c] = std::max(0.0f, std::min(255.0f, (bx[c] * aa - ax[c] * ab) / det));
+        }
+        uint16_t    refined0, refined1;
+        uint32_t    refinedError;
+        uint32_t    refinedIndices = encodeBC1Endpoints(block, refinedLow, refinedHigh, refined0, refined1, refinedError);
+        if (refinedError < error)
+        {
+            color0 = refined0;
+            color1 = refined1;
+            indices = refinedIndices;
+        }
+    }
+    out[0] = color0 & 0xFF;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF;
+    out[3] = color1 >> 8;
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (indices >> (i * 8)) & 0xFF;
+};
+
+// 8 단계 모드 (a0 > a1). 값이 모두 같으면 번호는 모두 0 이다.
+void    BlockEncoder::EncodeBC4(const unsigned char* block, int channel, unsigned char* out)
+{
+    int minimum = 255, maximum = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        minimum = std::min(minimum, static_cast<int>(block[i * 4 + channel]));
+        maximum = std::max(maximum, static_cast<int>(block[i * 4 + channel]));
+    }
+    out[0] = static_cast<unsigned char>(maximum);
+    out[1] = static_cast<unsigned char>(minimum);
+    uint64_t    indices = 0;
+    if (maximum > minimum)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            // a1 에서 a0 까지를 0 ~ 7 로 본 위치. 7 은 번호 0 (a0), 0 은 번호 1 (a1), 나머지는 8 - 위치
+            int         step = ((block[i * 4 + channel] - minimum) * 14 + (maximum - minimum)) / ((maximum - minimum) * 2);
+            uint64_t    code = step == 7 ? 0 : (step == 0 ? 1 : 8 - step);
+            indices |= code << (i * 3);
+        }
+    }
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (indices >> (i * 8)) & 0xFF;
+};
+
+void    BlockEncoder::EncodeBC3(const unsigned char* block, unsigned char* out)
+{
+    EncodeBC4(block, 3, out);
+    EncodeBC1(block, out + 8);
+};
+
+void    BlockEncoder::EncodeBC5(const unsigned char* block, unsigned char* out)
+{
+    EncodeBC4(block, 0, out);
+    EncodeBC4(block, 1, out + 8);
+};
+
+void    BlockEncoder::writeBits(unsigned char* out, int& position, uint32_t value, int count)
+{
+    for (int i = 0; i < count; ++i, ++position)
+        if ((value >> i) & 1)
+            out[position >> 3] |= static_cast<unsigned char>(1 << (position & 7));
+};
+
+// mode 6: RGBA 끝점 7 비트 + 끝점마다 p 비트 1 개, 번호 4 비트. 첫 픽셀의 번호 최상위 비트는 0 이어야 한다.
+uint32_t    BlockEncoder::encodeBC7Mode6(const unsigned char* block, const float* low, const float* high,
+                                        unsigned char* out)
+{
+    static const int    weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    int     endpoints[2][4], quantized[2][4], pbits[2];
+    for (int e = 0; e < 2; ++e)
+    {
+        const float*    source = e == 0 ? low : high;
+        uint32_t        bestError = ~0u;
+        // 불투명한 끝점은 p 비트가 0 이면 알파가 254 가 되어 알파 테스트 / 블렌딩에 새어 나오므로 1 로 고정한다.
+        for (int p = source[3] > 254.5f ? 1 : 0; p < 2; ++p)
+        {
+            int         candidate[4];
+            uint32_t    candidateError = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                candidate[c] = std::max(0, std::min(127, static_cast<int>((source[c] - p) / 2.0f + 0.5f)));
+                int diff = ((candidate[c] << 1) | p) - static_cast<int>(source[c] + 0.5f);
+                candidateError += static_cast<uint32_t>(diff * diff);
+            }
+            if (candidateError < bestError)
+            {
+                bestError = candidateError;
+                pbits[e] = p;
+                std::copy(candidate, candidate + 4, quantized[e]);
+            }
+        }
+        for (int c = 0; c < 4; ++c)
+            endpoints[e][c] = (quantized[e][c] << 1) | pbits[e];
+    }
+
+    int palette[16][4];
+    for (int w = 0; w < 16; ++w)
+        for (int c = 0; c < 4; ++c)
+            palette[w][c] = ((64 - weights[w]) * endpoints[0][c] + weights[w] * endpoints[1][c] + 32) >> 6;
+    int         indices[16];
+    uint32_t    error = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        uint32_t    best = ~0u;
+        for (int w = 0; w < 16; ++w)
+        {
+            uint32_t    distance = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                int diff = block[i * 4 + c] - palette[w][c];
+                distance += static_cast<uint32_t>(diff * diff);
+            }
+            if (distance < best)
+            {
+                best = distance;
+                indices[i] = w;
+            }
+        }
+        error += best;
+    }
+    if (indices[0] >= 8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(pbits[0], pbits[1]);
+        for (int& index : indices)
+            index = 15 - index;
+    }
+
+    std::memset(out, 0, 16);
+    int position = 0;
+    writeBits(out, position, 1u << 6, 7);
+    for (int c = 0; c < 4; ++c)
+        for (int e = 0; e < 2; ++e)
+            writeBits(out, position, static_cast<uint32_t>(quantized[e][c]), 7);
+    writeBits(out, position, static_cast<uint32_t>(pbits[0]), 1);
+    writeBits(out, position, static_cast<uint32_t>(pbits[1]), 1);
+    writeBits(out, position, static_cast<uint32_t>(indices[0]), 3);
+    for (int i = 1; i < 16; ++i)
+        writeBits(out, position, static_cast<uint32_t>(indices[i]), 4);
+    return (error);
+};
+
+void    BlockEncoder::EncodeBC7(const unsigned char* block, unsigned char* out)
+{
+    float   mean[4], axis[4];
+    principalAxis(block, 4, mean, axis);
+    float   minimum = 0.0f, maximum = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float   t = 0.0f;
+        for (int c = 0; c < 4; ++c)
+            t += (block[i * 4 + c] - mean[c]) * axis[c];
+        minimum = std::min(minimum, t);
+        maximum = std::max(maximum, t);
+    }
+    float   low[4], high[4];
+    for (int c = 0; c < 4; ++c)
+    {
+        low[c] = std::max(0.0f, std::min(255.0f, mean[c] + minimum * axis[c]));
+        high[c] = std::max(0.0f, std::min(255.0f, mean[c] + maximum * axis[c]));
+    }
+    uint32_t    error = encodeBC7Mode6(block, low, high, out);
+    if (error == 0)
+        return ;
+
+    // 고른 번호 (out 에서 다시 읽지 않고 끝점 투영으로 근사) 로 최소 제곱 끝점을 구해 본다.
+    float   aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[4] = {}, bx[4] = {};
+    float   span = maximum - minimum;
+    for (int i = 0; i < 16 && span > 0.0f; ++i)
+    {
+        float   t = 0.0f;
+        for (int c = 0; c < 4; ++c)
+            t += (block[i * 4 + c] - mean[c]) * axis[c];
+        float   w = std::round((t - minimum) / span * 15.0f) / 15.0f;
+        aa += (1.0f - w) * (1.0f - w);
+        ab += w * (1.0f - w);
+        bb += w * w;
+        for (int c = 0; c < 4; ++c)
+        {
+            ax[c] += (1.0f - w) * block[i * 4 + c];
+            bx[c] += w * block[i * 4 + c];
+        }
+    }
+    float   det = aa * bb - ab * ab;
+    if (std::abs(det) <= 1e-6f)
+        return ;
+    float   refinedLow[4], refinedHigh[4];
+    for (int c = 0; c < 4; ++c)
+    {
+        refinedLow[c] = std::max(0.0f, std::min(255.0f, (ax[c] * bb - bx[c] * ab) / det));
+        refinedHigh[c] = std::max(0.0f, std::min(255.0f, (bx[c] * aa - ax[c] * ab) / det));
+    }
+    unsigned char   refined[16];
+    if (encodeBC7Mode6(block, refinedLow, refinedHigh, refined) < error)
+        std::memcpy(out, refined, 16);
+};
+
+#endif
@@ -31,17 +31,24 @@ class Bone
 public:
     Bone() = default;
     Bone(const std::string& name, int ID, const aiNodeAnim* channel);
+    Bone(const std::string& name, int ID, std::vector<KeyPosition>&& position, std::vector<KeyRotation>&& rotation,
+        std::vector<KeyScale>&& scale);
     ~Bone() {};
 
-    void    Update(float animation);
+    void        Update(float animation);
+    glm::mat4   Sample(float animationTime) const;
 
     glm::mat4   GetLocalTransform(void) { return (this->localTransform); };
     std::string GetBoneName(void) const { return (this->name); };
     int         GetBoneID(void) {return (this->ID); };
 
-    int GetPositionIndex(float animationTime);
-	int GetRotationIndex(float animationTime);
-	int GetScaleIndex(float animationTime);
+    const std::vector<KeyPosition>& GetPositionKeys(void) const { return (this->position); };
+    const std::vector<KeyRotation>& GetRotationKeys(void) const { return (this->rotation); };
+    const std::vector<KeyScale>&    GetScaleKeys(void) const { return (this->scale); };
+
+    int GetPositionIndex(float animationTime) const;
+	int GetRotationIndex(float animationTime) const;
+	int GetScaleIndex(float animationTime) const;
     
 private:
     std::vector<KeyPosition>    position;
@@ -55,9 +62,9 @@ private:
 
     float   GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const;
 
-    glm::mat4   InterpolatePosition(float animationTime);
-    glm::mat4   InterpolateRotation(float animationTime);
-    glm::mat4   InterpolateScaling(float animationTime);
+    glm::mat4   InterpolatePosition(float animationTime) const;
+    glm::mat4   InterpolateRotation(float animationTime) const;
+    glm::mat4   InterpolateScaling(float animationTime) const;
 };
 
 Bone::Bone(const std::string& name, int ID, const aiNodeAnim* channel)
@@ -98,15 +105,30 @@ Bone::Bone(const std::string& name, int ID, const aiNodeAnim* channel)
     }
 };
 
+// Assimp 를 거치지 않는 클립(GLB)용. 각 목록에 키가 하나 이상 있어야 한다.
+Bone::Bone(const std::string& name, int ID, std::vector<KeyPosition>&& position, std::vector<KeyRotation>&& rotation,
+        std::vector<KeyScale>&& scale)
+: position(std::move(position)), rotation(std::move(rotation)), scale(std::move(scale)),
+    localTransform(1.0f), name(name), ID(ID)
+{
+    this->numPositions = static_cast<int>(this->position.size());
+    this->numRotations = static_cast<int>(this->rotation.size());
+    this->numScalings = static_cast<int>(this->scale.size());
+};
+
 void    Bone::Update(float animationTime)
+{ this->localTransform = Sample(animationTime); };
+
+// Update 와 달리 Bone 의 상태를 바꾸지 않으므로 여러 Animator 가 같은 Bone 을 공유할 수 있다.
+glm::mat4   Bone::Sample(float animationTime) const
 {
     glm::mat4   translation = InterpolatePosition(animationTime);
     glm::mat4   rotation = InterpolateRotation(animationTime);
     glm::mat4   scale = InterpolateScaling(animationTime);
-    this->localTransform = translation * rotation * scale;
+    return (translation * rotation * scale);
 };
 
-int Bone::GetPositionIndex(float animationTime)
+int Bone::GetPositionIndex(float animationTime) const
 {
     for (int index = 0; index < this->numPositions - 1; ++index)
     {
@@ -116,7 +138,7 @@ int Bone::GetPositionIndex(float animationTime)
     assert(0);
 }
 
-int Bone::GetRotationIndex(float animationTime)
+int Bone::GetRotationIndex(float animationTime) const
 {
     for (int index = 0; index < numRotations - 1; ++index)
     {
@@ -126,7 +148,7 @@ int Bone::GetRotationIndex(float animationTime)
     assert(0);
 }
 
-int Bone::GetScaleIndex(float animationTime)
+int Bone::GetScaleIndex(float animationTime) const
 {
     for (int index = 0; index < numScalings - 1; ++index)
     {
@@ -145,7 +167,7 @@ float   Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float ani
     return (scaleFactor);
 };
 
-glm::mat4   Bone::InterpolatePosition(float animationTime)
+glm::mat4   Bone::InterpolatePosition(float animationTime) const
 {
     if (this->numPositions == 1)
         return (glm::translate(glm::mat4(1.0f), this->position[0].position));
@@ -161,7 +183,7 @@ glm::mat4   Bone::InterpolatePosition(float animationTime)
     return (glm::translate(glm::mat4(1.0f), finalPosition));
 };
 
-glm::mat4   Bone::InterpolateRotation(float animationTime)
+glm::mat4   Bone::InterpolateRotation(float animationTime) const
 {
     if (this->numRotations == 1)
     {
@@ -181,7 +203,7 @@ glm::mat4   Bone::InterpolateRotation(float animationTime)
     return (glm::toMat4(finalRotation));
 };
 
-glm::mat4   Bone::InterpolateScaling(float animationTime)
+glm::mat4   Bone::InterpolateScaling(float animationTime) const
 {
     if (this->numScalings == 1)
         return (glm::scale(glm::mat4(1.0f), this->scale[0].scale));
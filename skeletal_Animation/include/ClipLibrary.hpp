@@ -0,0 +1,92 @@
+#ifndef CLIPLIBRARY_HPP
+#define CLIPLIBRARY_HPP
+
+#include "Common.hpp"
+#include "Animation.hpp"
+#include "AniModel.hpp"
+#include <unordered_map>
+
+// 클립은 골격 signature 별로 한 번만 읽고, remap 테이블은 (모델 bone 표, 클립 골격) 쌍마다 하나만 만든다.
+// 같은 리그를 쓰는 캐릭터 N 명이 클립 사본과 remap 하나를 같이 쓴다.
+class ClipLibrary
+{
+public:
+    static std::unique_ptr<ClipLibrary> Create(void);
+
+    ~ClipLibrary() {};
+
+    Animation*          Load(const std::string& animationPath);
+    const BoneRemap*    GetRemap(AniModel* model, const Animation* clip);
+    const std::vector<Animation*>&  GetClips(uint64_t signature);
+
+    size_t  GetClipCount(void) const { return (this->clips.size()); };
+private:
+    std::unordered_map<std::string, std::unique_ptr<Animation>>     clips;
+    std::unordered_map<uint64_t, std::vector<Animation*>>           skeletons;
+    std::map<std::pair<uint64_t, uint64_t>, std::unique_ptr<BoneRemap>>   remaps;
+
+    ClipLibrary() {};
+    static uint64_t makeSignature(const std::map<std::string, BoneInfo>& boneInfoMap);
+};
+
+std::unique_ptr<ClipLibrary>    ClipLibrary::Create(void)
+{
+    return (std::unique_ptr<ClipLibrary>(new ClipLibrary()));
+};
+
+Animation*  ClipLibrary::Load(const std::string& animationPath)
+{
+    std::string key = std::filesystem::path(animationPath).lexically_normal().generic_string();
+    auto        iter = this->clips.find(key);
+    if (iter != this->clips.end())
+        return (iter->second.get());
+
+    std::unique_ptr<Animation>  clip = std::unique_ptr<Animation>(new Animation(animationPath));
+    Animation*                  result = clip.get();
+    this->skeletons[clip->GetSignature()].push_back(result);
+    this->clips.emplace(key, std::move(clip));
+    return (result);
+};
+
+const BoneRemap*    ClipLibrary::GetRemap(AniModel* model, const Animation* clip)
+{
+    // 모델 주소로 묶으면 모델이 지워진 뒤에도 항목이 남고 주소가 재사용될 수 있어, bone 표 내용으로 묶는다.
+    auto    key = std::make_pair(makeSignature(model->GetBoneInfoMap()), clip->GetSignature());
+    auto    iter = this->remaps.find(key);
+    if (iter != this->remaps.end())
+        return (iter->second.get());
+
+    std::unique_ptr<BoneRemap>  remap = std::unique_ptr<BoneRemap>(new BoneRemap(clip->BuildRemap(model->GetBoneInfoMap())));
+    const BoneRemap*            result = remap.get();
+    this->remaps.emplace(key, std::move(remap));
+    return (result);
+};
+
+const std::vector<Animation*>&  ClipLibrary::GetClips(uint64_t signature)
+{
+    return (this->skeletons[signature]);
+};
+
+// bone 이름 / id / offset 으로 만든 FNV-1a 해시. BuildRemap 이 읽는 값이 같으면 같은 remap 이 나온다.
+uint64_t    ClipLibrary::makeSignature(const std::map<std::string, BoneInfo>& boneInfoMap)
+{
+    uint64_t    hash = 14695981039346656037ull;
+    auto        feed = [&hash](const void* data, size_t size)
+    {
+        const unsigned char*    bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    for (const auto& boneInfo : boneInfoMap)
+    {
+        feed(boneInfo.first.c_str(), boneInfo.first.size() + 1);
+        feed(&boneInfo.second.id, sizeof(boneInfo.second.id));
+        feed(glm::value_ptr(boneInfo.second.offset), sizeof(glm::mat4));
+    }
+    return (hash);
+};
+
+#endif
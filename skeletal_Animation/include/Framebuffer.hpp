@@ -3,6 +3,7 @@
 
 #include "Common.hpp"
 #include "Texture.hpp"
+#include "GpuMemory.hpp"
 
 class FrameBuffer
 {
@@ -39,6 +40,7 @@ FrameBuffer::~FrameBuffer()
 {
     if (this->depthStencilBuffer)
         glDeleteRenderbuffers(1, &this->depthStencilBuffer);
+    GpuMemory::Get().Release(GpuMemory::RENDERBUFFER, this->depthStencilBuffer);
     if (this->id)
         glDeleteFramebuffers(1, &this->id);
 };
@@ -60,6 +62,10 @@ void    FrameBuffer::init(const std::vector<std::shared_ptr<Texture>> colorAttac
     glBindRenderbuffer(GL_RENDERBUFFER, this->depthStencilBuffer);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT,
                         this->colorAttachments[0]->GetWidth(), this->colorAttachments[0]->GetHeight());
+    GpuMemory::Get().Track(GpuMemory::RENDERBUFFER, this->depthStencilBuffer,
+                        static_cast<size_t>(this->colorAttachments[0]->GetWidth())
+                        * static_cast<size_t>(this->colorAttachments[0]->GetHeight())
+                        * GpuMemory::GetTexelSize(GL_DEPTH_COMPONENT), "FrameBuffer depth");
 
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
                             GL_RENDERBUFFER, this->depthStencilBuffer);
@@ -0,0 +1,322 @@
+#ifndef GPUANIMATION_HPP
+#define GPUANIMATION_HPP
+
+#include "Common.hpp"
+#include "GpuMemory.hpp"
+#include "Program.hpp"
+#include "Animation.hpp"
+
+// std430 레이아웃과 1:1 로 맞춘 구조체들 (shader/animation_sample.comp 참고)
+struct GPUTrack
+{
+    GLint   positionOffset, positionCount;
+    GLint   rotationOffset, rotationCount;
+    GLint   scaleOffset, scaleCount;
+    GLint   pad0, pad1;
+};
+
+struct GPUNode
+{
+    glm::mat4   transformation;
+    glm::mat4   offset;
+    GLint       parent, track, bone, pad;
+};
+
+class GPUAnimation
+{
+public:
+    static constexpr GLuint TRACK_BINDING = 0;
+    static constexpr GLuint KEY_VALUE_BINDING = 1;
+    static constexpr GLuint KEY_TIME_BINDING = 2;
+    static constexpr GLuint NODE_BINDING = 3;
+    static constexpr GLuint TIME_BINDING = 4;
+    static constexpr GLuint GLOBAL_BINDING = 5;
+    static constexpr GLuint PALETTE_BINDING = 6;
+    static constexpr GLuint INSTANCE_BINDING = 7;
+    static constexpr GLuint LOCAL_SIZE = 64;
+
+    static std::unique_ptr<GPUAnimation>    Create(Animation* animation, int instanceCount,
+                                                const BoneRemap* remap = nullptr);
+
+    ~GPUAnimation();
+
+    void    SetInstance(int index, const glm::mat4& transform, float phase = 0.0f);
+    void    UpdateAnimation(float dt);
+    void    Dispatch(Program* program);
+    void    Bind(Program* program);
+
+    void    EvaluateReference(std::vector<glm::mat4>& palettes) const;
+    float   Validate(void);
+
+    int     GetInstanceCount(void) const { return (this->instanceCount); };
+    glm::mat4   GetNearestInstance(const glm::mat4& model, const glm::vec3& cameraPos) const;
+    int     GetBoneCount(void) const { return (this->boneCount); };
+private:
+    GLuint  buffers[8] { 0 };
+    int     instanceCount { 0 }, boneCount { 0 };
+    float   duration { 0.0f }, ticksPerSecond { 0.0f };
+    bool    dirtyInstances { true };
+
+    std::vector<GPUTrack>   tracks;
+    std::vector<glm::vec4>  keyValues;
+    std::vector<float>      keyTimes;
+    std::vector<GPUNode>    nodes;
+    std::vector<float>      times;
+    std::vector<glm::mat4>  instanceModels;
+
+    GPUAnimation() {};
+    void    init(Animation* animation, int instanceCount, const BoneRemap* remap);
+    void    PackTracks(const Animation* animation);
+    void    PackNodes(const Animation* animation, const BoneRemap& remap);
+    void    CreateBuffer(GLuint binding, size_t dataSize, const void* data, GLenum usage);
+};
+
+std::unique_ptr<GPUAnimation>   GPUAnimation::Create(Animation* animation, int instanceCount,
+                                                    const BoneRemap* remap)
+{
+    std::unique_ptr<GPUAnimation>   gpuAnimation = std::unique_ptr<GPUAnimation>(new GPUAnimation());
+    gpuAnimation->init(animation, instanceCount, remap);
+    return (std::move(gpuAnimation));
+};
+
+GPUAnimation::~GPUAnimation()
+{
+    glDeleteBuffers(8, this->buffers);
+    for (GLuint buffer : this->buffers)
+        GpuMemory::Get().Release(GpuMemory::BUFFER, buffer);
+};
+
+void    GPUAnimation::init(Animation* animation, int instanceCount, const BoneRemap* remap)
+{
+    this->instanceCount = instanceCount;
+    this->duration = animation->GetDuration();
+    this->ticksPerSecond = animation->GetTicksPerSecond();
+    PackTracks(animation);
+    if (remap)
+        PackNodes(animation, *remap);
+    else
+        PackNodes(animation, animation->BuildRemap(animation->GetBoneIDMap()));
+
+    this->times.assign(instanceCount, 0.0f);
+    this->instanceModels.assign(instanceCount, glm::mat4(1.0f));
+    std::vector<glm::mat4>  identity(static_cast<size_t>(instanceCount) * this->boneCount, glm::mat4(1.0f));
+
+    glGenBuffers(8, this->buffers);
+    CreateBuffer(TRACK_BINDING, this->tracks.size() * sizeof(GPUTrack), this->tracks.data(), GL_STATIC_DRAW);
+    CreateBuffer(KEY_VALUE_BINDING, this->keyValues.size() * sizeof(glm::vec4), this->keyValues.data(), GL_STATIC_DRAW);
+    CreateBuffer(KEY_TIME_BINDING, this->keyTimes.size() * sizeof(float), this->keyTimes.data(), GL_STATIC_DRAW);
+    CreateBuffer(NODE_BINDING, this->nodes.size() * sizeof(GPUNode), this->nodes.data(), GL_STATIC_DRAW);
+    CreateBuffer(TIME_BINDING, this->times.size() * sizeof(float), this->times.data(), GL_DYNAMIC_DRAW);
+    CreateBuffer(GLOBAL_BINDING, static_cast<size_t>(instanceCount) * this->nodes.size() * sizeof(glm::mat4),
+                nullptr, GL_DYNAMIC_COPY);
+    CreateBuffer(PALETTE_BINDING, identity.size() * sizeof(glm::mat4), identity.data(), GL_DYNAMIC_COPY);
+    CreateBuffer(INSTANCE_BINDING, this->instanceModels.size() * sizeof(glm::mat4),
+                this->instanceModels.data(), GL_DYNAMIC_DRAW);
+};
+
+void    GPUAnimation::PackTracks(const Animation* animation)
+{
+    // 키의 값과 시간을 각각 하나의 배열로 이어붙이고, 트랙은 그 안의 구간만 가리킨다.
+    for (const Bone& bone : animation->GetBones())
+    {
+        GPUTrack    track {};
+
+        track.positionOffset = static_cast<GLint>(this->keyTimes.size());
+        track.positionCount = static_cast<GLint>(bone.GetPositionKeys().size());
+        for (const KeyPosition& key : bone.GetPositionKeys())
+        {
+            this->keyValues.push_back(glm::vec4(key.position, 0.0f));
+            this->keyTimes.push_back(key.timeStamp);
+        }
+        track.rotationOffset = static_cast<GLint>(this->keyTimes.size());
+        track.rotationCount = static_cast<GLint>(bone.GetRotationKeys().size());
+        for (const KeyRotation& key : bone.GetRotationKeys())
+        {
+            const glm::quat&    q = key.orientation;
+            this->keyValues.push_back(glm::vec4(q.x, q.y, q.z, q.w));
+            this->keyTimes.push_back(key.timeStamp);
+        }
+        track.scaleOffset = static_cast<GLint>(this->keyTimes.size());
+        track.scaleCount = static_cast<GLint>(bone.GetScaleKeys().size());
+        for (const KeyScale& key : bone.GetScaleKeys())
+        {
+            this->keyValues.push_back(glm::vec4(key.scale, 0.0f));
+            this->keyTimes.push_back(key.timeStamp);
+        }
+        this->tracks.push_back(track);
+    }
+};
+
+void    GPUAnimation::PackNodes(const Animation* animation, const BoneRemap& remap)
+{
+    const std::vector<AnimationNode>&   animationNodes = animation->GetNodes();
+
+    this->boneCount = remap.boneCount;
+    for (size_t i = 0; i < animationNodes.size(); ++i)
+    {
+        GPUNode gpuNode {};
+        gpuNode.transformation = animationNodes[i].transformation;
+        gpuNode.offset = remap.offsets[i];
+        gpuNode.parent = animationNodes[i].parent;
+        gpuNode.track = animationNodes[i].track;
+        gpuNode.bone = remap.boneIDs[i];
+        this->nodes.push_back(gpuNode);
+    }
+};
+
+void    GPUAnimation::CreateBuffer(GLuint binding, size_t dataSize, const void* data, GLenum usage)
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->buffers[binding]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(dataSize, sizeof(glm::vec4)), data, usage);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    GpuMemory::Get().Track(GpuMemory::BUFFER, this->buffers[binding], std::max(dataSize, sizeof(glm::vec4)), "GPUAnimation");
+};
+
+void    GPUAnimation::SetInstance(int index, const glm::mat4& transform, float phase)
+{
+    this->instanceModels[index] = transform;
+    this->times[index] = fmod(phase * this->duration, this->duration);
+    this->dirtyInstances = true;
+};
+
+// 인스턴스 원점이 카메라에 가장 가까운 것의 월드 변환. model 은 셰이더에 넘긴 것과 같은 행렬이다.
+glm::mat4   GPUAnimation::GetNearestInstance(const glm::mat4& model, const glm::vec3& cameraPos) const
+{
+    glm::mat4   nearest = model;
+    float       nearestDistance = std::numeric_limits<float>::max();
+    for (const glm::mat4& instance : this->instanceModels)
+    {
+        glm::mat4   world = model * instance;
+        float       distance = glm::length(glm::vec3(world[3]) - cameraPos);
+        if (distance < nearestDistance)
+        {
+            nearestDistance = distance;
+            nearest = world;
+        }
+    }
+    return (nearest);
+};
+
+void    GPUAnimation::UpdateAnimation(float dt)
+{
+    // 시간 진행은 인스턴스당 float 하나라 CPU 에서 하고, 키 샘플링부터는 전부 GPU 에서 한다.
+    float   delta = this->ticksPerSecond * dt;
+    for (float& time : this->times)
+        time = fmod(time + delta, this->duration);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->buffers[TIME_BINDING]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, this->times.size() * sizeof(float), this->times.data());
+    if (this->dirtyInstances)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->buffers[INSTANCE_BINDING]);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, this->instanceModels.size() * sizeof(glm::mat4),
+                        this->instanceModels.data());
+        this->dirtyInstances = false;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+};
+
+void    GPUAnimation::Dispatch(Program* program)
+{
+    program->Use();
+    program->setUniform(static_cast<int>(this->nodes.size()), "nodeCount");
+    program->setUniform(this->boneCount, "boneCount");
+    program->setUniform(this->instanceCount, "instanceCount");
+    for (GLuint binding = TRACK_BINDING; binding <= PALETTE_BINDING; ++binding)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, this->buffers[binding]);
+
+    glDispatchCompute((this->instanceCount + LOCAL_SIZE - 1) / LOCAL_SIZE, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+};
+
+void    GPUAnimation::Bind(Program* program)
+{
+    program->setUniform(this->boneCount, "boneCount");
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PALETTE_BINDING, this->buffers[PALETTE_BINDING]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, this->buffers[INSTANCE_BINDING]);
+};
+
+// animation_sample.comp 와 같은 순서, 같은 규칙으로 계산하는 CPU 참조 구현
+void    GPUAnimation::EvaluateReference(std::vector<glm::mat4>& palettes) const
+{
+    auto    findKey = [&](GLint offset, GLint count, float time)
+    {
+        GLint   lo = 0, hi = count - 2;
+        while (lo < hi)
+        {
+            GLint   mid = (lo + hi + 1) / 2;
+            if (this->keyTimes[offset + mid] <= time)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        return (offset + lo);
+    };
+    auto    factor = [&](GLint key, float time)
+    {
+        float   length = this->keyTimes[key + 1] - this->keyTimes[key];
+        if (length <= 0.0f)
+            return (0.0f);
+        return (glm::clamp((time - this->keyTimes[key]) / length, 0.0f, 1.0f));
+    };
+    auto    sampleVec = [&](GLint offset, GLint count, float time)
+    {
+        if (count == 1)
+            return (glm::vec3(this->keyValues[offset]));
+        GLint   key = findKey(offset, count, time);
+        return (glm::mix(glm::vec3(this->keyValues[key]), glm::vec3(this->keyValues[key + 1]), factor(key, time)));
+    };
+    auto    toQuat = [](const glm::vec4& v) { return (glm::quat(v.w, v.x, v.y, v.z)); };
+    auto    sampleQuat = [&](GLint offset, GLint count, float time)
+    {
+        if (count == 1)
+            return (glm::normalize(toQuat(this->keyValues[offset])));
+        GLint   key = findKey(offset, count, time);
+        return (glm::normalize(glm::slerp(toQuat(this->keyValues[key]), toQuat(this->keyValues[key + 1]),
+                                        factor(key, time))));
+    };
+
+    size_t                  nodeCount = this->nodes.size();
+    std::vector<glm::mat4>  globals(nodeCount);
+    palettes.assign(static_cast<size_t>(this->instanceCount) * this->boneCount, glm::mat4(1.0f));
+    for (int instance = 0; instance < this->instanceCount; ++instance)
+    {
+        float   time = this->times[instance];
+        for (size_t i = 0; i < nodeCount; ++i)
+        {
+            const GPUNode&  node = this->nodes[i];
+            glm::mat4       local = node.transformation;
+            if (node.track >= 0)
+            {
+                const GPUTrack& track = this->tracks[node.track];
+                local = glm::translate(glm::mat4(1.0f), sampleVec(track.positionOffset, track.positionCount, time))
+                        * glm::toMat4(sampleQuat(track.rotationOffset, track.rotationCount, time))
+                        * glm::scale(glm::mat4(1.0f), sampleVec(track.scaleOffset, track.scaleCount, time));
+            }
+            globals[i] = node.parent >= 0 ? globals[node.parent] * local : local;
+            if (node.bone >= 0)
+                palettes[static_cast<size_t>(instance) * this->boneCount + node.bone] = globals[i] * node.offset;
+        }
+    }
+};
+
+// Dispatch 이후에 호출한다. GPU 결과와 CPU 참조의 최대 오차를 돌려준다. (소프트웨어 GL 검증용)
+float   GPUAnimation::Validate(void)
+{
+    std::vector<glm::mat4>  reference;
+    std::vector<glm::mat4>  result(static_cast<size_t>(this->instanceCount) * this->boneCount);
+    EvaluateReference(reference);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->buffers[PALETTE_BINDING]);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, result.size() * sizeof(glm::mat4), result.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    float   maxError = 0.0f;
+    for (size_t i = 0; i < result.size(); ++i)
+        for (int col = 0; col < 4; ++col)
+            for (int row = 0; row < 4; ++row)
+                maxError = std::max(maxError, std::abs(result[i][col][row] - reference[i][col][row]));
+    return (maxError);
+};
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef GLBFILE_HPP
+#define GLBFILE_HPP
+
+#include "Common.hpp"
+#include "Json.hpp"
+#include "MappedFile.hpp"
+#include <glm/gtc/quaternion.hpp>
+
+// accessor 하나가 가리키는 맵핑 메모리. element i 의 성분은 data + i * stride 부터 components 개
+struct GlbAccessor
+{
+    const unsigned char*    data { nullptr };
+    size_t                  count { 0 };
+    size_t                  stride { 0 };
+    int                     componentType { 0 };
+    int                     components { 0 };
+    bool                    normalized { false };
+
+    float       ReadFloat(size_t element, int component) const;
+    uint32_t    ReadUint(size_t element, int component) const;
+};
+
+// glTF 2.0 바이너리 컨테이너. 파일을 맵핑해 두고 JSON 청크만 파싱한다.
+// BIN 청크는 복사하지 않으므로 accessor 와 내장 이미지는 이 객체가 살아 있는 동안만 읽을 수 있다.
+class GlbFile
+{
+public:
+    static constexpr int    BYTE = 5120, UNSIGNED_BYTE = 5121, SHORT = 5122, UNSIGNED_SHORT = 5123,
+                            UNSIGNED_INT = 5125, FLOAT = 5126;
+
+    static bool                     CanLoad(const std::string& path);
+    static std::shared_ptr<GlbFile> Open(const std::string& path);
+
+    const JsonValue&    GetJson(void) const { return (this->json); };
+    GlbAccessor         GetAccessor(int index) const;
+    bool                GetBufferView(int index, const unsigned char*& data, size_t& size) const;
+
+    std::vector<int>    GetSceneRoots(void) const;
+    std::string         GetNodeName(int node) const;
+    glm::mat4           GetLocalTransform(int node) const;
+
+    // 내장 이미지는 "<파일 이름>/*<이미지 번호>" 경로로 부른다. 외부 이미지는 uri 그대로
+    std::string         GetImagePath(int image) const;
+    bool                GetEmbeddedImage(const std::string& path, const unsigned char*& data, size_t& size) const;
+private:
+    std::unique_ptr<MappedFile> file;
+    std::string                 name;
+    JsonValue                   json;
+    const unsigned char*        binary { nullptr };
+    size_t                      binarySize { 0 };
+
+    GlbFile() {};
+    void    init(const std::string& path);
+    static int  getComponentCount(const std::string& type);
+    static int  getComponentSize(int componentType);
+};
+
+// 정수 성분은 normalized 면 glTF 규칙대로 [-1, 1] / [0, 1] 로 바꾼다.
+float   GlbAccessor::ReadFloat(size_t element, int component) const
+{
+    const unsigned char*    p = this->data + element * this->stride;
+    switch (this->componentType)
+    {
+        case GlbFile::FLOAT:
+        {
+            float   value;
+            std::memcpy(&value, p + component * sizeof(float), sizeof(float));
+            return (value);
+        }
+        case GlbFile::UNSIGNED_BYTE:
+            return (this->normalized ? p[component] / 255.0f : p[component]);
+        case GlbFile::BYTE:
+        {
+            float   value = static_cast<int8_t>(p[component]);
+            return (this->normalized ? std::max(value / 127.0f, -1.0f) : value);
+        }
+        case GlbFile::UNSIGNED_SHORT:
+        {
+            uint16_t    value;
+            std::memcpy(&value, p + component * sizeof(uint16_t), sizeof(uint16_t));
+            return (this->normalized ? value / 65535.0f : value);
+        }
+        case GlbFile::SHORT:
+        {
+            int16_t value;
+            std::memcpy(&value, p + component * sizeof(int16_t), sizeof(int16_t));
+            return (this->normalized ? std::max(value / 32767.0f, -1.0f) : value);
+        }
+        case GlbFile::UNSIGNED_INT:
+            return (static_cast<float>(ReadUint(element, component)));
+    }
+    return (0.0f);
+};
+
+uint32_t    GlbAccessor::ReadUint(size_t element, int component) const
+{
+    const unsigned char*    p = this->data + element * this->stride;
+    switch (this->componentType)
+    {
+        case GlbFile::UNSIGNED_BYTE:
+            return (p[component]);
+        case GlbFile::UNSIGNED_SHORT:
+        {
+            uint16_t    value;
+            std::memcpy(&value, p + component * sizeof(uint16_t), sizeof(uint16_t));
+            return (value);
+        }
+        case GlbFile::UNSIGNED_INT:
+        {
+            uint32_t    value;
+            std::memcpy(&value, p + component * sizeof(uint32_t), sizeof(uint32_t));
+            return (value);
+        }
+    }
+    return (static_cast<uint32_t>(ReadFloat(element, component)));
+};
+
+bool    GlbFile::CanLoad(const std::string& path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (std::tolower(c)); });
+    return (extension == ".glb");
+};
+
+std::shared_ptr<GlbFile>    GlbFile::Open(const std::string& path)
+{
+    std::shared_ptr<GlbFile>    glb = std::shared_ptr<GlbFile>(new GlbFile());
+    glb->init(path);
+    return (glb);
+};
+
+// header (magic, version, length) 뒤에 JSON 청크와 선택적인 BIN 청크가 온다. 모르는 청크는 건너뛴다.
+void    GlbFile::init(const std::string& path)
+{
+    this->file = MappedFile::Open(path);
+    if (!this->file)
+        throw std::string("Error: Failed to open GLB file: " + path);
+    this->name = std::filesystem::path(path).filename().string();
+
+    const unsigned char*    data = this->file->Data();
+    size_t                  size = this->file->Size();
+    uint32_t                header[3];
+    if (size < sizeof(header))
+        throw std::string("Error: GLB file too small: " + path);
+    std::memcpy(header, data, sizeof(header));
+    if (header[0] != 0x46546C67 || header[1] != 2 || header[2] > size)
+        throw std::string("Error: Not a glTF 2.0 binary: " + path);
+
+    bool    hasJson = false;
+    for (size_t offset = sizeof(header); offset + 8 <= header[2]; )
+    {
+        uint32_t    chunk[2];
+        std::memcpy(chunk, data + offset, sizeof(chunk));
+        offset += sizeof(chunk);
+        if (chunk[0] > header[2] - offset)
+            throw std::string("Error: GLB chunk out of range: " + path);
+        if (chunk[1] == 0x4E4F534A && !hasJson)
+        {
+            const char* text = reinterpret_cast<const char*>(data + offset);
+            this->json = JsonValue::Parse(text, text + chunk[0]);
+            hasJson = true;
+        }
+        else if (chunk[1] == 0x004E4942 && !this->binary)
+        {
+            this->binary = data + offset;
+            this->binarySize = chunk[0];
+        }
+        offset += (chunk[0] + 3) & ~size_t(3);
+    }
+    if (!hasJson)
+        throw std::string("Error: GLB has no JSON chunk: " + path);
+};
+
+int GlbFile::getComponentCount(const std::string& type)
+{
+    if (type == "SCALAR")
+        return (1);
+    if (type == "VEC2")
+        return (2);
+    if (type == "VEC3")
+        return (3);
+    if (type == "VEC4" || type == "MAT2")
+        return (4);
+    if (type == "MAT3")
+        return (9);
+    if (type == "MAT4")
+        return (16);
+    return (0);
+};
+
+int GlbFile::getComponentSize(int componentType)
+{
+    if (componentType == BYTE || componentType == UNSIGNED_BYTE)
+        return (1);
+    if (componentType == SHORT || componentType == UNSIGNED_SHORT)
+        return (2);
+    if (componentType == UNSIGNED_INT || componentType == FLOAT)
+        return (4);
+    return (0);
+};
+
+// GLB 안의 BIN 버퍼(uri 없는 buffer 0)만 읽는다. 외부 .bin 을 쓰는 파일은 .gltf 로 Assimp 경로를 탄다.
+bool    GlbFile::GetBufferView(int index, const unsigned char*& data, size_t& size) const
+{
+    const JsonValue&    view = this->json["bufferViews"][index];
+    if (!view.IsObject() || view["buffer"].GetInt(0) != 0 || this->json["buffers"][0].Has("uri") || !this->binary)
+        return (false);
+    size_t  offset = static_cast<size_t>(view["byteOffset"].GetNumber(0.0));
+    size = static_cast<size_t>(view["byteLength"].GetNumber(0.0));
+    if (offset > this->binarySize || size > this->binarySize - offset)
+        return (false);
+    data = this->binary + offset;
+    return (true);
+};
+
+GlbAccessor GlbFile::GetAccessor(int index) const
+{
+    const JsonValue&    accessor = this->json["accessors"][index];
+    GlbAccessor         result;
+    if (!accessor.IsObject())
+        throw std::string("Error: GLB accessor out of range: " + std::to_string(index));
+    if (accessor.Has("sparse"))
+        throw std::string("Error: Sparse GLB accessors are not supported");
+    result.count = static_cast<size_t>(accessor["count"].GetNumber(0.0));
+    result.componentType = accessor["componentType"].GetInt(0);
+    result.components = getComponentCount(accessor["type"].GetString());
+    result.normalized = accessor["normalized"].GetBool(false);
+    size_t  elementSize = static_cast<size_t>(getComponentSize(result.componentType)) * result.components;
+    if (elementSize == 0)
+        throw std::string("Error: Unknown GLB accessor layout: " + std::to_string(index));
+
+    const unsigned char*    view;
+    size_t                  viewSize;
+    int                     viewIndex = accessor["bufferView"].GetInt(-1);
+    if (viewIndex < 0 || !GetBufferView(viewIndex, view, viewSize))
+        throw std::string("Error: GLB accessor has no readable buffer view: " + std::to_string(index));
+    size_t  offset = static_cast<size_t>(accessor["byteOffset"].GetNumber(0.0));
+    result.stride = static_cast<size_t>(this->json["bufferViews"][viewIndex]["byteStride"].GetNumber(0.0));
+    if (result.stride == 0)
+        result.stride = elementSize;
+    if (result.count && (offset > viewSize || (result.count - 1) * result.stride + elementSize > viewSize - offset))
+        throw std::string("Error: GLB accessor out of buffer view range: " + std::to_string(index));
+    result.data = view + offset;
+    return (result);
+};
+
+std::vector<int>    GlbFile::GetSceneRoots(void) const
+{
+    std::vector<int>    roots;
+    const JsonValue&    scene = this->json["scenes"][static_cast<size_t>(this->json["scene"].GetInt(0))];
+    for (size_t i = 0; i < scene["nodes"].Size(); ++i)
+        roots.push_back(scene["nodes"][i].GetInt());
+    // scenes 가 없으면 어느 노드의 자식도 아닌 노드를 모두 루트로 본다.
+    if (!this->json.Has("scenes"))
+    {
+        const JsonValue&    nodes = this->json["nodes"];
+        std::vector<bool>   isChild(nodes.Size(), false);
+        for (size_t i = 0; i < nodes.Size(); ++i)
+            for (size_t c = 0; c < nodes[i]["children"].Size(); ++c)
+                if (static_cast<size_t>(nodes[i]["children"][c].GetInt(0)) < isChild.size())
+                    isChild[nodes[i]["children"][c].GetInt(0)] = true;
+        for (size_t i = 0; i < nodes.Size(); ++i)
+            if (!isChild[i])
+                roots.push_back(static_cast<int>(i));
+    }
+    return (roots);
+};
+
+// 이름 없는 노드는 번호로 이름을 붙인다. bone 이름과 애니메이션 트랙이 같은 규칙으로 이어진다.
+std::string GlbFile::GetNodeName(int node) const
+{
+    const JsonValue&    name = this->json["nodes"][node]["name"];
+    if (name.IsString() && !name.GetString().empty())
+        return (name.GetString());
+    return ("node_" + std::to_string(node));
+};
+
+// matrix 가 있으면 그대로 (열 우선), 없으면 T * R * S
+glm::mat4   GlbFile::GetLocalTransform(int node) const
+{
+    const JsonValue&    source = this->json["nodes"][node];
+    glm::mat4           transform(1.0f);
+    if (source["matrix"].Size() == 16)
+    {
+        for (int i = 0; i < 16; ++i)
+            transform[i / 4][i % 4] = static_cast<float>(source["matrix"][i].GetNumber());
+        return (transform);
+    }
+    const JsonValue&    t = source["translation"];
+    const JsonValue&    r = source["rotation"];
+    const JsonValue&    s = source["scale"];
+    if (t.Size() == 3)
+        transform = glm::translate(transform, glm::vec3(t[0].GetNumber(), t[1].GetNumber(), t[2].GetNumber()));
+    if (r.Size() == 4)
+        transform = transform * glm::mat4_cast(glm::quat(static_cast<float>(r[3].GetNumber()), static_cast<float>(r[0].GetNumber()),
+                                                        static_cast<float>(r[1].GetNumber()), static_cast<float>(r[2].GetNumber())));
+    if (s.Size() == 3)
+        transform = glm::scale(transform, glm::vec3(s[0].GetNumber(1.0), s[1].GetNumber(1.0), s[2].GetNumber(1.0)));
+    return (transform);
+};
+
+std::string GlbFile::GetImagePath(int image) const
+{
+    const JsonValue&    source = this->json["images"][image];
+    if (source["uri"].IsString() && source["uri"].GetString().compare(0, 5, "data:") != 0)
+        return (source["uri"].GetString());
+    return (this->name + "/*" + std::to_string(image));
+};
+
+bool    GlbFile::GetEmbeddedImage(const std::string& path, const unsigned char*& data, size_t& size) const
+{
+    std::string prefix = this->name + "/*";
+    if (path.compare(0, prefix.size(), prefix) != 0)
+        return (false);
+    int image = std::atoi(path.c_str() + prefix.size());
+    int view = this->json["images"][image]["bufferView"].GetInt(-1);
+    return (view >= 0 && GetBufferView(view, data, size));
+};
+
+#endif
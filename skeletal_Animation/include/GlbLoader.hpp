@@ -0,0 +1,299 @@
+#ifndef GLBLOADER_HPP
+#define GLBLOADER_HPP
+
+#include "Common.hpp"
+#include "Mesh.hpp"
+#include "GlbFile.hpp"
+#include "TangentSpace.hpp"
+#include "ThreadPool.hpp"
+
+// GLB 의 accessor 를 맵핑된 메모리에서 바로 mVertex 로 옮긴다. (Assimp 의 aiScene 을 거치지 않는다)
+// Assimp 와 같은 결과가 나오도록 primitive 하나를 메쉬 하나로 만들고, 텍스처는 경로와 종류만 채워 돌려준다.
+class GlbLoader
+{
+public:
+    // Model: 여러 노드가 같은 mesh 를 쓰면 메쉬는 한 번만 만들고 노드마다 인스턴스를 남긴다.
+    static std::vector<MeshData>    LoadStatic(const GlbFile& file, std::vector<MeshInstance>& instances);
+    // AniModel: 노드 순서대로 primitive 를 모으고, skin 의 joint 를 처음 나온 순서대로 bone 으로 등록한다.
+    static std::vector<MeshData>    LoadSkinned(const GlbFile& file, std::map<std::string, BoneInfo>& boneInfoMap,
+                                                int& boneCount);
+private:
+    // 큰 primitive 의 정점 / 인덱스 변환을 나누는 단위
+    static constexpr size_t CONVERT_GRAIN = 16384;
+
+    struct Primitive
+    {
+        int mesh;
+        int primitive;
+        int skin;
+    };
+    // Assimp glTF2 importer 는 V 를 뒤집어서 읽는다. Model 은 그 위에 aiProcess_FlipUVs 를 한 번 더 건다.
+    struct ConvertOptions
+    {
+        bool    flipV;
+        bool    generateNormals;
+    };
+
+    static void collectNodes(const GlbFile& file, int node, const glm::mat4& parentTransform,
+                            std::vector<std::pair<int, glm::mat4>>& meshNodes, int depth);
+    static std::vector<MeshData>    convertPrimitives(const GlbFile& file, const std::vector<Primitive>& primitives,
+                                                    const ConvertOptions& options,
+                                                    const std::vector<std::vector<int>>& skinBones);
+    static void convertPrimitive(const GlbFile& file, const JsonValue& primitive, const ConvertOptions& options,
+                                const std::vector<int>* joints, MeshData& data);
+    static void readIndices(const GlbFile& file, const JsonValue& primitive, size_t vertexCount, MeshData& data);
+    static std::vector<mTexture>    loadMaterial(const GlbFile& file, int material);
+};
+
+std::vector<MeshData>   GlbLoader::LoadStatic(const GlbFile& file, std::vector<MeshInstance>& instances)
+{
+    const JsonValue&                        json = file.GetJson();
+    std::vector<std::pair<int, glm::mat4>>  meshNodes;
+    for (int root : file.GetSceneRoots())
+        collectNodes(file, root, glm::mat4(1.0f), meshNodes, 0);
+
+    std::vector<int>        firstSlot(json["meshes"].Size(), -1);
+    std::vector<Primitive>  primitives;
+    for (const auto& meshNode : meshNodes)
+    {
+        int                 mesh = json["nodes"][meshNode.first]["mesh"].GetInt();
+        const JsonValue&    source = json["meshes"][mesh]["primitives"];
+        if (mesh < 0 || static_cast<size_t>(mesh) >= firstSlot.size())
+            throw std::string("Error: GLB node references a missing mesh");
+        if (firstSlot[mesh] < 0)
+        {
+            firstSlot[mesh] = static_cast<int>(primitives.size());
+            for (size_t p = 0; p < source.Size(); ++p)
+                primitives.push_back(Primitive { mesh, static_cast<int>(p), -1 });
+        }
+        for (size_t p = 0; p < source.Size(); ++p)
+            instances.push_back(MeshInstance { static_cast<uint32_t>(firstSlot[mesh] + p), meshNode.second });
+    }
+    return (convertPrimitives(file, primitives, ConvertOptions { false, false }, {}));
+};
+
+std::vector<MeshData>   GlbLoader::LoadSkinned(const GlbFile& file, std::map<std::string, BoneInfo>& boneInfoMap,
+                                                int& boneCount)
+{
+    const JsonValue&                        json = file.GetJson();
+    std::vector<std::pair<int, glm::mat4>>  meshNodes;
+    for (int root : file.GetSceneRoots())
+        collectNodes(file, root, glm::mat4(1.0f), meshNodes, 0);
+
+    std::vector<Primitive>          primitives;
+    std::vector<std::vector<int>>   skinBones(json["skins"].Size());
+    for (const auto& meshNode : meshNodes)
+    {
+        const JsonValue&    node = json["nodes"][meshNode.first];
+        int                 mesh = node["mesh"].GetInt();
+        int                 skin = node["skin"].GetInt();
+        if (skin >= 0 && static_cast<size_t>(skin) < skinBones.size() && skinBones[skin].empty())
+        {
+            const JsonValue&    joints = json["skins"][skin]["joints"];
+            int                 inverseBinds = json["skins"][skin]["inverseBindMatrices"].GetInt();
+            GlbAccessor         matrices;
+            if (inverseBinds >= 0)
+                matrices = file.GetAccessor(inverseBinds);
+            for (size_t j = 0; j < joints.Size(); ++j)
+            {
+                std::string name = file.GetNodeName(joints[j].GetInt());
+                auto        bone = boneInfoMap.find(name);
+                if (bone == boneInfoMap.end())
+                {
+                    BoneInfo    info;
+                    info.id = boneCount++;
+                    info.offset = glm::mat4(1.0f);
+                    if (j < matrices.count && matrices.components == 16)
+                        for (int k = 0; k < 16; ++k)
+                            info.offset[k / 4][k % 4] = matrices.ReadFloat(j, k);
+                    bone = boneInfoMap.emplace(name, info).first;
+                }
+                skinBones[skin].push_back(bone->second.id);
+            }
+        }
+        for (size_t p = 0; p < json["meshes"][mesh]["primitives"].Size(); ++p)
+            primitives.push_back(Primitive { mesh, static_cast<int>(p), skin });
+    }
+    return (convertPrimitives(file, primitives, ConvertOptions { true, true }, skinBones));
+};
+
+void    GlbLoader::collectNodes(const GlbFile& file, int node, const glm::mat4& parentTransform,
+                                std::vector<std::pair<int, glm::mat4>>& meshNodes, int depth)
+{
+    const JsonValue&    source = file.GetJson()["nodes"][node];
+    // 순환하는 노드 그래프로 무한히 내려가지 않도록 깊이를 제한한다.
+    if (!source.IsObject() || depth > 256)
+        throw std::string("Error: Invalid GLB node hierarchy");
+    glm::mat4   transform = parentTransform * file.GetLocalTransform(node);
+    if (source.Has("mesh"))
+        meshNodes.emplace_back(node, transform);
+    for (size_t i = 0; i < source["children"].Size(); ++i)
+        collectNodes(file, source["children"][i].GetInt(), transform, meshNodes, depth + 1);
+};
+
+// 텍스처 목록은 여기서 차례로 만들고, 정점 / 인덱스 변환만 작업자 스레드에서 돌린다.
+std::vector<MeshData>   GlbLoader::convertPrimitives(const GlbFile& file, const std::vector<Primitive>& primitives,
+                                                    const ConvertOptions& options,
+                                                    const std::vector<std::vector<int>>& skinBones)
+{
+    const JsonValue&        meshes = file.GetJson()["meshes"];
+    std::vector<MeshData>   meshData(primitives.size());
+    for (size_t i = 0; i < primitives.size(); ++i)
+        meshData[i].textures = loadMaterial(file, meshes[primitives[i].mesh]["primitives"][primitives[i].primitive]["material"].GetInt());
+    ThreadPool::Get().ParallelFor(primitives.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const Primitive&    primitive = primitives[i];
+            const JsonValue&    source = meshes[primitive.mesh]["primitives"][primitive.primitive];
+            const std::vector<int>* joints = primitive.skin >= 0 && static_cast<size_t>(primitive.skin) < skinBones.size()
+                                            ? &skinBones[primitive.skin] : nullptr;
+            convertPrimitive(file, source, options, joints, meshData[i]);
+        }
+    });
+    return (meshData);
+};
+
+void    GlbLoader::convertPrimitive(const GlbFile& file, const JsonValue& primitive, const ConvertOptions& options,
+                                    const std::vector<int>* joints, MeshData& data)
+{
+    const JsonValue&    attributes = primitive["attributes"];
+    int                 mode = primitive["mode"].GetInt(4);
+    // 점, 선 primitive 는 Triangulate 후에도 삼각형 메쉬가 아니므로 그리지 않는다.
+    if (mode < 4 || mode > 6 || attributes["POSITION"].GetInt() < 0)
+        return ;
+
+    GlbAccessor positions = file.GetAccessor(attributes["POSITION"].GetInt());
+    GlbAccessor normals, texCoords, tangents, jointIndices, weights;
+    if (attributes.Has("NORMAL"))
+        normals = file.GetAccessor(attributes["NORMAL"].GetInt());
+    if (attributes.Has("TEXCOORD_0"))
+        texCoords = file.GetAccessor(attributes["TEXCOORD_0"].GetInt());
+    if (attributes.Has("TANGENT"))
+        tangents = file.GetAccessor(attributes["TANGENT"].GetInt());
+    if (joints && attributes.Has("JOINTS_0") && attributes.Has("WEIGHTS_0"))
+    {
+        jointIndices = file.GetAccessor(attributes["JOINTS_0"].GetInt());
+        weights = file.GetAccessor(attributes["WEIGHTS_0"].GetInt());
+    }
+    size_t  vertexCount = positions.count;
+    for (const GlbAccessor* accessor : { &normals, &texCoords, &tangents, &jointIndices, &weights })
+        if (accessor->data && accessor->count < vertexCount)
+            throw std::string("Error: GLB vertex attribute shorter than POSITION");
+
+    data.vertices.resize(vertexCount);
+    ThreadPool::Get().ParallelFor(vertexCount, CONVERT_GRAIN, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            mVertex&    vertex = data.vertices[i];
+            vertex.position = glm::vec3(positions.ReadFloat(i, 0), positions.ReadFloat(i, 1), positions.ReadFloat(i, 2));
+            vertex.normal = normals.data ? glm::vec3(normals.ReadFloat(i, 0), normals.ReadFloat(i, 1), normals.ReadFloat(i, 2))
+                                        : glm::vec3(0.0f);
+            vertex.texCoords = glm::vec2(0.0f);
+            if (texCoords.data)
+            {
+                float   v = texCoords.ReadFloat(i, 1);
+                vertex.texCoords = glm::vec2(texCoords.ReadFloat(i, 0), options.flipV ? 1.0f - v : v);
+            }
+            // glTF 탄젠트도 MikkTSpace 규칙이다. V 를 뒤집으면 bitangent 방향이 바뀌므로 w 부호도 뒤집는다.
+            vertex.tangent = glm::vec4(0.0f);
+            if (tangents.data && texCoords.data)
+            {
+                bool    mirrored = (tangents.components > 3 && tangents.ReadFloat(i, 3) < 0.0f) != options.flipV;
+                vertex.tangent = glm::vec4(tangents.ReadFloat(i, 0), tangents.ReadFloat(i, 1), tangents.ReadFloat(i, 2),
+                                        mirrored ? -1.0f : 1.0f);
+            }
+            int slot = 0;
+            for (int j = 0; j < MAX_BONE_INFLUENCE; ++j)
+            {
+                vertex.boneIDs[j] = -1;
+                vertex.weights[j] = 0.0f;
+            }
+            for (int j = 0; jointIndices.data && j < 4; ++j)
+            {
+                uint32_t    joint = jointIndices.ReadUint(i, j);
+                float       weight = weights.ReadFloat(i, j);
+                if (weight <= 0.0f || joint >= joints->size())
+                    continue ;
+                vertex.boneIDs[slot] = (*joints)[joint];
+                vertex.weights[slot++] = weight;
+            }
+        }
+    });
+    readIndices(file, primitive, vertexCount, data);
+
+    if (!normals.data && options.generateNormals)
+        TangentSpace::GenerateNormals(data);
+    if (texCoords.data && !tangents.data)
+        TangentSpace::GenerateTangents(data);
+};
+
+// TRIANGLES 는 그대로, TRIANGLE_STRIP / FAN 은 삼각형 목록으로 푼다. 인덱스가 없으면 정점 순서대로
+void    GlbLoader::readIndices(const GlbFile& file, const JsonValue& primitive, size_t vertexCount, MeshData& data)
+{
+    int                     mode = primitive["mode"].GetInt(4);
+    std::vector<GLuint>     source;
+    if (primitive.Has("indices"))
+    {
+        GlbAccessor indices = file.GetAccessor(primitive["indices"].GetInt());
+        source.resize(indices.count);
+        std::atomic<bool>   outOfRange { false };
+        ThreadPool::Get().ParallelFor(indices.count, CONVERT_GRAIN, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                source[i] = indices.ReadUint(i, 0);
+                if (source[i] >= vertexCount)
+                    outOfRange = true;
+            }
+        });
+        if (outOfRange)
+            throw std::string("Error: GLB index out of range");
+    }
+    else
+    {
+        source.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i)
+            source[i] = static_cast<GLuint>(i);
+    }
+
+    if (mode == 4)
+    {
+        source.resize(source.size() - source.size() % 3);
+        data.indices = std::move(source);
+        return ;
+    }
+    for (size_t i = 2; i < source.size(); ++i)
+    {
+        if (mode == 6)
+            data.indices.insert(data.indices.end(), { source[0], source[i - 1], source[i] });
+        else if (i % 2 == 0)
+            data.indices.insert(data.indices.end(), { source[i - 2], source[i - 1], source[i] });
+        else
+            data.indices.insert(data.indices.end(), { source[i - 1], source[i - 2], source[i] });
+    }
+};
+
+// baseColorTexture 는 texture_diffuse, normalTexture 는 texture_normal 로 쓴다.
+std::vector<mTexture>   GlbLoader::loadMaterial(const GlbFile& file, int material)
+{
+    const JsonValue&        json = file.GetJson();
+    const JsonValue&        source = json["materials"][material];
+    std::vector<mTexture>   textures;
+    auto    addTexture = [&](const JsonValue& info, const std::string& typeName)
+    {
+        int image = json["textures"][info["index"].GetInt()]["source"].GetInt();
+        if (image >= 0 && static_cast<size_t>(image) < json["images"].Size())
+            textures.push_back(mTexture { 0, typeName, file.GetImagePath(image), nullptr, nullptr, -1 });
+    };
+    if (source.IsNull())
+        return (textures);
+    if (source["pbrMetallicRoughness"].Has("baseColorTexture"))
+        addTexture(source["pbrMetallicRoughness"]["baseColorTexture"], "texture_diffuse");
+    if (source.Has("normalTexture"))
+        addTexture(source["normalTexture"], "texture_normal");
+    return (textures);
+};
+
+#endif
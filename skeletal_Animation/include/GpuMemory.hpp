@@ -0,0 +1,186 @@
+#ifndef GPUMEMORY_HPP
+#define GPUMEMORY_HPP
+
+#include "Common.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+
+// GL 버퍼, 텍스처, 렌더버퍼가 차지하는 VRAM 장부. 자원을 만드는 곳에서 Track, 지우는 곳에서 Release 를 부른다.
+// 크기는 드라이버가 실제로 잡는 양이 아니라 올린 데이터 기준의 추정치다. (mip 사슬 포함, 정렬 / 패딩 제외)
+// 같은 이름을 다시 Track 하면 (glBufferData 로 다시 잡는 경우 등) 크기와 주인만 바꾼다.
+// 지운 자원이 남아 있거나 합계가 계속 늘면 Release 를 빠뜨린 곳이 있다는 뜻이다.
+class GpuMemory
+{
+public:
+    static constexpr int    BUFFER = 0;
+    static constexpr int    TEXTURE = 1;
+    static constexpr int    RENDERBUFFER = 2;
+    static constexpr int    CATEGORY_COUNT = 3;
+
+    struct Allocation
+    {
+        int         category { BUFFER };
+        GLuint      name { 0 };
+        size_t      size { 0 };
+        std::string owner;
+    };
+
+    static GpuMemory&   Get(void);
+    static const char*  GetCategoryName(int category);
+    // 압축하지 않은 sized / unsized 내부 형식의 텍셀 하나 크기. 모르는 형식은 4 바이트로 본다.
+    static size_t       GetTexelSize(GLenum internalFormat);
+
+    void    Track(int category, GLuint name, size_t size, const std::string& owner);
+    void    Release(int category, GLuint name);
+
+    size_t  GetTotal(void) const;
+    size_t  GetTotal(int category) const;
+    size_t  GetPeak(void) const;
+    size_t  GetCount(void) const;
+    void    ResetPeak(void);
+    // 큰 것부터 count 개
+    std::vector<Allocation> GetLargest(size_t count) const;
+    void    Dump(std::ostream& os = std::cout, size_t count = 10) const;
+private:
+    std::map<std::pair<int, GLuint>, Allocation>    allocations;
+    size_t              totals[CATEGORY_COUNT] { 0, 0, 0 };
+    size_t              total { 0 }, peak { 0 };
+    mutable std::mutex  mutex;
+
+    GpuMemory() {};
+};
+
+GpuMemory&  GpuMemory::Get(void)
+{
+    static GpuMemory    memory;
+    return (memory);
+};
+
+const char* GpuMemory::GetCategoryName(int category)
+{
+    if (category == TEXTURE)
+        return ("texture");
+    if (category == RENDERBUFFER)
+        return ("renderbuffer");
+    return ("buffer");
+};
+
+size_t  GpuMemory::GetTexelSize(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_RED: case GL_R8:
+        return (1);
+    case GL_RG: case GL_RG8: case GL_R16F:
+        return (2);
+    case GL_RGB: case GL_RGB8: case GL_SRGB8:
+        return (3);
+    case GL_RGB16F:
+        return (6);
+    case GL_RGBA16F: case GL_RG32F:
+        return (8);
+    case GL_RGB32F:
+        return (12);
+    case GL_RGBA32F:
+        return (16);
+    default:
+        return (4);
+    }
+};
+
+void    GpuMemory::Track(int category, GLuint name, size_t size, const std::string& owner)
+{
+    if (!name)
+        return ;
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Allocation& allocation = this->allocations[std::make_pair(category, name)];
+    this->totals[category] -= allocation.size;
+    this->total -= allocation.size;
+    allocation.category = category;
+    allocation.name = name;
+    allocation.size = size;
+    allocation.owner = owner;
+    this->totals[category] += size;
+    this->total += size;
+    this->peak = std::max(this->peak, this->total);
+};
+
+// 장부에 없는 이름은 무시한다. (Track 전에 실패한 자원 등)
+void    GpuMemory::Release(int category, GLuint name)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto    allocation = this->allocations.find(std::make_pair(category, name));
+    if (allocation == this->allocations.end())
+        return ;
+    this->totals[category] -= allocation->second.size;
+    this->total -= allocation->second.size;
+    this->allocations.erase(allocation);
+};
+
+size_t  GpuMemory::GetTotal(void) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return (this->total);
+};
+
+size_t  GpuMemory::GetTotal(int category) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return (this->totals[category]);
+};
+
+size_t  GpuMemory::GetPeak(void) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return (this->peak);
+};
+
+size_t  GpuMemory::GetCount(void) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return (this->allocations.size());
+};
+
+// 로딩이 끝난 뒤 등 구간별 최고치를 보고 싶을 때 지금 합계에서 다시 잰다.
+void    GpuMemory::ResetPeak(void)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->peak = this->total;
+};
+
+std::vector<GpuMemory::Allocation>  GpuMemory::GetLargest(size_t count) const
+{
+    std::vector<Allocation> largest;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        largest.reserve(this->allocations.size());
+        for (const auto& allocation : this->allocations)
+            largest.push_back(allocation.second);
+    }
+    count = std::min(count, largest.size());
+    std::partial_sort(largest.begin(), largest.begin() + count, largest.end(),
+                    [](const Allocation& a, const Allocation& b) { return (a.size > b.size); });
+    largest.resize(count);
+    return (largest);
+};
+
+void    GpuMemory::Dump(std::ostream& os, size_t count) const
+{
+    const double            MB = 1024.0 * 1024.0;
+    std::vector<Allocation> largest = GetLargest(count);
+    std::ios                state(nullptr);
+    state.copyfmt(os);
+    os << std::fixed << std::setprecision(2)
+        << "GPU memory: " << GetTotal() / MB << " MB in " << GetCount() << " allocations (peak "
+        << GetPeak() / MB << " MB)\n";
+    for (int category = 0; category < CATEGORY_COUNT; ++category)
+        os << std::setw(14) << GetCategoryName(category) << std::setw(10) << GetTotal(category) / MB << " MB\n";
+    for (const Allocation& allocation : largest)
+        os << std::setw(14) << GetCategoryName(allocation.category) << std::setw(10) << allocation.size / MB
+            << " MB  #" << allocation.name << "  " << allocation.owner << "\n";
+    os.flush();
+    os.copyfmt(state);
+};
+
+#endif
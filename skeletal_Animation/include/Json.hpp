@@ -0,0 +1,280 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include "Common.hpp"
+#include <cstdlib>
+#include <cstring>
+
+// glTF 헤더를 읽는 데 필요한 만큼의 JSON DOM. 문서는 작으므로 객체 키는 순서대로 찾는다.
+// 없는 키나 범위 밖 인덱스는 null 값을 돌려주므로 기본값과 함께 바로 꺼내 쓸 수 있다.
+class JsonValue
+{
+public:
+    static constexpr int    TYPE_NULL = 0, TYPE_BOOL = 1, TYPE_NUMBER = 2, TYPE_STRING = 3,
+                            TYPE_ARRAY = 4, TYPE_OBJECT = 5;
+
+    static JsonValue    Parse(const char* begin, const char* end);
+
+    int     GetType(void) const { return (this->type); };
+    bool    IsNull(void) const { return (this->type == TYPE_NULL); };
+    bool    IsNumber(void) const { return (this->type == TYPE_NUMBER); };
+    bool    IsString(void) const { return (this->type == TYPE_STRING); };
+    bool    IsArray(void) const { return (this->type == TYPE_ARRAY); };
+    bool    IsObject(void) const { return (this->type == TYPE_OBJECT); };
+    bool    Has(const std::string& key) const { return (find(key) != nullptr); };
+    size_t  Size(void) const { return (this->values.size()); };
+
+    const JsonValue&    operator[](const std::string& key) const;
+    const JsonValue&    operator[](size_t index) const;
+    const JsonValue&    operator[](int index) const
+    { return (index < 0 ? null() : (*this)[static_cast<size_t>(index)]); };
+    double              GetNumber(double fallback = 0.0) const
+    { return (this->type == TYPE_NUMBER ? this->number : fallback); };
+    int                 GetInt(int fallback = -1) const
+    { return (this->type == TYPE_NUMBER ? static_cast<int>(this->number) : fallback); };
+    bool                GetBool(bool fallback = false) const
+    { return (this->type == TYPE_BOOL ? this->boolean : fallback); };
+    const std::string&  GetString(void) const { return (this->text); };
+    const std::vector<std::string>& GetKeys(void) const { return (this->keys); };
+private:
+    int                         type { TYPE_NULL };
+    bool                        boolean { false };
+    double                      number { 0.0 };
+    std::string                 text;
+    // 배열은 values 만, 객체는 keys[i] -> values[i]
+    std::vector<std::string>    keys;
+    std::vector<JsonValue>      values;
+
+    const JsonValue*    find(const std::string& key) const;
+    static const JsonValue& null(void);
+
+    static void         skipSpace(const char*& p, const char* end);
+    static JsonValue    parseValue(const char*& p, const char* end, int depth);
+    static std::string  parseString(const char*& p, const char* end);
+    static void         appendUtf8(std::string& out, uint32_t codePoint);
+};
+
+JsonValue   JsonValue::Parse(const char* begin, const char* end)
+{
+    const char* p = begin;
+    JsonValue   value = parseValue(p, end, 0);
+    skipSpace(p, end);
+    // GLB 의 JSON 청크는 4 바이트 정렬을 위해 공백으로 채워져 있다. 그 뒤에 다른 것이 있으면 잘못된 문서다.
+    while (p < end && *p == '\0')
+        ++p;
+    if (p != end)
+        throw std::string("Error: Trailing data after JSON document");
+    return (value);
+};
+
+const JsonValue&    JsonValue::operator[](const std::string& key) const
+{
+    const JsonValue*    value = find(key);
+    return (value ? *value : null());
+};
+
+const JsonValue&    JsonValue::operator[](size_t index) const
+{
+    if (this->type != TYPE_ARRAY || index >= this->values.size())
+        return (null());
+    return (this->values[index]);
+};
+
+const JsonValue*    JsonValue::find(const std::string& key) const
+{
+    if (this->type != TYPE_OBJECT)
+        return (nullptr);
+    for (size_t i = 0; i < this->keys.size(); ++i)
+        if (this->keys[i] == key)
+            return (&this->values[i]);
+    return (nullptr);
+};
+
+const JsonValue&    JsonValue::null(void)
+{
+    static const JsonValue  value;
+    return (value);
+};
+
+void    JsonValue::skipSpace(const char*& p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        ++p;
+};
+
+JsonValue   JsonValue::parseValue(const char*& p, const char* end, int depth)
+{
+    // 잘못 만든 파일이 스택을 넘치게 하지 않도록 중첩 깊이를 제한한다.
+    if (depth > 256)
+        throw std::string("Error: JSON nesting too deep");
+    skipSpace(p, end);
+    if (p >= end)
+        throw std::string("Error: Unexpected end of JSON");
+
+    JsonValue   value;
+    if (*p == '{')
+    {
+        value.type = TYPE_OBJECT;
+        skipSpace(++p, end);
+        if (p < end && *p == '}')
+        {
+            ++p;
+            return (value);
+        }
+        while (true)
+        {
+            skipSpace(p, end);
+            value.keys.push_back(parseString(p, end));
+            skipSpace(p, end);
+            if (p >= end || *p != ':')
+                throw std::string("Error: Expected ':' in JSON object");
+            value.values.push_back(parseValue(++p, end, depth + 1));
+            skipSpace(p, end);
+            if (p < end && *p == ',')
+            {
+                ++p;
+                continue ;
+            }
+            if (p < end && *p == '}')
+            {
+                ++p;
+                return (value);
+            }
+            throw std::string("Error: Expected ',' or '}' in JSON object");
+        }
+    }
+    if (*p == '[')
+    {
+        value.type = TYPE_ARRAY;
+        skipSpace(++p, end);
+        if (p < end && *p == ']')
+        {
+            ++p;
+            return (value);
+        }
+        while (true)
+        {
+            value.values.push_back(parseValue(p, end, depth + 1));
+            skipSpace(p, end);
+            if (p < end && *p == ',')
+            {
+                ++p;
+                continue ;
+            }
+            if (p < end && *p == ']')
+            {
+                ++p;
+                return (value);
+            }
+            throw std::string("Error: Expected ',' or ']' in JSON array");
+        }
+    }
+    if (*p == '"')
+    {
+        value.type = TYPE_STRING;
+        value.text = parseString(p, end);
+        return (value);
+    }
+    if (end - p >= 4 && std::strncmp(p, "true", 4) == 0)
+    {
+        value.type = TYPE_BOOL;
+        value.boolean = true;
+        p += 4;
+        return (value);
+    }
+    if (end - p >= 5 && std::strncmp(p, "false", 5) == 0)
+    {
+        value.type = TYPE_BOOL;
+        p += 5;
+        return (value);
+    }
+    if (end - p >= 4 && std::strncmp(p, "null", 4) == 0)
+    {
+        p += 4;
+        return (value);
+    }
+
+    // 청크 끝에 널 문자가 없으므로 숫자 토큰만 잘라서 strtod 에 넘긴다.
+    const char* start = p;
+    while (p < end && ((*p && std::strchr("+-.eE", *p)) || (*p >= '0' && *p <= '9')))
+        ++p;
+    std::string token(start, p);
+    char*       parsed = nullptr;
+    value.number = std::strtod(token.c_str(), &parsed);
+    if (token.empty() || parsed != token.c_str() + token.size())
+        throw std::string("Error: Invalid JSON value");
+    value.type = TYPE_NUMBER;
+    return (value);
+};
+
+std::string JsonValue::parseString(const char*& p, const char* end)
+{
+    if (p >= end || *p != '"')
+        throw std::string("Error: Expected JSON string");
+    std::string out;
+    for (++p; p < end && *p != '"'; ++p)
+    {
+        if (*p != '\\')
+        {
+            out.push_back(*p);
+            continue ;
+        }
+        if (++p >= end)
+            break ;
+        switch (*p)
+        {
+            case 'b': out.push_back('\b'); break ;
+            case 'f': out.push_back('\f'); break ;
+            case 'n': out.push_back('\n'); break ;
+            case 'r': out.push_back('\r'); break ;
+            case 't': out.push_back('\t'); break ;
+            case 'u':
+            {
+                if (end - p < 5)
+                    throw std::string("Error: Invalid JSON escape");
+                uint32_t    codePoint = static_cast<uint32_t>(std::strtoul(std::string(p + 1, p + 5).c_str(), nullptr, 16));
+                p += 4;
+                // 서로게이트 쌍은 다음 \uXXXX 와 합친다.
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - p >= 7 && p[1] == '\\' && p[2] == 'u')
+                {
+                    uint32_t    low = static_cast<uint32_t>(std::strtoul(std::string(p + 3, p + 7).c_str(), nullptr, 16));
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                appendUtf8(out, codePoint);
+                break ;
+            }
+            default: out.push_back(*p); break ;
+        }
+    }
+    if (p >= end)
+        throw std::string("Error: Unterminated JSON string");
+    ++p;
+    return (out);
+};
+
+void    JsonValue::appendUtf8(std::string& out, uint32_t codePoint)
+{
+    if (codePoint < 0x80)
+        out.push_back(static_cast<char>(codePoint));
+    else if (codePoint < 0x800)
+    {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include "Common.hpp"
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    // Camera / MathOP 의 near, far 인자와 겹치는 매크로
+    #undef near
+    #undef far
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// 읽기 전용 메모리 맵 파일. 파일 내용을 복사하지 않고 포인터로 바로 읽는다.
+class MappedFile
+{
+public:
+    static std::unique_ptr<MappedFile>  Open(const std::filesystem::path& filePath);
+
+    ~MappedFile();
+
+    const unsigned char*    Data(void) const { return (this->data); };
+    size_t                  Size(void) const { return (this->size); };
+private:
+    const unsigned char*    data { nullptr };
+    size_t                  size { 0 };
+#ifdef _WIN32
+    HANDLE  file { INVALID_HANDLE_VALUE };
+    HANDLE  mapping { nullptr };
+#else
+    int     fd { -1 };
+#endif
+
+    MappedFile() {};
+    bool    init(const std::filesystem::path& filePath);
+};
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& filePath)
+{
+    std::unique_ptr<MappedFile> mappedFile = std::unique_ptr<MappedFile>(new MappedFile());
+    if (!mappedFile->init(filePath))
+        return (nullptr);
+    return (std::move(mappedFile));
+};
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (this->data)
+        UnmapViewOfFile(this->data);
+    if (this->mapping)
+        CloseHandle(this->mapping);
+    if (this->file != INVALID_HANDLE_VALUE)
+        CloseHandle(this->file);
+#else
+    if (this->data)
+        munmap(const_cast<unsigned char*>(this->data), this->size);
+    if (this->fd >= 0)
+        close(this->fd);
+#endif
+};
+
+bool    MappedFile::init(const std::filesystem::path& filePath)
+{
+#ifdef _WIN32
+    this->file = CreateFileW(filePath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE)
+        return (false);
+    LARGE_INTEGER   fileSize;
+    if (!GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0)
+        return (false);
+    this->size = static_cast<size_t>(fileSize.QuadPart);
+    this->mapping = CreateFileMappingW(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!this->mapping)
+        return (false);
+    this->data = static_cast<const unsigned char*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    return (this->data != nullptr);
+#else
+    this->fd = open(filePath.c_str(), O_RDONLY);
+    if (this->fd < 0)
+        return (false);
+    struct stat fileStat;
+    if (fstat(this->fd, &fileStat) != 0 || fileStat.st_size == 0)
+        return (false);
+    this->size = static_cast<size_t>(fileStat.st_size);
+    void*   mapped = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if (mapped == MAP_FAILED)
+        return (false);
+    this->data = static_cast<const unsigned char*>(mapped);
+    return (true);
+#endif
+};
+
+#endif
@@ -2,7 +2,10 @@
 #define MESH_HPP
 
 #include "Common.hpp"
+#include "GpuMemory.hpp"
 #include "Program.hpp"
+#include "TextureCache.hpp"
+#include "Meshlet.hpp"
 
 #define MAX_BONE_INFLUENCE 4
 
@@ -11,55 +14,312 @@ struct mVertex
     glm::vec3   position;
     glm::vec3   normal;
     glm::vec2   texCoords;
-    glm::vec3   tangent;
+    // xyz 는 탄젠트, w 는 UV 방향 부호 (B = cross(N, T) * w)
+    glm::vec4   tangent;
     int         boneIDs[MAX_BONE_INFLUENCE];
     float       weights[MAX_BONE_INFLUENCE];
 };
 
+// 텍스처 배열로 묶어 올렸으면 handle 대신 array 와 그 안의 layer 를 쓴다. (id 는 배열의 id)
 struct mTexture
 {
     GLuint      id;
     std::string type;
     std::string path;
+    std::shared_ptr<TextureHandle>  handle;
+    std::shared_ptr<TextureArray>   array;
+    GLint                           layer { -1 };
 };
 
-class Mesh
+struct  BoneInfo
+{
+    int         id;
+    glm::mat4   offset;
+};
+
+// 인덱스 버퍼 안의 LOD 한 단계. error 는 원본과의 거리 오차 (모델 좌표계)
+struct MeshLod
+{
+    uint32_t    indexOffset;
+    uint32_t    indexCount;
+    float       error;
+};
+
+// GL 에 올리기 전의 메쉬. Assimp 에서 변환했거나 캐시에서 읽은 최종 정점/인덱스 버퍼
+// LOD 가 있으면 indices 에 LOD0, LOD1, ... 순서로 이어 붙어 있다.
+struct MeshData
 {
-public:
     std::vector<mVertex>    vertices;
     std::vector<GLuint>     indices;
     std::vector<mTexture>   textures;
+    std::vector<MeshLod>    lods;
+    glm::vec4               bounds { 0.0f };
+    std::vector<Meshlet>    meshlets;
+};
+
+// 씬 노드 하나가 참조하는 메쉬와 그 노드의 월드 변환
+struct MeshInstance
+{
+    uint32_t    mesh;
+    glm::mat4   transform;
+};
+
+// 모델 공용 버퍼 안에서 메쉬 하나가 차지하는 위치
+struct MeshRange
+{
+    GLint       baseVertex { 0 };
+    uint32_t    firstIndex { 0 };
+};
+
+// 충돌 검사용으로 남겨 두는 CPU 쪽 형상. LOD0 의 위치와 인덱스만 담는다.
+struct CollisionMesh
+{
+    std::vector<glm::vec3>  positions;
+    std::vector<GLuint>     indices;
+};
+
+// import 때 돌리는 최적화 옵션. 바뀌면 메쉬 캐시도 다시 만든다.
+struct MeshImportOptions
+{
+    float           weldEpsilon { 0.0f };
+    unsigned int    lodLevels { 1 };
+    bool            buildMeshlets { false };
+};
+
+
+// GL 버퍼를 소유하므로 복사할 수 없고 이동만 된다.
+// 정점/인덱스는 GPU 에 올린 뒤 CPU 쪽에 남기지 않는다. 충돌 검사가 필요하면 CollisionMesh 만 따로 붙인다.
+// 위치는 interleaved 정점과 별도로 vec3 스트림에도 올려서, 깊이 전용 패스는 정점당 12 바이트만 읽는다.
+class Mesh
+{
+public:
+    std::vector<mTexture>   textures;
 
-    Mesh(std::vector<mVertex> vertices, std::vector<unsigned int> indices, std::vector<mTexture> textures);
+    Mesh(std::vector<mVertex>&& vertices, std::vector<GLuint>&& indices, std::vector<mTexture>&& textures);
+    Mesh(const mVertex* vertices, size_t vertexCount, const void* indices, size_t indexCount, GLenum indexType,
+        std::vector<mTexture>&& textures);
+    Mesh(GLuint sharedVAO, GLuint sharedDepthVAO, GLenum indexType, const MeshRange& range, size_t indexCount,
+        std::vector<mTexture>&& textures);
+    Mesh(const Mesh&) = delete;
+    Mesh(Mesh&& other) noexcept;
     ~Mesh();
-    void    Draw(Program* program);
+
+    Mesh&   operator=(const Mesh&) = delete;
+    Mesh&   operator=(Mesh&& other) noexcept;
+
+    // 노드 인스턴스 변환 (mat4) 이 들어가는 attribute 위치. 6 ~ 9 를 쓴다.
+    static constexpr GLuint INSTANCE_ATTRIB = 6;
+    // 재질 텍스처 배열의 층 번호 (ivec4). 배열 없이 고정값으로 넣으므로 draw 마다 바뀐다.
+    static constexpr GLuint MATERIAL_ATTRIB = 10;
+    // 재질 종류마다 고정한 텍스처 유닛 / 층 번호 자리. 샘플러 이름은 mTexture::type 과 같다.
+    static constexpr int            MATERIAL_SLOTS = 4;
+    static constexpr const char*    MATERIAL_NAMES[MATERIAL_SLOTS] = { "texture_diffuse", "texture_specular",
+                                                                    "texture_normal", "texture_height" };
+
+    static GLenum   ChooseIndexType(size_t vertexCount)
+    { return (vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT); };
+    static void     SetupVertexAttributes(void);
+    static void     SetupPositionAttribute(void);
+    static std::vector<glm::vec3>   ExtractPositions(const mVertex* vertices, size_t vertexCount);
+    static int      GetMaterialSlot(const std::string& type);
+    static void     BeginMaterials(Program* program);
+    static CollisionMesh    MakeCollision(const mVertex* vertices, size_t vertexCount, const void* indices,
+                                        size_t indexCount, GLenum indexType);
+    void    Draw(void);
+    void    DrawInstanced(GLsizei instanceCount);
+    void    DrawDepth(void);
+
+    void    SetLods(const std::vector<MeshLod>& lods, const glm::vec4& bounds);
+    size_t  SelectLod(const glm::mat4& model, const glm::vec3& cameraPos, float fovy, float viewportHeight);
+    size_t  GetLodCount(void) const { return (this->lods.size()); };
+    size_t  GetCurrentLod(void) const { return (this->currentLod); };
+    void    RequestTextureDetail(const glm::mat4& model, const glm::vec3& cameraPos, float fovy,
+                                float viewportHeight) const;
+
+    void    SetMeshlets(std::vector<Meshlet> meshlets) { this->meshlets = std::move(meshlets); };
+    void    DrawCulled(const glm::mat4& model, const Frustum& frustum, const glm::vec3& cameraPos);
+    size_t  GetMeshletCount(void) const { return (this->meshlets.size()); };
+    size_t  GetVisibleMeshletCount(void) const { return (this->visibleMeshlets); };
+
+    void        SetInstances(GLuint buffer, uint32_t first, uint32_t count);
+    uint32_t    GetFirstInstance(void) const { return (this->firstInstance); };
+    uint32_t    GetInstanceCount(void) const { return (this->instanceCount); };
+    const glm::vec4&    GetBounds(void) const { return (this->bounds); };
+
+    void    SetCollision(CollisionMesh&& collision)
+    { this->collision = std::unique_ptr<CollisionMesh>(new CollisionMesh(std::move(collision))); };
+    const CollisionMesh*    GetCollision(void) const { return (this->collision.get()); };
 private:
-    GLuint  VAO, VBO, EBO;
+    GLuint  VAO { 0 }, VBO { 0 }, EBO { 0 };
+    // 위치 스트림과 그것만 묶은 깊이 패스용 VAO. EBO 는 VAO 와 같이 쓴다.
+    GLuint  depthVAO { 0 }, positionVBO { 0 };
+    size_t  indexCount;
+    GLenum  indexType;
+    // 공용 버퍼를 쓰면 VAO 는 모델이 한 번만 바인드하고, 메쉬는 자기 구간만 그린다.
+    bool        sharedBuffer { false };
+    MeshRange   range;
+    std::vector<GLint>      drawBaseVertices;
+    std::vector<MeshLod>    lods;
+    glm::vec4               bounds { 0.0f };
+    size_t                  currentLod { 0 };
+    std::vector<Meshlet>    meshlets;
+    size_t                  visibleMeshlets { 0 };
+    std::vector<GLsizei>    drawCounts;
+    std::vector<void*>      drawOffsets;
+    std::unique_ptr<CollisionMesh>  collision;
+    // 노드 인스턴스 변환 버퍼 (모델 소유) 안에서 이 메쉬의 구간
+    GLuint      instanceBuffer { 0 };
+    uint32_t    firstInstance { 0 }, instanceCount { 1 };
+
+    // 화면에서 오차가 이 픽셀 수보다 작으면 더 거친 LOD 로 내려간다.
+    static constexpr float  LOD_PIXEL_ERROR = 1.0f;
+    // 거친 쪽으로 갈 때는 기준을 더 낮게 잡아서 경계 거리에서 LOD 가 깜빡이지 않게 한다.
+    static constexpr float  LOD_HYSTERESIS = 0.75f;
+    // 텍스처가 메쉬 구 지름에 한 번 펴진다고 보고 구한 픽셀 수에 곱한다. 타일링하는 재질 때문에 한 레벨 더 자세히 잡는다.
+    static constexpr float  TEXTURE_DETAIL_SCALE = 2.0f;
 
-    void    setupMesh(void);
+    void    setupMesh(const mVertex* vertices, size_t vertexCount, const void* indices, size_t indexCount,
+                    GLenum indexType);
+    void    releaseBuffers(void);
+    void    bindMaterial(void) const;
+    static std::array<GLuint, MATERIAL_SLOTS>&  getBoundMaterials(void);
+    static const std::array<std::shared_ptr<TextureArray>, MATERIAL_SLOTS>& getDefaultMaterials(void);
+    void    bindVertexArray(void) const;
+    void    bindDepthArray(void) const;
+    void    bindInstances(void) const;
+    void    unbindVertexArray(void) const;
+    void*   getIndexOffset(uint32_t index) const
+    { return ((void*)((this->range.firstIndex + index) * getIndexSize())); };
+    size_t  getIndexSize(void) const
+    { return (this->indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint)); };
 };
 
-Mesh::Mesh(std::vector<mVertex> vertices, std::vector<unsigned int> indices, std::vector<mTexture> textures)
+// 넘겨받은 벡터는 업로드 후 바로 해제한다.
+Mesh::Mesh(std::vector<mVertex>&& vertices, std::vector<GLuint>&& indices, std::vector<mTexture>&& textures)
 {
-    this->vertices = vertices;
-    this->indices = indices;
-    this->textures = textures;
+    this->textures = std::move(textures);
 
-    setupMesh();
+    setupMesh(vertices.data(), vertices.size(), indices.data(), indices.size(), GL_UNSIGNED_INT);
+    std::vector<mVertex>().swap(vertices);
+    std::vector<GLuint>().swap(indices);
+};
+
+// 캐시처럼 이미 최종 형태인 버퍼를 CPU 쪽 사본 없이 바로 GPU 에 올린다.
+Mesh::Mesh(const mVertex* vertices, size_t vertexCount, const void* indices, size_t indexCount, GLenum indexType,
+        std::vector<mTexture>&& textures)
+{
+    this->textures = std::move(textures);
+
+    setupMesh(vertices, vertexCount, indices, indexCount, indexType);
+};
+
+Mesh::Mesh(GLuint sharedVAO, GLuint sharedDepthVAO, GLenum indexType, const MeshRange& range, size_t indexCount,
+        std::vector<mTexture>&& textures)
+{
+    this->textures = std::move(textures);
+    this->VAO = sharedVAO;
+    this->depthVAO = sharedDepthVAO;
+    this->sharedBuffer = true;
+    this->range = range;
+    this->indexCount = indexCount;
+    this->indexType = indexType;
+    this->lods = { MeshLod { 0, static_cast<uint32_t>(indexCount), 0.0f } };
+};
+
+Mesh::Mesh(Mesh&& other) noexcept
+{
+    *this = std::move(other);
 };
 
 Mesh::~Mesh()
 {
-    // if (VAO)
-    //     glDeleteVertexArrays(1, &VAO);
-    // if (VBO)
-    //     glDeleteBuffers(1, &VBO);
-    // if (EBO)
-    //     glDeleteBuffers(1, &EBO);
+    releaseBuffers();
+};
+
+Mesh&   Mesh::operator=(Mesh&& other) noexcept
+{
+    if (this == &other)
+        return (*this);
+    releaseBuffers();
+    this->textures = std::move(other.textures);
+    this->VAO = other.VAO;
+    this->VBO = other.VBO;
+    this->EBO = other.EBO;
+    this->depthVAO = other.depthVAO;
+    this->positionVBO = other.positionVBO;
+    other.VAO = other.VBO = other.EBO = 0;
+    other.depthVAO = other.positionVBO = 0;
+    this->indexCount = other.indexCount;
+    this->indexType = other.indexType;
+    this->sharedBuffer = other.sharedBuffer;
+    this->range = other.range;
+    this->lods = std::move(other.lods);
+    this->bounds = other.bounds;
+    this->currentLod = other.currentLod;
+    this->meshlets = std::move(other.meshlets);
+    this->visibleMeshlets = other.visibleMeshlets;
+    this->collision = std::move(other.collision);
+    this->instanceBuffer = other.instanceBuffer;
+    this->firstInstance = other.firstInstance;
+    this->instanceCount = other.instanceCount;
+    return (*this);
+};
+
+// 공용 버퍼의 VAO 는 ModelBuffer 가 지운다. 컨텍스트가 이미 내려간 뒤라면 드라이버가 함께 정리한다.
+void    Mesh::releaseBuffers(void)
+{
+    if (!this->sharedBuffer && glfwGetCurrentContext())
+    {
+        if (this->VAO)
+            glDeleteVertexArrays(1, &this->VAO);
+        if (this->VBO)
+            glDeleteBuffers(1, &this->VBO);
+        if (this->EBO)
+            glDeleteBuffers(1, &this->EBO);
+        if (this->depthVAO)
+            glDeleteVertexArrays(1, &this->depthVAO);
+        if (this->positionVBO)
+            glDeleteBuffers(1, &this->positionVBO);
+    }
+    if (!this->sharedBuffer)
+    {
+        GpuMemory::Get().Release(GpuMemory::BUFFER, this->VBO);
+        GpuMemory::Get().Release(GpuMemory::BUFFER, this->EBO);
+        GpuMemory::Get().Release(GpuMemory::BUFFER, this->positionVBO);
+    }
+    this->VAO = this->VBO = this->EBO = 0;
+    this->depthVAO = this->positionVBO = 0;
+};
+
+CollisionMesh   Mesh::MakeCollision(const mVertex* vertices, size_t vertexCount, const void* indices,
+                                    size_t indexCount, GLenum indexType)
+{
+    CollisionMesh   collision;
+    collision.positions.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        collision.positions[i] = vertices[i].position;
+    if (indexType == GL_UNSIGNED_SHORT)
+        collision.indices.assign(static_cast<const GLushort*>(indices), static_cast<const GLushort*>(indices) + indexCount);
+    else
+        collision.indices.assign(static_cast<const GLuint*>(indices), static_cast<const GLuint*>(indices) + indexCount);
+    return (collision);
 };
 
-void    Mesh::setupMesh()
+void    Mesh::setupMesh(const mVertex* vertices, size_t vertexCount, const void* indices, size_t indexCount,
+                        GLenum indexType)
 {
+    // 정점이 65536 개 이하면 인덱스 버퍼를 절반 크기로 올린다.
+    std::vector<GLushort>   shortIndices;
+    if (indexType == GL_UNSIGNED_INT && ChooseIndexType(vertexCount) == GL_UNSIGNED_SHORT)
+    {
+        const GLuint*   source = static_cast<const GLuint*>(indices);
+        shortIndices.assign(source, source + indexCount);
+        indices = shortIndices.data();
+        indexType = GL_UNSIGNED_SHORT;
+    }
+    this->indexCount = indexCount;
+    this->indexType = indexType;
+    this->lods = { MeshLod { 0, static_cast<uint32_t>(indexCount), 0.0f } };
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
@@ -67,12 +327,88 @@ void    Mesh::setupMesh()
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(mVertex), &vertices[0], GL_STATIC_DRAW);  
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(mVertex), vertices, GL_STATIC_DRAW);  
+
+    size_t  indexSize = indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize, indices, GL_STATIC_DRAW);
+    GpuMemory::Get().Track(GpuMemory::BUFFER, VBO, vertexCount * sizeof(mVertex), "Mesh vertices");
+    GpuMemory::Get().Track(GpuMemory::BUFFER, EBO, indexSize, "Mesh indices");
+
+    SetupVertexAttributes();
+
+    std::vector<glm::vec3>  positions = ExtractPositions(vertices, vertexCount);
+    glGenVertexArrays(1, &depthVAO);
+    glGenBuffers(1, &positionVBO);
 
+    glBindVertexArray(depthVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+    GpuMemory::Get().Track(GpuMemory::BUFFER, positionVBO, positions.size() * sizeof(glm::vec3), "Mesh positions");
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
-                 &indices[0], GL_STATIC_DRAW);
+    SetupPositionAttribute();
+
+    glBindVertexArray(0);
+};
 
+std::vector<glm::vec3>  Mesh::ExtractPositions(const mVertex* vertices, size_t vertexCount)
+{
+    std::vector<glm::vec3>  positions(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        positions[i] = vertices[i].position;
+    return (positions);
+};
+
+void    Mesh::SetLods(const std::vector<MeshLod>& lods, const glm::vec4& bounds)
+{
+    if (!lods.empty())
+        this->lods = lods;
+    this->bounds = bounds;
+    this->currentLod = 0;
+};
+
+// 각 LOD 의 오차를 화면 픽셀로 투영해서, 기준보다 작은 가장 거친 LOD 를 고른다.
+size_t  Mesh::SelectLod(const glm::mat4& model, const glm::vec3& cameraPos, float fovy, float viewportHeight)
+{
+    if (this->lods.size() <= 1)
+        return (this->currentLod);
+    float       scale = std::max(glm::length(glm::vec3(model[0])),
+                        std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    glm::vec3   center = glm::vec3(model * glm::vec4(glm::vec3(this->bounds), 1.0f));
+    float       distance = std::max(glm::length(center - cameraPos) - this->bounds.w * scale, 0.1f);
+    float       pixelsPerUnit = viewportHeight / (2.0f * std::tan(glm::radians(fovy) * 0.5f) * distance);
+
+    size_t  lod = 0;
+    for (size_t i = this->lods.size() - 1; i > 0; --i)
+    {
+        float   limit = i > this->currentLod ? LOD_PIXEL_ERROR * LOD_HYSTERESIS : LOD_PIXEL_ERROR;
+        if (this->lods[i].error * scale * pixelsPerUnit <= limit)
+        {
+            lod = i;
+            break ;
+        }
+    }
+    this->currentLod = lod;
+    return (lod);
+};
+
+// 메쉬 구가 화면에서 차지하는 지름을 스트리밍하는 텍스처 배열에 사용 기록으로 남긴다.
+void    Mesh::RequestTextureDetail(const glm::mat4& model, const glm::vec3& cameraPos, float fovy,
+                                float viewportHeight) const
+{
+    float       scale = std::max(glm::length(glm::vec3(model[0])),
+                        std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    glm::vec3   center = glm::vec3(model * glm::vec4(glm::vec3(this->bounds), 1.0f));
+    float       distance = std::max(glm::length(center - cameraPos) - this->bounds.w * scale, 0.1f);
+    float       pixelsPerUnit = viewportHeight / (2.0f * std::tan(glm::radians(fovy) * 0.5f) * distance);
+    float       pixels = 2.0f * this->bounds.w * scale * pixelsPerUnit * TEXTURE_DETAIL_SCALE;
+    for (const mTexture& texture : this->textures)
+        if (texture.array)
+            texture.array->RequestDetail(pixels);
+};
+
+void    Mesh::SetupVertexAttributes(void)
+{
     glEnableVertexAttribArray(0);	
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(mVertex), (void*)offsetof(mVertex, position));
     glEnableVertexAttribArray(1);	
@@ -85,21 +421,227 @@ void    Mesh::setupMesh()
     glVertexAttribIPointer(4, 4, GL_INT, sizeof(mVertex), (void*)offsetof(mVertex, boneIDs));
     glEnableVertexAttribArray(5);
     glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(mVertex), (void*)offsetof(mVertex, weights));
+};
 
-    glBindVertexArray(0);
+// 위치 스트림은 빈틈없는 vec3 배열이다. 깊이 패스 셰이더도 location 0 으로 받는다.
+void    Mesh::SetupPositionAttribute(void)
+{
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+};
+
+void    Mesh::bindVertexArray(void) const
+{
+    if (!this->sharedBuffer)
+        glBindVertexArray(this->VAO);
+    if (this->instanceBuffer)
+        bindInstances();
 };
 
-void    Mesh::Draw(Program* program) 
+void    Mesh::bindDepthArray(void) const
 {
-    for(unsigned int i = 0; i < textures.size(); i++)
+    if (!this->sharedBuffer)
+        glBindVertexArray(this->depthVAO);
+    if (this->instanceBuffer)
+        bindInstances();
+};
+
+void    Mesh::SetInstances(GLuint buffer, uint32_t first, uint32_t count)
+{
+    this->instanceBuffer = buffer;
+    this->firstInstance = first;
+    this->instanceCount = count;
+};
+
+// 공용 VAO 를 여러 메쉬가 같이 쓰므로 그릴 때마다 자기 인스턴스 구간을 가리키게 한다.
+// instanced 가 아닌 draw 에서는 첫 인스턴스 값이 쓰인다.
+void    Mesh::bindInstances(void) const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer);
+    for (GLuint i = 0; i < 4; ++i)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
-        program->setUniform((int)i, textures[i].type.c_str());
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        glEnableVertexAttribArray(INSTANCE_ATTRIB + i);
+        glVertexAttribPointer(INSTANCE_ATTRIB + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                            (void*)(this->firstInstance * sizeof(glm::mat4) + i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(INSTANCE_ATTRIB + i, 1);
     }
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+};
+
+void    Mesh::unbindVertexArray(void) const
+{
+    if (!this->sharedBuffer)
+        glBindVertexArray(0);
+};
+
+int     Mesh::GetMaterialSlot(const std::string& type)
+{
+    for (int slot = 0; slot < MATERIAL_SLOTS; ++slot)
+        if (type == MATERIAL_NAMES[slot])
+            return (slot);
+    return (-1);
+};
+
+// 모델을 그리기 전에 한 번 부른다. 샘플러를 재질 자리의 유닛에 고정하고, 이전 모델이 바인드한 기록을 지운다.
+// 그 뒤로 메쉬는 배열이 바뀔 때만 바인드하고 층 번호만 attribute 로 넘긴다.
+void    Mesh::BeginMaterials(Program* program)
+{
+    for (int slot = 0; slot < MATERIAL_SLOTS; ++slot)
+        program->setUniform(slot, MATERIAL_NAMES[slot]);
+    getBoundMaterials().fill(0);
+};
+
+std::array<GLuint, Mesh::MATERIAL_SLOTS>&   Mesh::getBoundMaterials(void)
+{
+    static std::array<GLuint, MATERIAL_SLOTS>   bound {};
+    return (bound);
+};
+
+// 없는 재질 자리를 채우는 값. 흰 알베도, 반사 없음, 평평한 노멀 (z 는 셰이더가 다시 만든다), 높이 0
+const std::array<std::shared_ptr<TextureArray>, Mesh::MATERIAL_SLOTS>&  Mesh::getDefaultMaterials(void)
+{
+    // 업로더와 VRAM 장부가 먼저 만들어져 있어야 프로그램이 끝날 때 이 배열들보다 늦게 사라진다.
+    TextureUploader::Get();
+    GpuMemory::Get();
+    static const unsigned char  colors[MATERIAL_SLOTS][4] = { { 255, 255, 255, 255 }, { 0, 0, 0, 255 },
+                                                            { 128, 128, 255, 255 }, { 0, 0, 0, 255 } };
+    static const std::array<std::shared_ptr<TextureArray>, MATERIAL_SLOTS> defaults = {
+        TextureArray::CreateSolid(colors[0]), TextureArray::CreateSolid(colors[1]),
+        TextureArray::CreateSolid(colors[2]), TextureArray::CreateSolid(colors[3]) };
+    return (defaults);
+};
+
+// 재질 자리마다 배열과 층을 고른다. 텍스처가 없거나 올리지 못한 자리는 기본 배열을 쓴다.
+// 배열은 자리의 유닛에 지금 바인드된 것과 다를 때만 바꾼다.
+void    Mesh::bindMaterial(void) const
+{
+    const std::array<std::shared_ptr<TextureArray>, MATERIAL_SLOTS>&    defaults = getDefaultMaterials();
+    std::array<GLuint, MATERIAL_SLOTS>& bound = getBoundMaterials();
+    GLuint  arrays[MATERIAL_SLOTS];
+    GLint   layers[MATERIAL_SLOTS] = { 0, 0, 0, 0 };
+    for (int slot = 0; slot < MATERIAL_SLOTS; ++slot)
+        arrays[slot] = defaults[slot]->Get();
+    for (const mTexture& texture : this->textures)
+    {
+        int slot = GetMaterialSlot(texture.type);
+        if (slot < 0 || !texture.array)
+            continue ;
+        arrays[slot] = texture.array->Get();
+        layers[slot] = texture.layer;
+        texture.array->MarkUsed();
+    }
+    for (int slot = 0; slot < MATERIAL_SLOTS; ++slot)
+    {
+        if (bound[slot] == arrays[slot])
+            continue ;
+        glActiveTexture(GL_TEXTURE0 + slot);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[slot]);
+        bound[slot] = arrays[slot];
+    }
+    glVertexAttribI4i(MATERIAL_ATTRIB, layers[0], layers[1], layers[2], layers[3]);
+};
+
+void    Mesh::Draw(void)
+{
+    bindMaterial();
+    const MeshLod&  lod = this->lods[this->currentLod];
+    bindVertexArray();
+    if (this->instanceCount > 1)
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.indexCount, this->indexType, getIndexOffset(lod.indexOffset),
+                                        this->instanceCount, this->range.baseVertex);
+    else
+        glDrawElementsBaseVertex(GL_TRIANGLES, lod.indexCount, this->indexType, getIndexOffset(lod.indexOffset),
+                                this->range.baseVertex);
+    unbindVertexArray();
+
+    glActiveTexture(GL_TEXTURE0);
+};
+
+void    Mesh::DrawInstanced(GLsizei instanceCount)
+{
+    bindMaterial();
+    const MeshLod&  lod = this->lods[this->currentLod];
+    bindVertexArray();
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.indexCount, this->indexType, getIndexOffset(lod.indexOffset),
+                                    instanceCount, this->range.baseVertex);
+    unbindVertexArray();
+
+    glActiveTexture(GL_TEXTURE0);
+};
+
+// 깊이 프리패스 / 그림자 패스용. 텍스처 없이 위치 스트림만 읽고, 고른 LOD 와 인스턴스는 Draw 와 같다.
+void    Mesh::DrawDepth(void)
+{
+    const MeshLod&  lod = this->lods[this->currentLod];
+    bindDepthArray();
+    if (this->instanceCount > 1)
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.indexCount, this->indexType, getIndexOffset(lod.indexOffset),
+                                        this->instanceCount, this->range.baseVertex);
+    else
+        glDrawElementsBaseVertex(GL_TRIANGLES, lod.indexCount, this->indexType, getIndexOffset(lod.indexOffset),
+                                this->range.baseVertex);
+    unbindVertexArray();
+};
+
+// 화면 밖이거나 전부 뒷면인 meshlet 을 CPU 에서 버리고, 남은 구간만 한 번의 glMultiDrawElements 로 그린다.
+// meshlet 은 LOD0 에만 있으므로 거친 LOD 가 골라져 있으면 메쉬 전체 구만 검사한다.
+void    Mesh::DrawCulled(const glm::mat4& model, const Frustum& frustum, const glm::vec3& cameraPos)
+{
+    float   scale = std::max(glm::length(glm::vec3(model[0])),
+                    std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    this->drawCounts.clear();
+    this->drawOffsets.clear();
+
+    if (this->currentLod != 0 || this->meshlets.empty())
+    {
+        glm::vec3   center = glm::vec3(model * glm::vec4(glm::vec3(this->bounds), 1.0f));
+        this->visibleMeshlets = 0;
+        if (frustum.Intersects(center, this->bounds.w * scale))
+            Draw();
+        return ;
+    }
+
+    // 노멀은 역전치로 옮긴다. 뒤집는 (행렬식이 음수인) 변환은 감는 방향도 바꾸므로 부호까지 따라간다.
+    // 비균등 스케일은 노멀 사이 각을 벌린다. 축 길이 비율이 stretch 이면 반각의 tan 이 최대 stretch 배가 되므로
+    // cone 의 각도 그만큼 넓힌다. (축 길이 비율은 TRS 행렬의 조건수와 같다)
+    glm::mat3   linear = glm::mat3(model);
+    float       minScale = std::min(glm::length(linear[0]), std::min(glm::length(linear[1]), glm::length(linear[2])));
+    float       stretch = minScale > 0.0f ? scale / minScale : 0.0f;
+    glm::mat3   normalMatrix(1.0f);
+    if (stretch > 0.0f)
+        normalMatrix = glm::transpose(glm::inverse(linear)) * (glm::determinant(linear) < 0.0f ? -1.0f : 1.0f);
+    for (const Meshlet& meshlet : this->meshlets)
+    {
+        glm::vec3   center = glm::vec3(model * glm::vec4(glm::vec3(meshlet.sphere), 1.0f));
+        float       radius = meshlet.sphere.w * scale;
+        if (!frustum.Intersects(center, radius))
+            continue ;
+        // cone 바깥에서 보면 meshlet 의 모든 삼각형이 뒷면이다. 납작한 변환이면 cone 을 믿을 수 없다.
+        float       cutoff = meshlet.cone.w;
+        if (stretch > 1.0f && cutoff < 1.0f)
+        {
+            float   angle = 2.0f * std::atan(stretch * std::tan(std::asin(cutoff) * 0.5f));
+            cutoff = angle < std::acos(0.0f) ? std::sin(angle) : 1.0f;
+        }
+        if (stretch > 0.0f && cutoff < 1.0f)
+        {
+            glm::vec3   axis = glm::normalize(normalMatrix * glm::vec3(meshlet.cone));
+            glm::vec3   toCenter = center - cameraPos;
+            if (glm::dot(toCenter, axis) >= cutoff * glm::length(toCenter) + radius)
+                continue ;
+        }
+        this->drawCounts.push_back(static_cast<GLsizei>(meshlet.indexCount));
+        this->drawOffsets.push_back(getIndexOffset(meshlet.indexOffset));
+    }
+    this->visibleMeshlets = this->drawCounts.size();
+    if (this->drawCounts.empty())
+        return ;
+
+    this->drawBaseVertices.assign(this->drawCounts.size(), this->range.baseVertex);
+    bindMaterial();
+    bindVertexArray();
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, this->drawCounts.data(), this->indexType, this->drawOffsets.data(),
+                                static_cast<GLsizei>(this->drawCounts.size()), this->drawBaseVertices.data());
+    unbindVertexArray();
 
     glActiveTexture(GL_TEXTURE0);
 };
@@ -0,0 +1,360 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+#include "Common.hpp"
+#include "Mesh.hpp"
+#include "MappedFile.hpp"
+
+// 파일 구조: header | entries | textures | bones | lods | meshlets | instances | strings | (vertices | indices) * meshCount
+// 정점/인덱스 구간은 16 바이트 정렬이라 맵핑한 포인터를 그대로 glBufferData 에 넘길 수 있다.
+struct MeshCacheHeader
+{
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    vertexSize;
+    uint32_t    importFlags;
+    uint64_t    sourceSize;
+    int64_t     sourceTime;
+    uint32_t    meshCount;
+    uint32_t    textureCount;
+    uint32_t    boneCount;
+    uint32_t    stringSize;
+    float       weldEpsilon;
+    uint32_t    lodLevels;
+    uint32_t    buildMeshlets;
+    uint32_t    lodCount;
+    uint32_t    meshletCount;
+    uint32_t    instanceCount;
+};
+
+struct MeshCacheEntry
+{
+    uint64_t    vertexOffset, vertexCount;
+    uint64_t    indexOffset, indexCount;
+    uint32_t    textureBegin, textureCount;
+    uint32_t    indexSize;
+    uint32_t    lodBegin, lodCount;
+    uint32_t    meshletBegin, meshletCount;
+    glm::vec4   bounds;
+};
+
+struct MeshCacheTexture
+{
+    uint32_t    typeOffset, typeLength;
+    uint32_t    pathOffset, pathLength;
+};
+
+struct MeshCacheBone
+{
+    int32_t     id;
+    uint32_t    nameOffset, nameLength;
+    uint32_t    pad;
+    glm::mat4   offset;
+};
+
+class MeshCache
+{
+public:
+    static constexpr uint32_t   VERSION = 8;
+
+    static std::unique_ptr<MeshCache>   Open(const std::string& sourcePath, uint32_t importFlags,
+                                            const MeshImportOptions& options);
+    static bool Write(const std::string& sourcePath, uint32_t importFlags, const MeshImportOptions& options,
+                    const std::vector<MeshData>& meshes, const std::map<std::string, BoneInfo>* boneInfoMap = nullptr,
+                    const std::vector<MeshInstance>* instances = nullptr);
+
+    ~MeshCache() {};
+
+    size_t          GetMeshCount(void) const { return (this->header->meshCount); };
+    const mVertex*  GetVertices(size_t mesh) const;
+    size_t          GetVertexCount(size_t mesh) const { return (this->entries[mesh].vertexCount); };
+    const void*     GetIndices(size_t mesh) const;
+    size_t          GetIndexCount(size_t mesh) const { return (this->entries[mesh].indexCount); };
+    GLenum          GetIndexType(size_t mesh) const
+    { return (this->entries[mesh].indexSize == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT); };
+    std::vector<mTexture>           GetTextures(size_t mesh) const;
+    std::vector<MeshLod>            GetLods(size_t mesh) const;
+    std::vector<Meshlet>            GetMeshlets(size_t mesh) const;
+    glm::vec4                       GetBounds(size_t mesh) const { return (this->entries[mesh].bounds); };
+    std::map<std::string, BoneInfo> GetBoneInfoMap(void) const;
+    std::vector<MeshInstance>       GetInstances(void) const
+    { return (std::vector<MeshInstance>(this->instances, this->instances + this->header->instanceCount)); };
+private:
+    std::unique_ptr<MappedFile> file;
+    const MeshCacheHeader*      header { nullptr };
+    const MeshCacheEntry*       entries { nullptr };
+    const MeshCacheTexture*     textures { nullptr };
+    const MeshCacheBone*        bones { nullptr };
+    const MeshLod*              lods { nullptr };
+    const Meshlet*              meshlets { nullptr };
+    const MeshInstance*         instances { nullptr };
+    const char*                 strings { nullptr };
+
+    MeshCache() {};
+    bool    init(const std::string& sourcePath, uint32_t importFlags, const MeshImportOptions& options);
+
+    static std::string  GetCachePath(const std::string& sourcePath)
+    { return (sourcePath + ".meshcache"); };
+    static bool         GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time);
+    static size_t       Align(size_t offset)
+    { return ((offset + 15) & ~static_cast<size_t>(15)); };
+};
+
+std::unique_ptr<MeshCache>  MeshCache::Open(const std::string& sourcePath, uint32_t importFlags,
+                                            const MeshImportOptions& options)
+{
+    std::unique_ptr<MeshCache>  cache = std::unique_ptr<MeshCache>(new MeshCache());
+    if (!cache->init(sourcePath, importFlags, options))
+        return (nullptr);
+    return (std::move(cache));
+};
+
+bool    MeshCache::GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time)
+{
+    std::error_code error;
+    size = std::filesystem::file_size(sourcePath, error);
+    if (error)
+        return (false);
+    time = std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+    return (!error);
+};
+
+// 버전, 정점 구조 크기, import 옵션, 원본 크기/수정 시간 중 하나라도 다르면 캐시를 버린다.
+bool    MeshCache::init(const std::string& sourcePath, uint32_t importFlags, const MeshImportOptions& options)
+{
+    uint64_t    sourceSize;
+    int64_t     sourceTime;
+    if (!GetSourceStamp(sourcePath, sourceSize, sourceTime))
+        return (false);
+    this->file = MappedFile::Open(GetCachePath(sourcePath));
+    if (!this->file || this->file->Size() < sizeof(MeshCacheHeader))
+        return (false);
+
+    const unsigned char*    data = this->file->Data();
+    this->header = reinterpret_cast<const MeshCacheHeader*>(data);
+    if (std::memcmp(this->header->magic, "MSHC", 4) != 0 || this->header->version != VERSION
+        || this->header->vertexSize != sizeof(mVertex) || this->header->importFlags != importFlags
+        || this->header->sourceSize != sourceSize || this->header->sourceTime != sourceTime
+        || this->header->weldEpsilon != options.weldEpsilon || this->header->lodLevels != options.lodLevels
+        || this->header->buildMeshlets != static_cast<uint32_t>(options.buildMeshlets))
+        return (false);
+
+    size_t  offset = sizeof(MeshCacheHeader);
+    this->entries = reinterpret_cast<const MeshCacheEntry*>(data + offset);
+    offset += sizeof(MeshCacheEntry) * this->header->meshCount;
+    this->textures = reinterpret_cast<const MeshCacheTexture*>(data + offset);
+    offset += sizeof(MeshCacheTexture) * this->header->textureCount;
+    this->bones = reinterpret_cast<const MeshCacheBone*>(data + offset);
+    offset += sizeof(MeshCacheBone) * this->header->boneCount;
+    this->lods = reinterpret_cast<const MeshLod*>(data + offset);
+    offset += sizeof(MeshLod) * this->header->lodCount;
+    this->meshlets = reinterpret_cast<const Meshlet*>(data + offset);
+    offset += sizeof(Meshlet) * this->header->meshletCount;
+    this->instances = reinterpret_cast<const MeshInstance*>(data + offset);
+    offset += sizeof(MeshInstance) * this->header->instanceCount;
+    this->strings = reinterpret_cast<const char*>(data + offset);
+    offset += this->header->stringSize;
+    if (offset > this->file->Size())
+        return (false);
+
+    for (uint32_t i = 0; i < this->header->meshCount; ++i)
+    {
+        const MeshCacheEntry&   entry = this->entries[i];
+        if ((entry.indexSize != sizeof(GLushort) && entry.indexSize != sizeof(GLuint))
+            || entry.vertexOffset + entry.vertexCount * sizeof(mVertex) > this->file->Size()
+            || entry.indexOffset + entry.indexCount * entry.indexSize > this->file->Size()
+            || entry.lodBegin + entry.lodCount > this->header->lodCount
+            || entry.meshletBegin + entry.meshletCount > this->header->meshletCount)
+            return (false);
+    }
+    for (uint32_t i = 0; i < this->header->instanceCount; ++i)
+        if (this->instances[i].mesh >= this->header->meshCount)
+            return (false);
+    return (true);
+};
+
+const mVertex*  MeshCache::GetVertices(size_t mesh) const
+{
+    return (reinterpret_cast<const mVertex*>(this->file->Data() + this->entries[mesh].vertexOffset));
+};
+
+const void* MeshCache::GetIndices(size_t mesh) const
+{
+    return (this->file->Data() + this->entries[mesh].indexOffset);
+};
+
+std::vector<mTexture>   MeshCache::GetTextures(size_t mesh) const
+{
+    std::vector<mTexture>   result;
+    const MeshCacheEntry&   entry = this->entries[mesh];
+    for (uint32_t i = 0; i < entry.textureCount; ++i)
+    {
+        const MeshCacheTexture& ref = this->textures[entry.textureBegin + i];
+        mTexture                texture;
+        texture.id = 0;
+        texture.type.assign(this->strings + ref.typeOffset, ref.typeLength);
+        texture.path.assign(this->strings + ref.pathOffset, ref.pathLength);
+        result.push_back(texture);
+    }
+    return (result);
+};
+
+std::vector<MeshLod>    MeshCache::GetLods(size_t mesh) const
+{
+    const MeshCacheEntry&   entry = this->entries[mesh];
+    return (std::vector<MeshLod>(this->lods + entry.lodBegin, this->lods + entry.lodBegin + entry.lodCount));
+};
+
+std::vector<Meshlet>    MeshCache::GetMeshlets(size_t mesh) const
+{
+    const MeshCacheEntry&   entry = this->entries[mesh];
+    return (std::vector<Meshlet>(this->meshlets + entry.meshletBegin,
+                                this->meshlets + entry.meshletBegin + entry.meshletCount));
+};
+
+std::map<std::string, BoneInfo> MeshCache::GetBoneInfoMap(void) const
+{
+    std::map<std::string, BoneInfo> boneInfoMap;
+    for (uint32_t i = 0; i < this->header->boneCount; ++i)
+    {
+        const MeshCacheBone&    bone = this->bones[i];
+        BoneInfo                info;
+        info.id = bone.id;
+        info.offset = bone.offset;
+        boneInfoMap[std::string(this->strings + bone.nameOffset, bone.nameLength)] = info;
+    }
+    return (boneInfoMap);
+};
+
+bool    MeshCache::Write(const std::string& sourcePath, uint32_t importFlags, const MeshImportOptions& options,
+                        const std::vector<MeshData>& meshes, const std::map<std::string, BoneInfo>* boneInfoMap,
+                        const std::vector<MeshInstance>* instances)
+{
+    MeshCacheHeader header {};
+    std::memcpy(header.magic, "MSHC", 4);
+    header.version = VERSION;
+    header.vertexSize = sizeof(mVertex);
+    header.importFlags = importFlags;
+    header.weldEpsilon = options.weldEpsilon;
+    header.lodLevels = options.lodLevels;
+    header.buildMeshlets = options.buildMeshlets;
+    if (!GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+        return (false);
+
+    std::string                     strings;
+    std::vector<MeshCacheEntry>     entries;
+    std::vector<MeshCacheTexture>   textures;
+    std::vector<MeshCacheBone>      bones;
+    std::vector<MeshLod>            lods;
+    std::vector<Meshlet>            meshlets;
+    auto    addString = [&strings](const std::string& str)
+    {
+        uint32_t    offset = static_cast<uint32_t>(strings.size());
+        strings += str;
+        return (offset);
+    };
+
+    for (const MeshData& mesh : meshes)
+    {
+        MeshCacheEntry  entry {};
+        entry.vertexCount = mesh.vertices.size();
+        entry.indexCount = mesh.indices.size();
+        entry.indexSize = Mesh::ChooseIndexType(mesh.vertices.size()) == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        entry.textureBegin = static_cast<uint32_t>(textures.size());
+        entry.textureCount = static_cast<uint32_t>(mesh.textures.size());
+        entry.lodBegin = static_cast<uint32_t>(lods.size());
+        entry.lodCount = static_cast<uint32_t>(mesh.lods.size());
+        entry.bounds = mesh.bounds;
+        lods.insert(lods.end(), mesh.lods.begin(), mesh.lods.end());
+        entry.meshletBegin = static_cast<uint32_t>(meshlets.size());
+        entry.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+        meshlets.insert(meshlets.end(), mesh.meshlets.begin(), mesh.meshlets.end());
+        for (const mTexture& texture : mesh.textures)
+        {
+            MeshCacheTexture    ref;
+            ref.typeOffset = addString(texture.type);
+            ref.typeLength = static_cast<uint32_t>(texture.type.size());
+            ref.pathOffset = addString(texture.path);
+            ref.pathLength = static_cast<uint32_t>(texture.path.size());
+            textures.push_back(ref);
+        }
+        entries.push_back(entry);
+    }
+    if (boneInfoMap)
+    {
+        for (const auto& boneInfo : *boneInfoMap)
+        {
+            MeshCacheBone   bone {};
+            bone.id = boneInfo.second.id;
+            bone.nameOffset = addString(boneInfo.first);
+            bone.nameLength = static_cast<uint32_t>(boneInfo.first.size());
+            bone.offset = boneInfo.second.offset;
+            bones.push_back(bone);
+        }
+    }
+    header.meshCount = static_cast<uint32_t>(entries.size());
+    header.textureCount = static_cast<uint32_t>(textures.size());
+    header.boneCount = static_cast<uint32_t>(bones.size());
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.meshletCount = static_cast<uint32_t>(meshlets.size());
+    header.instanceCount = instances ? static_cast<uint32_t>(instances->size()) : 0;
+    header.stringSize = static_cast<uint32_t>(strings.size());
+
+    size_t  offset = Align(sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * entries.size()
+                        + sizeof(MeshCacheTexture) * textures.size() + sizeof(MeshCacheBone) * bones.size()
+                        + sizeof(MeshLod) * lods.size() + sizeof(Meshlet) * meshlets.size()
+                        + sizeof(MeshInstance) * header.instanceCount + strings.size());
+    for (MeshCacheEntry& entry : entries)
+    {
+        entry.vertexOffset = offset;
+        offset = Align(offset + entry.vertexCount * sizeof(mVertex));
+        entry.indexOffset = offset;
+        offset = Align(offset + entry.indexCount * entry.indexSize);
+    }
+
+    // 쓰는 도중에 죽어도 깨진 캐시가 남지 않도록 임시 파일에 쓰고 바꿔치기한다.
+    std::string     cachePath = GetCachePath(sourcePath);
+    std::string     tempPath = cachePath + ".tmp";
+    {
+        std::ofstream   ofs(tempPath, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open())
+            return (false);
+        const char  padding[16] = { 0 };
+        auto        pad = [&ofs, &padding]()
+        {
+            size_t  position = static_cast<size_t>(ofs.tellp());
+            ofs.write(padding, Align(position) - position);
+        };
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(entries.data()), sizeof(MeshCacheEntry) * entries.size());
+        ofs.write(reinterpret_cast<const char*>(textures.data()), sizeof(MeshCacheTexture) * textures.size());
+        ofs.write(reinterpret_cast<const char*>(bones.data()), sizeof(MeshCacheBone) * bones.size());
+        ofs.write(reinterpret_cast<const char*>(lods.data()), sizeof(MeshLod) * lods.size());
+        ofs.write(reinterpret_cast<const char*>(meshlets.data()), sizeof(Meshlet) * meshlets.size());
+        if (instances)
+            ofs.write(reinterpret_cast<const char*>(instances->data()), sizeof(MeshInstance) * instances->size());
+        ofs.write(strings.data(), strings.size());
+        pad();
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            const MeshData& mesh = meshes[i];
+            ofs.write(reinterpret_cast<const char*>(mesh.vertices.data()), sizeof(mVertex) * mesh.vertices.size());
+            pad();
+            if (entries[i].indexSize == sizeof(GLushort))
+            {
+                std::vector<GLushort>   shortIndices(mesh.indices.begin(), mesh.indices.end());
+                ofs.write(reinterpret_cast<const char*>(shortIndices.data()), sizeof(GLushort) * shortIndices.size());
+            }
+            else
+                ofs.write(reinterpret_cast<const char*>(mesh.indices.data()), sizeof(GLuint) * mesh.indices.size());
+            pad();
+        }
+        if (!ofs.good())
+            return (false);
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    return (!error);
+};
+
+#endif
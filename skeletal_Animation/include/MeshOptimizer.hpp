@@ -0,0 +1,574 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+#include "Common.hpp"
+#include "Mesh.hpp"
+#include "MeshSimplifier.hpp"
+#include <algorithm>
+#include <cmath>
+
+// FIFO 캐시로 흉내 낸 정점 캐시 효율. ACMR 은 삼각형당, ATVR 은 정점당 셰이더 실행 횟수다.
+struct VertexCacheStats
+{
+    float   acmr { 0.0f };
+    float   atvr { 0.0f };
+};
+
+struct MeshOptimizeReport
+{
+    VertexCacheStats    before;
+    VertexCacheStats    after;
+    size_t              sourceVertexCount { 0 };
+    size_t              vertexCount { 0 };
+    size_t              triangleCount { 0 };
+    GLenum              indexType { GL_UNSIGNED_INT };
+    std::vector<MeshLod>    lods;
+    size_t                  meshletCount { 0 };
+};
+
+// import 시점에 한 번 돌리는 인덱스/정점 순서 최적화.
+// 중복 정점 합치기 -> 정점 캐시 순서(Forsyth) -> 가림 순서(클러스터 정렬) -> LOD 생성 -> 정점 fetch 순서
+// -> meshlet 분할 순서로 적용한다.
+class MeshOptimizer
+{
+public:
+    static MeshOptimizeReport   Optimize(MeshData& mesh, const MeshImportOptions& options);
+
+    static size_t   WeldVertices(std::vector<mVertex>& vertices, std::vector<GLuint>& indices, float epsilon = 0.0f);
+    static void     OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount);
+    static void     OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<mVertex>& vertices,
+                                    float threshold = 1.05f);
+    static void     OptimizeVertexFetch(std::vector<mVertex>& vertices, std::vector<GLuint>& indices);
+    static std::vector<MeshLod> GenerateLods(const std::vector<mVertex>& vertices, std::vector<GLuint>& indices,
+                                            unsigned int lodLevels);
+    static glm::vec4    ComputeBounds(const std::vector<mVertex>& vertices);
+    static std::vector<Meshlet> BuildMeshlets(const std::vector<mVertex>& vertices, const std::vector<GLuint>& indices,
+                                            const MeshLod& lod);
+    static VertexCacheStats AnalyzeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount,
+                                                unsigned int cacheSize = 16);
+    static void     PrintReport(const std::string& name, const MeshOptimizeReport& report);
+    static void     PrintWeldSummary(const std::string& name, const std::vector<MeshOptimizeReport>& reports);
+private:
+    static constexpr int    CACHE_SIZE = 32;
+    static constexpr size_t MESHLET_VERTICES = 64;
+    static constexpr size_t MESHLET_TRIANGLES = 124;
+
+    MeshOptimizer() {};
+    ~MeshOptimizer() {};
+
+    static float    VertexScore(int cachePosition, unsigned int remainingValence);
+    static bool     IsBoneWord(size_t word);
+    static uint32_t HashVertex(const mVertex& vertex, float epsilon);
+    static bool     SameVertex(const mVertex& a, const mVertex& b, float epsilon);
+    static Meshlet  ComputeMeshletBounds(const std::vector<mVertex>& vertices, const GLuint* indices, size_t indexCount);
+    static size_t   CountCacheMisses(const GLuint* indices, size_t indexCount, std::vector<unsigned int>& timestamps,
+                                    unsigned int& time, unsigned int cacheSize);
+};
+
+MeshOptimizeReport  MeshOptimizer::Optimize(MeshData& mesh, const MeshImportOptions& options)
+{
+    MeshOptimizeReport  report;
+    report.sourceVertexCount = mesh.vertices.size();
+    WeldVertices(mesh.vertices, mesh.indices, options.weldEpsilon);
+    report.before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+    OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+    OptimizeOverdraw(mesh.indices, mesh.vertices);
+    // 정점 번호를 바꿔도 캐시 적중은 그대로라 LOD 를 붙이기 전에 LOD0 만 측정한다.
+    report.after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+    report.triangleCount = mesh.indices.size() / 3;
+    mesh.lods = GenerateLods(mesh.vertices, mesh.indices, options.lodLevels);
+    OptimizeVertexFetch(mesh.vertices, mesh.indices);
+    mesh.bounds = ComputeBounds(mesh.vertices);
+    // 한 묶음에 다 들어가는 작은 메쉬는 나눠 봐야 draw 범위만 늘어난다.
+    if (options.buildMeshlets && report.triangleCount > MESHLET_TRIANGLES)
+        mesh.meshlets = BuildMeshlets(mesh.vertices, mesh.indices, mesh.lods[0]);
+    report.meshletCount = mesh.meshlets.size();
+    report.vertexCount = mesh.vertices.size();
+    report.indexType = Mesh::ChooseIndexType(mesh.vertices.size());
+    report.lods = mesh.lods;
+    return (report);
+};
+
+// 바로 앞 LOD 를 절반씩 줄여 이어 붙인다. 충분히 줄지 않으면 거기서 멈춘다.
+// 단계별 오차는 누적해서, 뒤 LOD 일수록 오차가 크거나 같다.
+std::vector<MeshLod>    MeshOptimizer::GenerateLods(const std::vector<mVertex>& vertices, std::vector<GLuint>& indices,
+                                                    unsigned int lodLevels)
+{
+    std::vector<MeshLod>    lods = { MeshLod { 0, static_cast<uint32_t>(indices.size()), 0.0f } };
+    std::vector<GLuint>     previous = indices;
+    float                   error = 0.0f;
+    for (unsigned int level = 1; level < lodLevels; ++level)
+    {
+        size_t              target = previous.size() / 6 * 3;
+        float               levelError = 0.0f;
+        std::vector<GLuint> simplified = MeshSimplifier::Simplify(vertices, previous, target, levelError);
+        if (simplified.empty() || simplified.size() > previous.size() * 9 / 10)
+            break ;
+        OptimizeVertexCache(simplified, vertices.size());
+        error += levelError;
+        lods.push_back(MeshLod { static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        previous.swap(simplified);
+    }
+    return (lods);
+};
+
+glm::vec4   MeshOptimizer::ComputeBounds(const std::vector<mVertex>& vertices)
+{
+    if (vertices.empty())
+        return (glm::vec4(0.0f));
+    glm::vec3   minimum = vertices[0].position, maximum = vertices[0].position;
+    for (const mVertex& vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.position);
+        maximum = glm::max(maximum, vertex.position);
+    }
+    glm::vec3   center = (minimum + maximum) * 0.5f;
+    float       radius = 0.0f;
+    for (const mVertex& vertex : vertices)
+        radius = std::max(radius, glm::length(vertex.position - center));
+    return (glm::vec4(center, radius));
+};
+
+void    MeshOptimizer::PrintReport(const std::string& name, const MeshOptimizeReport& report)
+{
+    std::cout << "Mesh " << name << ": " << report.sourceVertexCount << " -> " << report.vertexCount
+            << " vertices, " << report.triangleCount
+            << " triangles, ACMR " << report.before.acmr << " -> " << report.after.acmr
+            << ", ATVR " << report.before.atvr << " -> " << report.after.atvr
+            << (report.indexType == GL_UNSIGNED_SHORT ? ", 16-bit indices" : ", 32-bit indices");
+    if (report.meshletCount)
+        std::cout << ", " << report.meshletCount << " meshlets";
+    std::cout << std::endl;
+    for (size_t i = 1; i < report.lods.size(); ++i)
+        std::cout << "    LOD" << i << ": " << report.lods[i].indexCount / 3 << " triangles ("
+                << 100 * report.lods[i].indexCount / std::max<uint32_t>(report.lods[0].indexCount, 1)
+                << "%), error " << report.lods[i].error << std::endl;
+};
+
+void    MeshOptimizer::PrintWeldSummary(const std::string& name, const std::vector<MeshOptimizeReport>& reports)
+{
+    size_t  sourceCount = 0, weldedCount = 0;
+    for (const MeshOptimizeReport& report : reports)
+    {
+        sourceCount += report.sourceVertexCount;
+        weldedCount += report.vertexCount;
+    }
+    std::cout << "Model " << name << ": welded " << sourceCount << " -> " << weldedCount << " vertices, saved "
+            << (sourceCount - weldedCount) * sizeof(mVertex) / 1024 << " KB of vertex memory" << std::endl;
+};
+
+// mVertex 를 4 바이트 단위로 본다. boneIDs 만 정수이고 나머지는 모두 float 이다.
+bool    MeshOptimizer::IsBoneWord(size_t word)
+{
+    size_t  offset = word * 4;
+    return (offset >= offsetof(mVertex, boneIDs) && offset < offsetof(mVertex, boneIDs) + sizeof(mVertex::boneIDs));
+};
+
+// epsilon 이 0 이면 비트 단위로, 아니면 epsilon 격자 칸 단위로 해시한다.
+uint32_t    MeshOptimizer::HashVertex(const mVertex& vertex, float epsilon)
+{
+    const size_t    wordCount = sizeof(mVertex) / 4;
+    uint32_t        words[wordCount];
+    std::memcpy(words, &vertex, sizeof(mVertex));
+    uint32_t        hash = 2166136261u;
+    for (size_t i = 0; i < wordCount; ++i)
+    {
+        uint32_t    word = words[i];
+        if (epsilon > 0.0f && !IsBoneWord(i))
+        {
+            float   value;
+            std::memcpy(&value, &words[i], 4);
+            word = static_cast<uint32_t>(static_cast<int32_t>(std::round(value / epsilon)));
+        }
+        hash = (hash ^ word) * 16777619u;
+    }
+    return (hash);
+};
+
+bool    MeshOptimizer::SameVertex(const mVertex& a, const mVertex& b, float epsilon)
+{
+    if (epsilon <= 0.0f)
+        return (std::memcmp(&a, &b, sizeof(mVertex)) == 0);
+    const size_t    wordCount = sizeof(mVertex) / 4;
+    uint32_t        wordsA[wordCount], wordsB[wordCount];
+    std::memcpy(wordsA, &a, sizeof(mVertex));
+    std::memcpy(wordsB, &b, sizeof(mVertex));
+    for (size_t i = 0; i < wordCount; ++i)
+    {
+        if (IsBoneWord(i))
+        {
+            if (wordsA[i] != wordsB[i])
+                return (false);
+            continue ;
+        }
+        float   valueA, valueB;
+        std::memcpy(&valueA, &wordsA[i], 4);
+        std::memcpy(&valueB, &wordsB[i], 4);
+        if (std::fabs(valueA - valueB) > epsilon)
+            return (false);
+    }
+    return (true);
+};
+
+// 같은 정점을 하나로 합치고 인덱스를 다시 만든다. 줄어든 정점 수를 돌려준다.
+// epsilon 을 쓰면 같은 격자 칸 안의 정점끼리만 비교하므로, 칸 경계를 사이에 둔 정점은 합쳐지지 않을 수 있다.
+size_t  MeshOptimizer::WeldVertices(std::vector<mVertex>& vertices, std::vector<GLuint>& indices, float epsilon)
+{
+    const GLuint    empty = static_cast<GLuint>(-1);
+    size_t          tableSize = 16;
+    while (tableSize < vertices.size() * 2)
+        tableSize *= 2;
+    std::vector<GLuint>     table(tableSize, empty);
+    std::vector<GLuint>     remap(vertices.size());
+    std::vector<mVertex>    result;
+    result.reserve(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        size_t  slot = HashVertex(vertices[i], epsilon) & (tableSize - 1);
+        while (table[slot] != empty && !SameVertex(result[table[slot]], vertices[i], epsilon))
+            slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] == empty)
+        {
+            table[slot] = static_cast<GLuint>(result.size());
+            result.push_back(vertices[i]);
+        }
+        remap[i] = table[slot];
+    }
+    for (GLuint& index : indices)
+        index = remap[index];
+    size_t  removed = vertices.size() - result.size();
+    vertices.swap(result);
+    return (removed);
+};
+
+// 정점 캐시 순서를 따라가면서 정점 64 개 / 삼각형 124 개를 넘기 직전에 끊는다.
+// 순서가 이미 국소적이라 묶음이 공간적으로도 모여 있고, 인덱스 버퍼를 다시 배치할 필요가 없다.
+std::vector<Meshlet>    MeshOptimizer::BuildMeshlets(const std::vector<mVertex>& vertices, const std::vector<GLuint>& indices,
+                                                    const MeshLod& lod)
+{
+    std::vector<Meshlet>    meshlets;
+    std::vector<GLuint>     seen(vertices.size(), static_cast<GLuint>(-1));
+    GLuint                  meshletID = 0;
+    size_t                  begin = lod.indexOffset, uniqueVertices = 0;
+    size_t                  end = lod.indexOffset + lod.indexCount;
+
+    auto    countNewVertices = [&seen, &meshletID](GLuint a, GLuint b, GLuint c)
+    {
+        return ((seen[a] != meshletID) + (seen[b] != meshletID && b != a)
+                + (seen[c] != meshletID && c != a && c != b));
+    };
+    for (size_t t = begin; t < end; t += 3)
+    {
+        GLuint  a = indices[t], b = indices[t + 1], c = indices[t + 2];
+        size_t  newVertices = countNewVertices(a, b, c);
+        if (uniqueVertices + newVertices > MESHLET_VERTICES || (t - begin) / 3 >= MESHLET_TRIANGLES)
+        {
+            meshlets.push_back(ComputeMeshletBounds(vertices, &indices[begin], t - begin));
+            meshlets.back().indexOffset = static_cast<uint32_t>(begin);
+            begin = t;
+            uniqueVertices = 0;
+            ++meshletID;
+            newVertices = countNewVertices(a, b, c);
+        }
+        seen[a] = seen[b] = seen[c] = meshletID;
+        uniqueVertices += newVertices;
+    }
+    if (begin < end)
+    {
+        meshlets.push_back(ComputeMeshletBounds(vertices, &indices[begin], end - begin));
+        meshlets.back().indexOffset = static_cast<uint32_t>(begin);
+    }
+    return (meshlets);
+};
+
+// cone 의 cutoff 는 축과 가장 벌어진 삼각형 노멀 사이 각의 sin 값이다. 노멀이 반구를 넘게 퍼져 있으면
+// 1 로 두어 뒷면 검사를 하지 않는다.
+Meshlet MeshOptimizer::ComputeMeshletBounds(const std::vector<mVertex>& vertices, const GLuint* indices, size_t indexCount)
+{
+    Meshlet     meshlet {};
+    meshlet.indexCount = static_cast<uint32_t>(indexCount);
+
+    glm::vec3   minimum = vertices[indices[0]].position, maximum = minimum;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        minimum = glm::min(minimum, vertices[indices[i]].position);
+        maximum = glm::max(maximum, vertices[indices[i]].position);
+    }
+    glm::vec3   center = (minimum + maximum) * 0.5f;
+    float       radius = 0.0f;
+    for (size_t i = 0; i < indexCount; ++i)
+        radius = std::max(radius, glm::length(vertices[indices[i]].position - center));
+    meshlet.sphere = glm::vec4(center, radius);
+
+    std::vector<glm::vec3>  normals;
+    glm::vec3               axis(0.0f);
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        const glm::vec3&    p0 = vertices[indices[i]].position;
+        glm::vec3           normal = glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+        float               length = glm::length(normal);
+        if (length <= 0.0f)
+            continue ;
+        normals.push_back(normal / length);
+        axis += normals.back();
+    }
+    meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    float   axisLength = glm::length(axis);
+    if (normals.empty() || axisLength <= 0.0f)
+        return (meshlet);
+    axis /= axisLength;
+    float   minDot = 1.0f;
+    for (const glm::vec3& normal : normals)
+        minDot = std::min(minDot, glm::dot(axis, normal));
+    if (minDot <= 0.0f)
+        return (meshlet);
+    meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - minDot * minDot));
+    return (meshlet);
+};
+
+// Forsyth 의 점수 함수. 방금 쓴 삼각형의 정점은 조금 낮게, 남은 삼각형이 적은 정점은 높게 준다.
+float   MeshOptimizer::VertexScore(int cachePosition, unsigned int remainingValence)
+{
+    if (remainingValence == 0)
+        return (-1.0f);
+    float   score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (CACHE_SIZE - 3), 1.5f);
+    }
+    return (score + 2.0f / std::sqrt(static_cast<float>(remainingValence)));
+};
+
+void    MeshOptimizer::OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount)
+{
+    size_t  triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return ;
+
+    // 정점별 인접 삼각형 목록 (CSR). 삼각형을 내보낼 때마다 앞쪽 activeCount 구간에서 빼 간다.
+    std::vector<unsigned int>   offsets(vertexCount + 1, 0);
+    for (GLuint index : indices)
+        ++offsets[index + 1];
+    for (size_t i = 0; i < vertexCount; ++i)
+        offsets[i + 1] += offsets[i];
+    std::vector<unsigned int>   adjacency(indices.size());
+    std::vector<unsigned int>   activeCount(vertexCount, 0);
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+        {
+            GLuint  v = indices[t * 3 + k];
+            adjacency[offsets[v] + activeCount[v]++] = static_cast<unsigned int>(t);
+        }
+
+    std::vector<float>  vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        vertexScore[v] = VertexScore(-1, activeCount[v]);
+    std::vector<char>   emitted(triangleCount, 0);
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    std::vector<GLuint> cache, nextCache;
+    cache.reserve(CACHE_SIZE + 3);
+    nextCache.reserve(CACHE_SIZE + 3);
+    size_t  cursor = 0;
+    long    best = -1;
+
+    while (result.size() < indices.size())
+    {
+        // 캐시 근처에 후보가 없으면 아직 안 나간 삼각형 중 순서상 첫 번째로 넘어간다.
+        if (best < 0)
+        {
+            while (emitted[cursor])
+                ++cursor;
+            best = static_cast<long>(cursor);
+        }
+        size_t  triangle = static_cast<size_t>(best);
+        emitted[triangle] = 1;
+        nextCache.clear();
+        for (int k = 0; k < 3; ++k)
+        {
+            GLuint  v = indices[triangle * 3 + k];
+            result.push_back(v);
+            nextCache.push_back(v);
+            unsigned int    begin = offsets[v], end = offsets[v] + activeCount[v];
+            for (unsigned int a = begin; a < end; ++a)
+                if (adjacency[a] == triangle)
+                {
+                    std::swap(adjacency[a], adjacency[end - 1]);
+                    --activeCount[v];
+                    break ;
+                }
+        }
+        for (GLuint v : cache)
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+                nextCache.push_back(v);
+        // 캐시에서 밀려난 정점은 캐시 점수 없이 다시 계산한다.
+        for (size_t i = CACHE_SIZE; i < nextCache.size(); ++i)
+            vertexScore[nextCache[i]] = VertexScore(-1, activeCount[nextCache[i]]);
+        if (nextCache.size() > CACHE_SIZE)
+            nextCache.resize(CACHE_SIZE);
+        std::swap(cache, nextCache);
+        for (size_t i = 0; i < cache.size(); ++i)
+            vertexScore[cache[i]] = VertexScore(static_cast<int>(i), activeCount[cache[i]]);
+
+        best = -1;
+        float   bestScore = -1.0f;
+        for (GLuint v : cache)
+            for (unsigned int a = offsets[v]; a < offsets[v] + activeCount[v]; ++a)
+            {
+                unsigned int    t = adjacency[a];
+                float           score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]]
+                                        + vertexScore[indices[t * 3 + 2]];
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = static_cast<long>(t);
+                }
+            }
+    }
+    indices.swap(result);
+};
+
+size_t  MeshOptimizer::CountCacheMisses(const GLuint* indices, size_t indexCount, std::vector<unsigned int>& timestamps,
+                                        unsigned int& time, unsigned int cacheSize)
+{
+    size_t  misses = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        GLuint  v = indices[i];
+        if (time - timestamps[v] > cacheSize)
+        {
+            timestamps[v] = time++;
+            ++misses;
+        }
+    }
+    return (misses);
+};
+
+VertexCacheStats    MeshOptimizer::AnalyzeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount,
+                                                    unsigned int cacheSize)
+{
+    VertexCacheStats    stats;
+    if (indices.empty() || vertexCount == 0)
+        return (stats);
+    // timestamp 차이로 FIFO 를 흉내 낸다. 처음엔 모든 정점이 캐시 밖에 있도록 시간을 앞당겨 둔다.
+    std::vector<unsigned int>   timestamps(vertexCount, 0);
+    std::vector<char>           used(vertexCount, 0);
+    unsigned int                time = cacheSize + 1;
+    size_t  misses = CountCacheMisses(indices.data(), indices.size(), timestamps, time, cacheSize);
+    size_t  usedCount = 0;
+    for (GLuint index : indices)
+        if (!used[index])
+        {
+            used[index] = 1;
+            ++usedCount;
+        }
+    stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / usedCount;
+    return (stats);
+};
+
+// Tipsify 의 클러스터 정렬. 캐시가 끊기는 지점에서 클러스터를 나누고, 바깥을 향하는 클러스터부터 그린다.
+// 클러스터 안쪽 순서는 그대로라 ACMR 은 threshold 배 이상 나빠지지 않는다.
+void    MeshOptimizer::OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<mVertex>& vertices,
+                                        float threshold)
+{
+    const unsigned int  cacheSize = 16;
+    size_t              triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return ;
+
+    std::vector<unsigned int>   timestamps(vertices.size(), 0);
+    unsigned int                time = cacheSize + 1;
+    size_t  totalMisses = CountCacheMisses(indices.data(), indices.size(), timestamps, time, cacheSize);
+    float   targetACMR = static_cast<float>(totalMisses) / triangleCount * threshold;
+
+    std::vector<size_t> clusterStarts;
+    std::fill(timestamps.begin(), timestamps.end(), 0);
+    time = cacheSize + 1;
+    size_t  clusterMisses = 0, clusterTriangles = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        size_t  misses = CountCacheMisses(&indices[t * 3], 3, timestamps, time, cacheSize);
+        bool    hardBoundary = misses == 3;
+        bool    softBoundary = clusterTriangles >= 16
+                            && static_cast<float>(clusterMisses) / clusterTriangles <= targetACMR;
+        if (t == 0 || hardBoundary || softBoundary)
+        {
+            clusterStarts.push_back(t);
+            clusterMisses = 0;
+            clusterTriangles = 0;
+        }
+        clusterMisses += misses;
+        ++clusterTriangles;
+    }
+    clusterStarts.push_back(triangleCount);
+    if (clusterStarts.size() <= 2)
+        return ;
+
+    glm::vec3   meshCenter(0.0f);
+    for (const mVertex& vertex : vertices)
+        meshCenter += vertex.position;
+    meshCenter /= static_cast<float>(vertices.size());
+
+    size_t              clusterCount = clusterStarts.size() - 1;
+    std::vector<float>  sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        glm::vec3   center(0.0f), normal(0.0f);
+        float       area = 0.0f;
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            const glm::vec3&    p0 = vertices[indices[t * 3]].position;
+            const glm::vec3&    p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3&    p2 = vertices[indices[t * 3 + 2]].position;
+            glm::vec3           faceNormal = glm::cross(p1 - p0, p2 - p0);
+            float               faceArea = glm::length(faceNormal);
+            center += (p0 + p1 + p2) * (faceArea / 3.0f);
+            normal += faceNormal;
+            area += faceArea;
+        }
+        if (area > 0.0f)
+            center /= area;
+        float   normalLength = glm::length(normal);
+        sortKeys[c] = normalLength > 0.0f ? glm::dot(center - meshCenter, normal / normalLength) : 0.0f;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b)
+    { return (sortKeys[a] > sortKeys[b]); });
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    for (size_t c : order)
+        result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    indices.swap(result);
+};
+
+// 인덱스가 처음 참조하는 순서대로 정점을 다시 배치한다. 참조되지 않는 정점은 빠진다.
+void    MeshOptimizer::OptimizeVertexFetch(std::vector<mVertex>& vertices, std::vector<GLuint>& indices)
+{
+    const GLuint            unused = static_cast<GLuint>(-1);
+    std::vector<GLuint>     remap(vertices.size(), unused);
+    std::vector<mVertex>    result;
+    result.reserve(vertices.size());
+    for (GLuint& index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = static_cast<GLuint>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+};
+
+#endif
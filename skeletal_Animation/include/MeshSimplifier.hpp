@@ -0,0 +1,323 @@
+#ifndef MESHSIMPLIFIER_HPP
+#define MESHSIMPLIFIER_HPP
+
+#include "Common.hpp"
+#include "Mesh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// 평면까지 거리 제곱의 합을 나타내는 대칭 4x4 행렬 (Garland-Heckbert)
+// 면적으로 가중하고 가중치 합으로 나눠서, Evaluate 값이 모델 좌표계의 평균 거리 제곱이 되게 한다.
+struct Quadric
+{
+    double  a2 { 0 }, b2 { 0 }, c2 { 0 }, ab { 0 }, ac { 0 }, bc { 0 };
+    double  ad { 0 }, bd { 0 }, cd { 0 }, d2 { 0 };
+    double  weight { 0 };
+
+    Quadric&    operator+=(const Quadric& other);
+    void        AddPlane(const glm::vec3& normal, float distance, float weight);
+    double      Evaluate(const glm::vec3& point) const;
+};
+
+Quadric&    Quadric::operator+=(const Quadric& other)
+{
+    a2 += other.a2; b2 += other.b2; c2 += other.c2;
+    ab += other.ab; ac += other.ac; bc += other.bc;
+    ad += other.ad; bd += other.bd; cd += other.cd; d2 += other.d2;
+    weight += other.weight;
+    return (*this);
+};
+
+void    Quadric::AddPlane(const glm::vec3& normal, float distance, float weight)
+{
+    double  a = normal.x, b = normal.y, c = normal.z, d = distance;
+    a2 += weight * a * a; b2 += weight * b * b; c2 += weight * c * c;
+    ab += weight * a * b; ac += weight * a * c; bc += weight * b * c;
+    ad += weight * a * d; bd += weight * b * d; cd += weight * c * d; d2 += weight * d * d;
+    this->weight += weight;
+};
+
+double  Quadric::Evaluate(const glm::vec3& point) const
+{
+    double  x = point.x, y = point.y, z = point.z;
+    double  result = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z)
+                    + 2 * (ad * x + bd * y + cd * z) + d2;
+    return (weight > 0 ? std::max(result, 0.0) / weight : 0.0);
+};
+
+// 정점 버퍼는 그대로 두고 인덱스만 줄이는 edge collapse 단순화.
+// 한 정점을 이웃 정점으로 합치기만 하므로 모든 LOD 가 같은 정점 버퍼를 쓸 수 있다.
+// 열린 경계에 걸린 정점은 모양이 찢어지지 않도록 움직이지 않는다.
+// UV/노멀 seam 의 정점 (같은 위치의 사본) 은 seam 을 따라서만, 모든 사본이 같은 방향으로 함께 옮겨질 때만 합친다.
+class MeshSimplifier
+{
+public:
+    static std::vector<GLuint>  Simplify(const std::vector<mVertex>& vertices, const std::vector<GLuint>& indices,
+                                        size_t targetIndexCount, float& error);
+private:
+    struct Collapse
+    {
+        GLuint  from, to;
+        double  cost;
+    };
+
+    // 같은 위치의 정점끼리 nextCopy 로 고리를 이룬다. 사본이 없으면 자기 자신을 가리킨다.
+    struct Topology
+    {
+        std::vector<GLuint> positionID, nextCopy;
+        std::vector<char>   locked;
+    };
+
+    // 한 번의 pass 에서 쓰는 정점 -> 삼각형 인접 정보
+    struct Adjacency
+    {
+        std::vector<unsigned int>   offsets, triangles;
+    };
+
+    MeshSimplifier() {};
+    ~MeshSimplifier() {};
+
+    static Topology BuildTopology(const std::vector<mVertex>& vertices, const std::vector<GLuint>& indices);
+    static void     BuildAdjacency(const std::vector<GLuint>& indices, size_t vertexCount, Adjacency& adjacency);
+    static bool     MatchSeam(const Topology& topology, const Adjacency& adjacency, const std::vector<GLuint>& indices,
+                            GLuint from, GLuint to, std::vector<std::pair<GLuint, GLuint>>& pairs);
+    static bool     FlipsTriangle(const std::vector<mVertex>& vertices, const GLuint* triangle, GLuint from, GLuint to);
+};
+
+MeshSimplifier::Topology    MeshSimplifier::BuildTopology(const std::vector<mVertex>& vertices,
+                                                        const std::vector<GLuint>& indices)
+{
+    Topology                topology;
+    std::vector<GLuint>&    positionID = topology.positionID;
+    std::vector<char>&      locked = topology.locked;
+    positionID.resize(vertices.size());
+    topology.nextCopy.resize(vertices.size());
+    locked.assign(vertices.size(), 0);
+
+    // 같은 위치를 가진 정점이 여럿이면 속성 seam 이다. 첫 사본 뒤에 끼워 넣어 고리를 만든다.
+    std::unordered_map<std::string, GLuint> firstAtPosition;
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        std::string key(reinterpret_cast<const char*>(&vertices[i].position), sizeof(glm::vec3));
+        auto        found = firstAtPosition.emplace(key, static_cast<GLuint>(i));
+        GLuint      first = found.first->second;
+        positionID[i] = first;
+        topology.nextCopy[i] = static_cast<GLuint>(i);
+        if (!found.second)
+        {
+            topology.nextCopy[i] = topology.nextCopy[first];
+            topology.nextCopy[first] = static_cast<GLuint>(i);
+        }
+    }
+
+    // 위치 기준으로 삼각형 하나에만 속한 edge 는 열린 경계다.
+    std::unordered_map<uint64_t, int>   edgeCount;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        for (int k = 0; k < 3; ++k)
+        {
+            uint64_t    a = positionID[indices[t + k]], b = positionID[indices[t + (k + 1) % 3]];
+            ++edgeCount[std::min(a, b) << 32 | std::max(a, b)];
+        }
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        for (int k = 0; k < 3; ++k)
+        {
+            GLuint      va = indices[t + k], vb = indices[t + (k + 1) % 3];
+            uint64_t    a = positionID[va], b = positionID[vb];
+            if (edgeCount[std::min(a, b) << 32 | std::max(a, b)] != 1)
+                continue ;
+            // 경계 위치의 다른 사본도 함께 잠가야 경계가 벌어지지 않는다.
+            for (GLuint v : { va, vb })
+            {
+                GLuint  copy = v;
+                do
+                {
+                    locked[copy] = 1;
+                    copy = topology.nextCopy[copy];
+                }
+                while (copy != v);
+            }
+        }
+    return (topology);
+};
+
+void    MeshSimplifier::BuildAdjacency(const std::vector<GLuint>& indices, size_t vertexCount, Adjacency& adjacency)
+{
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (GLuint index : indices)
+        ++adjacency.offsets[index + 1];
+    for (size_t i = 0; i < vertexCount; ++i)
+        adjacency.offsets[i + 1] += adjacency.offsets[i];
+    adjacency.triangles.resize(indices.size());
+    std::vector<unsigned int>   fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t t = 0; t < indices.size(); ++t)
+        adjacency.triangles[fill[indices[t]]++] = static_cast<unsigned int>(t / 3);
+};
+
+// from 의 사본마다 to 위치의 사본 중 삼각형을 같이 쓰는 것을 찾는다. 하나라도 없으면 from -> to 는 seam 을 따르지 않는다.
+// 사본이 없는 정점은 (from, to) 하나만 돌려준다.
+bool    MeshSimplifier::MatchSeam(const Topology& topology, const Adjacency& adjacency, const std::vector<GLuint>& indices,
+                                GLuint from, GLuint to, std::vector<std::pair<GLuint, GLuint>>& pairs)
+{
+    pairs.clear();
+    if (topology.nextCopy[from] == from)
+    {
+        pairs.emplace_back(from, to);
+        return (true);
+    }
+    GLuint  target = topology.positionID[to];
+    if (topology.positionID[from] == target)
+        return (false);
+    const GLuint    none = static_cast<GLuint>(-1);
+    GLuint          copy = from;
+    do
+    {
+        GLuint  match = copy == from ? to : none;
+        for (unsigned int a = adjacency.offsets[copy]; a < adjacency.offsets[copy + 1] && match == none; ++a)
+            for (int k = 0; k < 3; ++k)
+            {
+                GLuint  other = indices[adjacency.triangles[a] * 3 + k];
+                if (topology.positionID[other] == target)
+                    match = other;
+            }
+        if (topology.locked[copy] || match == none)
+            return (false);
+        pairs.emplace_back(copy, match);
+        copy = topology.nextCopy[copy];
+    }
+    while (copy != from);
+    return (true);
+};
+
+// from 을 to 로 옮겼을 때 삼각형 방향이 뒤집히면 거절한다.
+bool    MeshSimplifier::FlipsTriangle(const std::vector<mVertex>& vertices, const GLuint* triangle, GLuint from, GLuint to)
+{
+    int k = triangle[0] == from ? 0 : (triangle[1] == from ? 1 : 2);
+    const glm::vec3&    p1 = vertices[triangle[(k + 1) % 3]].position;
+    const glm::vec3&    p2 = vertices[triangle[(k + 2) % 3]].position;
+    glm::vec3           before = glm::cross(p1 - vertices[from].position, p2 - vertices[from].position);
+    glm::vec3           after = glm::cross(p1 - vertices[to].position, p2 - vertices[to].position);
+    return (glm::dot(before, after) <= 0.0f);
+};
+
+// 비용이 낮은 collapse 부터 한 번에 여러 개를 적용하는 pass 를 목표 개수에 닿을 때까지 반복한다.
+// 한 pass 안에서는 건드린 정점 주변을 잠가 두어 인접 정보를 다시 만들지 않아도 되게 한다.
+std::vector<GLuint> MeshSimplifier::Simplify(const std::vector<mVertex>& vertices, const std::vector<GLuint>& indices,
+                                            size_t targetIndexCount, float& error)
+{
+    std::vector<GLuint> result = indices;
+    Topology            topology = BuildTopology(vertices, indices);
+    const std::vector<char>&    locked = topology.locked;
+    std::vector<Quadric>    quadrics(vertices.size());
+    double              maxCost = 0.0;
+
+    for (size_t t = 0; t + 2 < result.size(); t += 3)
+    {
+        const glm::vec3&    p0 = vertices[result[t]].position;
+        glm::vec3           normal = glm::cross(vertices[result[t + 1]].position - p0, vertices[result[t + 2]].position - p0);
+        float               area = glm::length(normal);
+        if (area <= 0.0f)
+            continue ;
+        normal /= area;
+        Quadric plane;
+        plane.AddPlane(normal, -glm::dot(normal, p0), area);
+        for (int k = 0; k < 3; ++k)
+            quadrics[result[t + k]] += plane;
+    }
+
+    Adjacency                   adjacency;
+    std::vector<char>           touched(vertices.size());
+    std::vector<Collapse>       collapses;
+    std::vector<std::pair<GLuint, GLuint>>  pairs;
+    // seam 의 collapse 비용은 함께 옮겨지는 사본들 중 가장 큰 비용이다.
+    auto    evaluate = [&](GLuint from, GLuint to, double& cost)
+    {
+        if (locked[from] || !MatchSeam(topology, adjacency, result, from, to, pairs))
+            return (false);
+        cost = 0.0;
+        for (const std::pair<GLuint, GLuint>& pair : pairs)
+        {
+            Quadric combined = quadrics[pair.first];
+            combined += quadrics[pair.second];
+            cost = std::max(cost, combined.Evaluate(vertices[pair.second].position));
+        }
+        return (true);
+    };
+    while (result.size() > targetIndexCount)
+    {
+        BuildAdjacency(result, vertices.size(), adjacency);
+        collapses.clear();
+        for (size_t t = 0; t + 2 < result.size(); t += 3)
+            for (int k = 0; k < 3; ++k)
+            {
+                GLuint  from = result[t + k], to = result[t + (k + 1) % 3];
+                double  cost;
+                if (evaluate(from, to, cost))
+                    collapses.push_back(Collapse { from, to, cost });
+                if (evaluate(to, from, cost))
+                    collapses.push_back(Collapse { to, from, cost });
+            }
+        if (collapses.empty())
+            break ;
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+        { return (a.cost < b.cost); });
+
+        // collapse 하나가 대략 삼각형 두 개를 없앤다. 마지막 pass 에서 목표를 너무 넘기지 않게 개수를 제한한다.
+        size_t  budget = std::max<size_t>(1, (result.size() - targetIndexCount) / 6);
+        size_t  applied = 0;
+        std::fill(touched.begin(), touched.end(), 0);
+        std::vector<GLuint> remap(vertices.size());
+        for (size_t i = 0; i < remap.size(); ++i)
+            remap[i] = static_cast<GLuint>(i);
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (applied >= budget)
+                break ;
+            MatchSeam(topology, adjacency, result, collapse.from, collapse.to, pairs);
+            bool    valid = true;
+            for (const std::pair<GLuint, GLuint>& pair : pairs)
+            {
+                GLuint  from = pair.first, to = pair.second;
+                valid = valid && !touched[from] && !touched[to];
+                for (unsigned int a = adjacency.offsets[from]; a < adjacency.offsets[from + 1] && valid; ++a)
+                {
+                    const GLuint*   triangle = &result[adjacency.triangles[a] * 3];
+                    if (triangle[0] != to && triangle[1] != to && triangle[2] != to)
+                        valid = !FlipsTriangle(vertices, triangle, from, to);
+                }
+            }
+            if (!valid)
+                continue ;
+            for (const std::pair<GLuint, GLuint>& pair : pairs)
+            {
+                for (unsigned int a = adjacency.offsets[pair.first]; a < adjacency.offsets[pair.first + 1]; ++a)
+                    for (int k = 0; k < 3; ++k)
+                        touched[result[adjacency.triangles[a] * 3 + k]] = 1;
+                touched[pair.second] = 1;
+                remap[pair.first] = pair.second;
+                quadrics[pair.second] += quadrics[pair.first];
+            }
+            maxCost = std::max(maxCost, collapse.cost);
+            ++applied;
+        }
+        if (applied == 0)
+            break ;
+
+        size_t  write = 0;
+        for (size_t t = 0; t + 2 < result.size(); t += 3)
+        {
+            GLuint  a = remap[result[t]], b = remap[result[t + 1]], c = remap[result[t + 2]];
+            if (a == b || b == c || a == c)
+                continue ;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+    error = static_cast<float>(std::sqrt(maxCost));
+    return (result);
+};
+
+#endif
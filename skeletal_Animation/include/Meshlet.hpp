@@ -0,0 +1,49 @@
+#ifndef MESHLET_HPP
+#define MESHLET_HPP
+
+#include "Common.hpp"
+
+// 인덱스 버퍼 안의 연속된 삼각형 묶음 (정점 64 개, 삼각형 124 개 이하)
+// sphere 는 (중심, 반지름), cone 은 (평균 노멀 축, cutoff). 모두 모델 좌표계
+struct Meshlet
+{
+    uint32_t    indexOffset;
+    uint32_t    indexCount;
+    glm::vec4   sphere;
+    glm::vec4   cone;
+};
+
+// view-projection 행렬에서 뽑은 여섯 평면. 평면 노멀은 안쪽을 향한다.
+struct Frustum
+{
+    glm::vec4   planes[6];
+
+    static Frustum  FromMatrix(const glm::mat4& viewProjection);
+    bool    Intersects(const glm::vec3& center, float radius) const;
+};
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+    Frustum     frustum;
+    glm::vec4   rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    for (int i = 0; i < 3; ++i)
+    {
+        frustum.planes[i * 2] = rows[3] + rows[i];
+        frustum.planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+    for (auto& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return (frustum);
+};
+
+bool    Frustum::Intersects(const glm::vec3& center, float radius) const
+{
+    for (const auto& plane : this->planes)
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return (false);
+    return (true);
+};
+
+#endif
@@ -0,0 +1,613 @@
+#ifndef MODEL_HPP
+#define MODEL_HPP
+
+#include "Common.hpp"
+#include "Program.hpp"
+#include "Mesh.hpp"
+#include "MeshCache.hpp"
+#include "ModelUpload.hpp"
+#include "MeshOptimizer.hpp"
+#include "ObjLoader.hpp"
+#include "GlbLoader.hpp"
+#include "TangentSpace.hpp"
+#include "AssimpGLMHelpers.hpp"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+class Model
+{
+public:
+    static std::unique_ptr<Model>   LoadModel(const std::string& path, float weldEpsilon = 0.0f,
+                                            bool packBuffers = true, bool keepCollision = false);
+    static std::unique_ptr<Model>   LoadModelAsync(const std::string& path, float weldEpsilon = 0.0f,
+                                            bool packBuffers = true, bool keepCollision = false);
+
+    ~Model();
+    bool    Update(UploadBudget& budget);
+    bool    IsReady(void) const { return (this->ready); };
+    void    draw(Program* program);
+    void    draw(Program* program, const glm::mat4& model, const glm::vec3& cameraPos,
+                float fovy = 45.0f, float viewportHeight = height);
+    void    drawCulled(Program* program, const glm::mat4& model, const glm::mat4& viewProjection,
+                    const glm::vec3& cameraPos, float fovy = 45.0f, float viewportHeight = height);
+    void    drawDepth(void);
+    void    drawDepth(const glm::mat4& model, const glm::vec3& cameraPos, float fovy = 45.0f,
+                    float viewportHeight = height);
+    size_t  GetVisibleMeshletCount(void) const;
+private:
+    // LOD0 (원본) 포함 단계 수
+    static constexpr unsigned int   LOD_LEVELS = 4;
+    // 큰 메쉬의 정점 / 면 변환을 나누는 단위
+    static constexpr size_t         CONVERT_GRAIN = 16384;
+
+    std::unordered_map<std::string, mTexture>   textures_loaded;
+    std::vector<Mesh>   meshes;
+    std::string         directory;
+    bool                packBuffers { true };
+    bool                keepCollision { false };
+    std::unique_ptr<ModelBuffer>    buffer;
+    std::unique_ptr<TextureBatch>   textureBatch;
+    std::unique_ptr<PendingModel>   pending;
+    std::future<void>               loading;
+    bool                            ready { false };
+    // 메쉬 순서로 정렬한 노드 인스턴스의 월드 변환. GPU 에는 instanceVBO 로 올라간다.
+    std::vector<glm::mat4>          instanceTransforms;
+    GLuint                          instanceVBO { 0 };
+
+    Model() {};
+    void    init(const std::string& path, float weldEpsilon);
+    void    prepare(const std::string& path, float weldEpsilon);
+    bool    upload(UploadBudget& budget);
+    void    loadCache(std::unique_ptr<MeshCache> cache);
+    void    importScene(const std::string& path, unsigned int importFlags, std::vector<MeshData>& meshData);
+    void    loadObj(const std::string& path, std::vector<MeshData>& meshData);
+    void    loadGlb(std::vector<MeshData>& meshData);
+    void    processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sourceMeshes,
+                        std::vector<int>& meshSlots, const glm::mat4& parentTransform);
+    void    convertMeshes(const std::vector<aiMesh*>& sourceMeshes, const aiScene* scene, std::vector<MeshData>& meshData);
+    static void convertMesh(const aiMesh* mesh, MeshData& data);
+    std::vector<mTexture>   loadMeshTextures(const aiMesh* mesh, const aiScene* scene);
+    std::vector<mTexture>   loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
+    mTexture    loadTexture(const std::string& path, const std::string& typeName);
+    void        uploadTextures(std::vector<MeshData>& meshData);
+    bool        createMeshes(PendingModel& pending, UploadBudget& budget);
+    void        createInstances(std::vector<MeshInstance>& instances);
+    glm::mat4   getNearestInstance(const Mesh& mesh, const glm::mat4& model, const glm::vec3& cameraPos) const;
+};
+
+std::unique_ptr<Model>   Model::LoadModel(const std::string& path, float weldEpsilon, bool packBuffers,
+                                        bool keepCollision)
+{
+    std::unique_ptr<Model>  model = std::unique_ptr<Model>(new Model());
+    model->packBuffers = packBuffers;
+    model->keepCollision = keepCollision;
+    model->init(path, weldEpsilon);
+    return (std::move(model));
+};
+
+// 파싱과 변환은 작업자 스레드에서 돌리고 바로 돌아온다. GL 업로드는 Update 가 프레임마다 나눠서 한다.
+std::unique_ptr<Model>   Model::LoadModelAsync(const std::string& path, float weldEpsilon, bool packBuffers,
+                                            bool keepCollision)
+{
+    std::unique_ptr<Model>  model = std::unique_ptr<Model>(new Model());
+    model->packBuffers = packBuffers;
+    model->keepCollision = keepCollision;
+    Model*  target = model.get();
+    model->loading = ThreadPool::Get().Submit([target, path, weldEpsilon]() { target->prepare(path, weldEpsilon); });
+    return (std::move(model));
+};
+
+Model::~Model()
+{
+    if (this->loading.valid())
+        this->loading.wait();
+    if (this->instanceVBO && glfwGetCurrentContext())
+        glDeleteBuffers(1, &this->instanceVBO);
+    GpuMemory::Get().Release(GpuMemory::BUFFER, this->instanceVBO);
+};
+
+// 컨텍스트 스레드에서 매 프레임 부른다. 준비가 끝났으면 budget 안에서 텍스처, 메쉬 순서로 올린다.
+bool    Model::Update(UploadBudget& budget)
+{
+    if (this->ready)
+        return (true);
+    if (this->loading.valid())
+    {
+        if (this->loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return (false);
+        // 작업자 스레드에서 던진 오류를 여기서 다시 던진다.
+        this->loading.get();
+    }
+    return (upload(budget));
+};
+
+void    Model::draw(Program* program)
+{
+    if (!this->ready)
+    {
+        ModelPlaceholder::Draw(program);
+        return ;
+    }
+    Mesh::BeginMaterials(program);
+    if (this->buffer)
+        this->buffer->Bind();
+    for (auto& mesh : this->meshes)
+        mesh.Draw();
+    if (this->buffer)
+        glBindVertexArray(0);
+};
+
+// 메쉬마다 화면 크기에 맞는 LOD 를 골라서 그린다. model 은 셰이더에 넘긴 것과 같은 행렬이어야 한다.
+// 여러 노드가 쓰는 메쉬는 카메라에 가장 가까운 인스턴스 기준으로 LOD 를 골라 모든 인스턴스를 한 번에 그린다.
+void    Model::draw(Program* program, const glm::mat4& model, const glm::vec3& cameraPos,
+                    float fovy, float viewportHeight)
+{
+    if (!this->ready)
+    {
+        ModelPlaceholder::Draw(program);
+        return ;
+    }
+    Mesh::BeginMaterials(program);
+    if (this->buffer)
+        this->buffer->Bind();
+    for (auto& mesh : this->meshes)
+    {
+        glm::mat4   nearest = getNearestInstance(mesh, model, cameraPos);
+        mesh.SelectLod(nearest, cameraPos, fovy, viewportHeight);
+        mesh.RequestTextureDetail(nearest, cameraPos, fovy, viewportHeight);
+        mesh.Draw();
+    }
+    if (this->buffer)
+        glBindVertexArray(0);
+};
+
+// 깊이 프리패스 / 그림자 패스. 위치 스트림만 바인드하고, LOD 는 마지막 draw 가 고른 것을 그대로 쓴다.
+// 셰이더는 shader/depth_instanced.vert 처럼 location 0 의 위치와 6 의 인스턴스 변환만 받으면 된다.
+void    Model::drawDepth(void)
+{
+    if (!this->ready)
+        return ;
+    if (this->buffer)
+        this->buffer->BindDepth();
+    for (auto& mesh : this->meshes)
+        mesh.DrawDepth();
+    if (this->buffer)
+        glBindVertexArray(0);
+};
+
+// 색 패스보다 먼저 그리는 깊이 프리패스. 색 패스와 같은 인자로 LOD 를 먼저 고른다.
+// SelectLod 는 같은 인자로 다시 불러도 같은 LOD 를 돌려주므로 뒤따르는 draw / drawCulled 와 깊이가 맞는다.
+void    Model::drawDepth(const glm::mat4& model, const glm::vec3& cameraPos, float fovy, float viewportHeight)
+{
+    if (!this->ready)
+        return ;
+    for (auto& mesh : this->meshes)
+        mesh.SelectLod(getNearestInstance(mesh, model, cameraPos), cameraPos, fovy, viewportHeight);
+    drawDepth();
+};
+
+// LOD 를 고른 뒤 화면 밖 / 뒷면 meshlet 을 빼고 그린다. viewProjection 은 셰이더의 view 와 같은 행렬이다.
+void    Model::drawCulled(Program* program, const glm::mat4& model, const glm::mat4& viewProjection,
+                        const glm::vec3& cameraPos, float fovy, float viewportHeight)
+{
+    if (!this->ready)
+    {
+        ModelPlaceholder::Draw(program);
+        return ;
+    }
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+    Mesh::BeginMaterials(program);
+    if (this->buffer)
+        this->buffer->Bind();
+    for (auto& mesh : this->meshes)
+    {
+        glm::mat4   nearest = getNearestInstance(mesh, model, cameraPos);
+        mesh.SelectLod(nearest, cameraPos, fovy, viewportHeight);
+        mesh.RequestTextureDetail(nearest, cameraPos, fovy, viewportHeight);
+        if (mesh.GetInstanceCount() == 1)
+        {
+            mesh.DrawCulled(nearest, frustum, cameraPos);
+            continue ;
+        }
+        // meshlet 컬링은 인스턴스 하나 기준이라, 여러 인스턴스는 메쉬 전체 구로만 검사한다.
+        const glm::vec4&    bounds = mesh.GetBounds();
+        for (uint32_t i = 0; i < mesh.GetInstanceCount(); ++i)
+        {
+            glm::mat4   world = model * this->instanceTransforms[mesh.GetFirstInstance() + i];
+            float       scale = std::max(glm::length(glm::vec3(world[0])),
+                                std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+            if (frustum.Intersects(glm::vec3(world * glm::vec4(glm::vec3(bounds), 1.0f)), bounds.w * scale))
+            {
+                mesh.Draw();
+                break ;
+            }
+        }
+    }
+    if (this->buffer)
+        glBindVertexArray(0);
+};
+
+glm::mat4   Model::getNearestInstance(const Mesh& mesh, const glm::mat4& model, const glm::vec3& cameraPos) const
+{
+    glm::mat4   nearest = model;
+    float       nearestDistance = std::numeric_limits<float>::max();
+    glm::vec4   center = glm::vec4(glm::vec3(mesh.GetBounds()), 1.0f);
+    for (uint32_t i = 0; i < mesh.GetInstanceCount() && !this->instanceTransforms.empty(); ++i)
+    {
+        glm::mat4   world = model * this->instanceTransforms[mesh.GetFirstInstance() + i];
+        float       distance = glm::length(glm::vec3(world * center) - cameraPos);
+        if (distance < nearestDistance)
+        {
+            nearestDistance = distance;
+            nearest = world;
+        }
+    }
+    return (nearest);
+};
+
+size_t  Model::GetVisibleMeshletCount(void) const
+{
+    size_t  count = 0;
+    for (const auto& mesh : this->meshes)
+        count += mesh.GetVisibleMeshletCount();
+    return (count);
+};
+
+// 동기 로딩. 텍스처 디코딩을 기다린 뒤 예산 제한 없이 한 번에 올린다. 큐에 넣은 픽셀도 여기서 다 올린다.
+void    Model::init(const std::string& path, float weldEpsilon)
+{
+    UploadBudget    budget;
+    prepare(path, weldEpsilon);
+    uploadTextures(this->pending->meshData);
+    this->pending->texturesUploaded = true;
+    upload(budget);
+    TextureUploader::Get().Flush();
+};
+
+// GL 호출 없이 메쉬 데이터를 만들어 pending 에 둔다. 비동기 로딩에서는 작업자 스레드에서 돈다.
+void    Model::prepare(const std::string& path, float weldEpsilon)
+{
+    // 탄젠트는 Assimp 대신 TangentSpace 가 MikkTSpace 규칙으로 만든다.
+    const unsigned int  importFlags = aiProcess_Triangulate | aiProcess_FlipUVs;
+    MeshImportOptions   options;
+    options.weldEpsilon = weldEpsilon;
+    options.lodLevels = LOD_LEVELS;
+    options.buildMeshlets = true;
+
+    this->directory = path.substr(0, path.find_last_of('/'));
+    this->textureBatch = std::unique_ptr<TextureBatch>(new TextureBatch(this->directory, true));
+    this->pending = std::unique_ptr<PendingModel>(new PendingModel());
+    // 캐시에서 읽어도 내장 텍스처는 GLB 에서 디코딩하므로 먼저 연다.
+    if (GlbFile::CanLoad(path))
+        this->pending->glb = GlbFile::Open(path);
+    std::unique_ptr<MeshCache>  cache = MeshCache::Open(path, importFlags, options);
+    if (cache)
+    {
+        loadCache(std::move(cache));
+        return ;
+    }
+
+    std::vector<MeshData>   meshData;
+    if (ObjLoader::CanLoad(path))
+        loadObj(path, meshData);
+    else if (this->pending->glb)
+        loadGlb(meshData);
+    else
+        importScene(path, importFlags, meshData);
+    // 메쉬끼리는 서로 독립이므로 최적화도 메쉬마다 작업자 스레드에서 돌린다.
+    std::vector<MeshOptimizeReport> reports(meshData.size());
+    ThreadPool::Get().ParallelFor(meshData.size(), 1, [&meshData, &reports, &options](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            reports[i] = MeshOptimizer::Optimize(meshData[i], options);
+    });
+    for (size_t i = 0; i < reports.size(); ++i)
+        MeshOptimizer::PrintReport(path + "[" + std::to_string(i) + "]", reports[i]);
+    MeshOptimizer::PrintWeldSummary(path, reports);
+    if (!MeshCache::Write(path, importFlags, options, meshData, nullptr, &this->pending->instances))
+        std::cout << "Mesh cache failed to write for: " << path << std::endl;
+    for (const auto& data : meshData)
+        this->pending->sources.push_back(MeshSource { data.vertices.data(), data.vertices.size(),
+                                                    data.indices.data(), data.indices.size(), GL_UNSIGNED_INT });
+    this->pending->meshData = std::move(meshData);
+};
+
+// 텍스처를 먼저 다 올리고, 메쉬는 하나씩 올린다. 예산이 떨어지면 false 를 돌려주고 다음 프레임에 이어서 한다.
+bool    Model::upload(UploadBudget& budget)
+{
+    PendingModel&   pending = *this->pending;
+    if (!pending.texturesUploaded)
+    {
+        if (!this->textureBatch->UploadReady(budget))
+            return (false);
+        uploadTextures(pending.meshData);
+        pending.texturesUploaded = true;
+    }
+    if (!createMeshes(pending, budget))
+        return (false);
+    createInstances(pending.instances);
+    this->pending.reset();
+    this->textureBatch.reset();
+    this->ready = true;
+    return (true);
+};
+
+void    Model::importScene(const std::string& path, unsigned int importFlags, std::vector<MeshData>& meshData)
+{
+    Assimp::Importer    import;
+    const aiScene*  scene = import.ReadFile(path, importFlags);
+
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        throw (import.GetErrorString());
+    std::vector<aiMesh*>    sourceMeshes;
+    std::vector<int>        meshSlots(scene->mNumMeshes, -1);
+    processNode(scene->mRootNode, scene, sourceMeshes, meshSlots, glm::mat4(1.0f));
+    convertMeshes(sourceMeshes, scene, meshData);
+};
+
+// OBJ 는 노드 계층이 없으므로 메쉬마다 단위 변환 인스턴스 하나만 둔다.
+void    Model::loadObj(const std::string& path, std::vector<MeshData>& meshData)
+{
+    meshData = ObjLoader::Load(path);
+    for (size_t i = 0; i < meshData.size(); ++i)
+    {
+        for (auto& texture : meshData[i].textures)
+            texture = loadTexture(texture.path, texture.type);
+        this->pending->instances.push_back(MeshInstance { static_cast<uint32_t>(i), glm::mat4(1.0f) });
+    }
+};
+
+// 노드 변환은 GlbLoader 가 인스턴스로 채운다.
+void    Model::loadGlb(std::vector<MeshData>& meshData)
+{
+    meshData = GlbLoader::LoadStatic(*this->pending->glb, this->pending->instances);
+    for (auto& data : meshData)
+        for (auto& texture : data.textures)
+            texture = loadTexture(texture.path, texture.type);
+};
+
+void    Model::loadCache(std::unique_ptr<MeshCache> cache)
+{
+    std::vector<MeshData>&      meshData = this->pending->meshData;
+    std::vector<MeshSource>&    sources = this->pending->sources;
+    meshData.resize(cache->GetMeshCount());
+    for (size_t i = 0; i < cache->GetMeshCount(); ++i)
+    {
+        meshData[i].textures = cache->GetTextures(i);
+        for (auto& texture : meshData[i].textures)
+            texture = loadTexture(texture.path, texture.type);
+        meshData[i].lods = cache->GetLods(i);
+        meshData[i].bounds = cache->GetBounds(i);
+        meshData[i].meshlets = cache->GetMeshlets(i);
+        sources.push_back(MeshSource { cache->GetVertices(i), cache->GetVertexCount(i),
+                                    cache->GetIndices(i), cache->GetIndexCount(i), cache->GetIndexType(i) });
+    }
+    this->pending->instances = cache->GetInstances();
+    this->pending->cache = std::move(cache);
+};
+
+// 공용 버퍼 모드면 모든 메쉬를 한 VBO/EBO 에 이어 붙이고, 아니면 메쉬마다 따로 만든다.
+// 올린 메쉬의 CPU 쪽 정점/인덱스는 바로 해제하고, keepCollision 이면 LOD0 의 위치와 인덱스만 남긴다.
+bool    Model::createMeshes(PendingModel& pending, UploadBudget& budget)
+{
+    if (this->packBuffers && !this->buffer)
+        this->buffer = ModelBuffer::Create(pending.sources);
+    this->meshes.reserve(pending.sources.size());
+    for (; pending.nextMesh < pending.sources.size(); ++pending.nextMesh)
+    {
+        if (budget.IsSpent())
+            return (false);
+        const MeshSource&   source = pending.sources[pending.nextMesh];
+        MeshData&           data = pending.meshData[pending.nextMesh];
+        if (this->buffer)
+        {
+            MeshRange   range = this->buffer->Append(source.vertices, source.vertexCount, source.indices,
+                                                    source.indexCount, source.indexType);
+            this->meshes.emplace_back(this->buffer->GetVAO(), this->buffer->GetDepthVAO(), this->buffer->GetIndexType(),
+                                    range, source.indexCount, std::move(data.textures));
+        }
+        else
+            this->meshes.emplace_back(source.vertices, source.vertexCount, source.indices, source.indexCount,
+                                    source.indexType, std::move(data.textures));
+        Mesh&   mesh = this->meshes.back();
+        mesh.SetLods(data.lods, data.bounds);
+        mesh.SetMeshlets(std::move(data.meshlets));
+        if (this->keepCollision)
+            mesh.SetCollision(Mesh::MakeCollision(source.vertices, source.vertexCount, source.indices,
+                                                data.lods.empty() ? source.indexCount : data.lods[0].indexCount,
+                                                source.indexType));
+        budget.Consume(source.GetByteSize());
+        std::vector<mVertex>().swap(data.vertices);
+        std::vector<GLuint>().swap(data.indices);
+    }
+    return (true);
+};
+
+// 같은 aiMesh 를 여러 노드가 참조하면 메쉬는 한 번만 만들고 노드마다 (메쉬, 월드 변환) 인스턴스만 남긴다.
+// 여기서는 변환할 메쉬 목록만 모으고, 정점 변환은 convertMeshes 가 한꺼번에 한다.
+void    Model::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sourceMeshes,
+                        std::vector<int>& meshSlots, const glm::mat4& parentTransform)
+{
+    glm::mat4   transform = parentTransform * AssimpGLMHelpers::ConvertMatrixToGLMFormat(node->mTransformation);
+    for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+    {
+        int&    slot = meshSlots[node->mMeshes[i]];
+        if (slot < 0)
+        {
+            slot = static_cast<int>(sourceMeshes.size());
+            sourceMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+        }
+        this->pending->instances.push_back(MeshInstance { static_cast<uint32_t>(slot), transform });
+    }
+    for (unsigned int i = 0; i < node->mNumChildren; ++i)
+        processNode(node->mChildren[i], scene, sourceMeshes, meshSlots, transform);
+};
+
+// 정점 변환은 메쉬마다, 큰 메쉬는 구간마다 작업자 스레드에서 돌린다.
+// 텍스처 목록은 모델의 공용 상태 (textures_loaded, textureBatch) 를 건드리므로 이 스레드에서 차례로 만든다.
+void    Model::convertMeshes(const std::vector<aiMesh*>& sourceMeshes, const aiScene* scene, std::vector<MeshData>& meshData)
+{
+    meshData.resize(sourceMeshes.size());
+    for (size_t i = 0; i < sourceMeshes.size(); ++i)
+        meshData[i].textures = loadMeshTextures(sourceMeshes[i], scene);
+    ThreadPool::Get().ParallelFor(sourceMeshes.size(), 1, [&sourceMeshes, &meshData](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            convertMesh(sourceMeshes[i], meshData[i]);
+    });
+};
+
+// 출력 버퍼를 먼저 다 잡아 두고 구간마다 제자리에 쓴다.
+void    Model::convertMesh(const aiMesh* mesh, MeshData& data)
+{
+    data.vertices.resize(mesh->mNumVertices);
+    ThreadPool::Get().ParallelFor(mesh->mNumVertices, CONVERT_GRAIN, [mesh, &data](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            mVertex&    vertex = data.vertices[i];
+            vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            vertex.normal = glm::vec3(0.0f);
+            vertex.tangent = glm::vec4(0.0f);
+            if (mesh->HasNormals())
+                vertex.normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+            if (mesh->mTextureCoords[0])
+                vertex.texCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+            else
+                vertex.texCoords = glm::vec2(0.0f, 0.0f);
+            // 정적 모델도 AniModel 과 같은 정점 구조를 쓰므로 bone 영향은 비워 둔다.
+            for (unsigned int j = 0; j < MAX_BONE_INFLUENCE; ++j)
+            {
+                vertex.boneIDs[j] = -1;
+                vertex.weights[j] = 0.0f;
+            }
+        }
+    });
+
+    // 삼각형만 있으면 면 i 의 인덱스 위치가 3 * i 로 정해진다. 선이나 점이 섞여 있으면 차례로 채운다.
+    if (mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
+    {
+        for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
+            data.indices.insert(data.indices.end(), mesh->mFaces[i].mIndices,
+                                mesh->mFaces[i].mIndices + mesh->mFaces[i].mNumIndices);
+        return ;
+    }
+    data.indices.resize(static_cast<size_t>(mesh->mNumFaces) * 3);
+    ThreadPool::Get().ParallelFor(mesh->mNumFaces, CONVERT_GRAIN, [mesh, &data](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            std::copy(mesh->mFaces[i].mIndices, mesh->mFaces[i].mIndices + 3, &data.indices[i * 3]);
+    });
+    if (mesh->mTextureCoords[0])
+        TangentSpace::GenerateTangents(data);
+};
+
+// 인스턴스를 메쉬 순서로 정렬해서 한 버퍼에 올리고, 메쉬마다 자기 구간을 알려 준다.
+void    Model::createInstances(std::vector<MeshInstance>& instances)
+{
+    if (instances.empty())
+        for (uint32_t i = 0; i < this->meshes.size(); ++i)
+            instances.push_back(MeshInstance { i, glm::mat4(1.0f) });
+    std::stable_sort(instances.begin(), instances.end(), [](const MeshInstance& a, const MeshInstance& b)
+    { return (a.mesh < b.mesh); });
+    this->instanceTransforms.resize(instances.size());
+    for (size_t i = 0; i < instances.size(); ++i)
+        this->instanceTransforms[i] = instances[i].transform;
+
+    glGenBuffers(1, &this->instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, this->instanceTransforms.size() * sizeof(glm::mat4), this->instanceTransforms.data(),
+                GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GpuMemory::Get().Track(GpuMemory::BUFFER, this->instanceVBO, this->instanceTransforms.size() * sizeof(glm::mat4),
+                        "Model instances");
+
+    size_t  first = 0;
+    for (uint32_t mesh = 0; mesh < this->meshes.size(); ++mesh)
+    {
+        size_t  last = first;
+        while (last < instances.size() && instances[last].mesh == mesh)
+            ++last;
+        this->meshes[mesh].SetInstances(this->instanceVBO, static_cast<uint32_t>(first),
+                                        static_cast<uint32_t>(last - first));
+        first = last;
+    }
+};
+
+std::vector<mTexture>   Model::loadMeshTextures(const aiMesh* mesh, const aiScene* scene)
+{
+    std::vector<mTexture>   textures;
+    aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+    std::vector<mTexture>   diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE,
+                                                            "texture_diffuse");
+    textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+    std::vector<mTexture>   specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR,
+                                                            "texture_specular");
+    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+    std::vector<mTexture>   normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT,
+                                                            "texture_normal");
+    textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+    return (textures);
+};
+
+std::vector<mTexture>   Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
+{
+    std::vector<mTexture>   textures;
+    for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+    {
+        aiString    str;
+        mat->GetTexture(type, i, &str);
+        textures.push_back(loadTexture(str.C_Str(), typeName));
+    }
+    return (textures);
+};
+
+mTexture    Model::loadTexture(const std::string& path, const std::string& typeName)
+{
+    auto    loaded = this->textures_loaded.find(path);
+    if (loaded != this->textures_loaded.end())
+        return (loaded->second);
+    mTexture    texture;
+    texture.id = 0;
+    texture.type = typeName;
+    texture.path = path;
+    this->textures_loaded[path] = texture;
+    const unsigned char*    data;
+    size_t                  size;
+    if (this->pending && this->pending->glb && this->pending->glb->GetEmbeddedImage(path, data, size))
+        this->textureBatch->Request(path, TextureRole::FromType(typeName), this->pending->glb, data, size);
+    else
+        this->textureBatch->Request(path, TextureRole::FromType(typeName));
+    return (texture);
+};
+
+// 디코딩은 loadTexture 에서 이미 시작됐다. 여기서는 기다렸다가 텍스처 배열로 묶어 올리기만 한다.
+void    Model::uploadTextures(std::vector<MeshData>& meshData)
+{
+    std::unordered_map<std::string, std::shared_ptr<TextureHandle>> handles = this->textureBatch->UploadAll();
+    std::unordered_map<std::string, TextureLayer>   layers = this->textureBatch->TakeLayers();
+    auto    resolve = [&handles, &layers](mTexture& texture)
+    {
+        auto    layer = layers.find(texture.path);
+        if (layer != layers.end())
+        {
+            texture.array = layer->second.array;
+            texture.layer = layer->second.layer;
+            texture.id = layer->second.array->Get();
+        }
+        auto    handle = handles.find(texture.path);
+        if (handle == handles.end())
+            return ;
+        texture.handle = handle->second;
+        texture.id = handle->second->Get();
+    };
+    for (auto& texture : this->textures_loaded)
+        resolve(texture.second);
+    for (auto& data : meshData)
+        for (auto& texture : data.textures)
+            resolve(texture);
+    this->textureBatch.reset();
+};
+
+#endif
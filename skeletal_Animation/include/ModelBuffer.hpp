@@ -0,0 +1,169 @@
+#ifndef MODELBUFFER_HPP
+#define MODELBUFFER_HPP
+
+#include "Common.hpp"
+#include "Mesh.hpp"
+
+// 올릴 메쉬 하나의 정점/인덱스. import 결과의 vector 나 캐시의 맵핑 포인터를 가리킨다.
+struct MeshSource
+{
+    const mVertex*  vertices;
+    size_t          vertexCount;
+    const void*     indices;
+    size_t          indexCount;
+    GLenum          indexType;
+
+    size_t  GetByteSize(void) const
+    { return (vertexCount * (sizeof(mVertex) + sizeof(glm::vec3)) + indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint))); };
+};
+
+// 모델의 모든 메쉬를 담는 VAO / VBO / EBO 한 벌.
+// 메쉬마다 base vertex 와 첫 인덱스 위치만 다르고, 인덱스는 메쉬 안에서의 번호 그대로 쓴다.
+// 위치만 담은 스트림과 깊이 패스용 VAO 도 같은 base vertex / EBO 로 함께 둔다.
+class ModelBuffer
+{
+public:
+    static std::unique_ptr<ModelBuffer> Create(size_t vertexCount, size_t indexCount, GLenum indexType);
+    static std::unique_ptr<ModelBuffer> Create(const std::vector<MeshSource>& sources);
+
+    ~ModelBuffer();
+
+    MeshRange   Append(const mVertex* vertices, size_t vertexCount, const void* indices, size_t indexCount,
+                    GLenum sourceIndexType);
+    void        Bind(void) const { glBindVertexArray(this->VAO); };
+    void        BindDepth(void) const { glBindVertexArray(this->depthVAO); };
+
+    GLuint      GetVAO(void) const { return (this->VAO); };
+    GLuint      GetDepthVAO(void) const { return (this->depthVAO); };
+    GLenum      GetIndexType(void) const { return (this->indexType); };
+private:
+    GLuint  VAO { 0 }, VBO { 0 }, EBO { 0 };
+    GLuint  depthVAO { 0 }, positionVBO { 0 };
+    GLenum  indexType { GL_UNSIGNED_INT };
+    size_t  vertexCapacity { 0 }, indexCapacity { 0 };
+    size_t  vertexCount { 0 }, indexCount { 0 };
+
+    ModelBuffer() {};
+    void    init(size_t vertexCount, size_t indexCount, GLenum indexType);
+    size_t  getIndexSize(void) const
+    { return (this->indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint)); };
+};
+
+std::unique_ptr<ModelBuffer>    ModelBuffer::Create(size_t vertexCount, size_t indexCount, GLenum indexType)
+{
+    std::unique_ptr<ModelBuffer>    buffer = std::unique_ptr<ModelBuffer>(new ModelBuffer());
+    buffer->init(vertexCount, indexCount, indexType);
+    return (std::move(buffer));
+};
+
+// sources 전체가 들어갈 크기로 만든다. 모든 메쉬가 16 비트 인덱스로 충분하면 버퍼 전체를 16 비트로 만든다.
+std::unique_ptr<ModelBuffer>    ModelBuffer::Create(const std::vector<MeshSource>& sources)
+{
+    size_t  vertexCount = 0, indexCount = 0;
+    GLenum  indexType = GL_UNSIGNED_SHORT;
+    for (const MeshSource& source : sources)
+    {
+        vertexCount += source.vertexCount;
+        indexCount += source.indexCount;
+        if (Mesh::ChooseIndexType(source.vertexCount) == GL_UNSIGNED_INT)
+            indexType = GL_UNSIGNED_INT;
+    }
+    return (Create(vertexCount, indexCount, indexType));
+};
+
+// 컨텍스트가 이미 내려간 뒤라면 드라이버가 함께 정리한다.
+ModelBuffer::~ModelBuffer()
+{
+    if (glfwGetCurrentContext())
+    {
+        if (this->VAO)
+            glDeleteVertexArrays(1, &this->VAO);
+        if (this->VBO)
+            glDeleteBuffers(1, &this->VBO);
+        if (this->EBO)
+            glDeleteBuffers(1, &this->EBO);
+        if (this->depthVAO)
+            glDeleteVertexArrays(1, &this->depthVAO);
+        if (this->positionVBO)
+            glDeleteBuffers(1, &this->positionVBO);
+    }
+    GpuMemory::Get().Release(GpuMemory::BUFFER, this->VBO);
+    GpuMemory::Get().Release(GpuMemory::BUFFER, this->EBO);
+    GpuMemory::Get().Release(GpuMemory::BUFFER, this->positionVBO);
+};
+
+// 전체 크기로 한 번만 할당하고 메쉬는 Append 로 채운다.
+void    ModelBuffer::init(size_t vertexCount, size_t indexCount, GLenum indexType)
+{
+    this->vertexCapacity = vertexCount;
+    this->indexCapacity = indexCount;
+    this->indexType = indexType;
+
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glGenBuffers(1, &this->EBO);
+
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(mVertex), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * getIndexSize(), nullptr, GL_STATIC_DRAW);
+    GpuMemory::Get().Track(GpuMemory::BUFFER, this->VBO, vertexCount * sizeof(mVertex), "ModelBuffer vertices");
+    GpuMemory::Get().Track(GpuMemory::BUFFER, this->EBO, indexCount * getIndexSize(), "ModelBuffer indices");
+    Mesh::SetupVertexAttributes();
+
+    glGenVertexArrays(1, &this->depthVAO);
+    glGenBuffers(1, &this->positionVBO);
+    glBindVertexArray(this->depthVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->positionVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec3), nullptr, GL_STATIC_DRAW);
+    GpuMemory::Get().Track(GpuMemory::BUFFER, this->positionVBO, vertexCount * sizeof(glm::vec3), "ModelBuffer positions");
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+    Mesh::SetupPositionAttribute();
+    glBindVertexArray(0);
+};
+
+// 인덱스 형식이 버퍼와 다르면 여기서 바꿔서 올린다. (16 비트는 메쉬마다 정점 65536 개 이하일 때만 고른다)
+MeshRange   ModelBuffer::Append(const mVertex* vertices, size_t vertexCount, const void* indices, size_t indexCount,
+                                GLenum sourceIndexType)
+{
+    if (this->vertexCount + vertexCount > this->vertexCapacity || this->indexCount + indexCount > this->indexCapacity)
+        throw std::string("Error: Model buffer overflow");
+
+    MeshRange   range;
+    range.baseVertex = static_cast<GLint>(this->vertexCount);
+    range.firstIndex = static_cast<uint32_t>(this->indexCount);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, this->vertexCount * sizeof(mVertex), vertexCount * sizeof(mVertex), vertices);
+    std::vector<glm::vec3>  positions = Mesh::ExtractPositions(vertices, vertexCount);
+    glBindBuffer(GL_ARRAY_BUFFER, this->positionVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, this->vertexCount * sizeof(glm::vec3), vertexCount * sizeof(glm::vec3),
+                    positions.data());
+
+    std::vector<GLushort>   shortIndices;
+    std::vector<GLuint>     longIndices;
+    const void*             data = indices;
+    if (sourceIndexType != this->indexType && this->indexType == GL_UNSIGNED_SHORT)
+    {
+        const GLuint*   source = static_cast<const GLuint*>(indices);
+        shortIndices.assign(source, source + indexCount);
+        data = shortIndices.data();
+    }
+    else if (sourceIndexType != this->indexType)
+    {
+        const GLushort* source = static_cast<const GLushort*>(indices);
+        longIndices.assign(source, source + indexCount);
+        data = longIndices.data();
+    }
+    // EBO 는 VAO 상태라서 VAO 를 바인드한 채로 갱신한다.
+    glBindVertexArray(this->VAO);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, this->indexCount * getIndexSize(), indexCount * getIndexSize(), data);
+    glBindVertexArray(0);
+
+    this->vertexCount += vertexCount;
+    this->indexCount += indexCount;
+    return (range);
+};
+
+#endif
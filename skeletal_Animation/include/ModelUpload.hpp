@@ -0,0 +1,87 @@
+#ifndef MODELUPLOAD_HPP
+#define MODELUPLOAD_HPP
+
+#include "Common.hpp"
+#include "Mesh.hpp"
+#include "MeshCache.hpp"
+#include "ModelBuffer.hpp"
+#include "GlbFile.hpp"
+#include "UploadBudget.hpp"
+
+// CPU 쪽 준비(파싱, 변환, 최적화)가 끝나고 GL 업로드를 기다리는 모델 데이터.
+// sources 는 meshData 나 cache 의 맵핑을 가리키므로 업로드가 끝날 때까지 함께 잡아 둔다.
+// glb 는 GLB 에 내장된 텍스처를 디코딩하는 동안 맵핑을 유지한다.
+struct PendingModel
+{
+    std::unique_ptr<MeshCache>  cache;
+    std::shared_ptr<GlbFile>    glb;
+    std::vector<MeshData>       meshData;
+    std::vector<MeshSource>     sources;
+    std::vector<MeshInstance>   instances;
+    bool                        texturesUploaded { false };
+    size_t                      nextMesh { 0 };
+};
+
+// 비동기 로딩 중인 모델 자리에 대신 그리는 단위 큐브. 모든 모델이 하나를 같이 쓴다.
+class ModelPlaceholder
+{
+public:
+    static void Draw(Program* program, GLsizei instanceCount = 1);
+private:
+    ModelPlaceholder() {};
+    ~ModelPlaceholder() {};
+
+    static Mesh&    Get(void);
+};
+
+Mesh&   ModelPlaceholder::Get(void)
+{
+    static std::unique_ptr<Mesh>    placeholder;
+    if (placeholder)
+        return (*placeholder);
+
+    const glm::vec3 normals[6] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+                                    glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+    std::vector<mVertex>    vertices;
+    std::vector<GLuint>     indices;
+    for (const glm::vec3& normal : normals)
+    {
+        glm::vec3   u = glm::vec3(normal.y, normal.z, normal.x);
+        glm::vec3   v = glm::cross(normal, u);
+        GLuint      base = static_cast<GLuint>(vertices.size());
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            glm::vec2   uv((corner == 1 || corner == 2) ? 1.0f : 0.0f, corner >= 2 ? 1.0f : 0.0f);
+            mVertex     vertex;
+            vertex.position = (normal + (uv.x * 2.0f - 1.0f) * u + (uv.y * 2.0f - 1.0f) * v) * 0.5f;
+            vertex.normal = normal;
+            vertex.texCoords = uv;
+            vertex.tangent = glm::vec4(u, 1.0f);
+            for (int j = 0; j < MAX_BONE_INFLUENCE; ++j)
+            {
+                vertex.boneIDs[j] = -1;
+                vertex.weights[j] = 0.0f;
+            }
+            vertices.push_back(vertex);
+        }
+        indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+    }
+    placeholder = std::unique_ptr<Mesh>(new Mesh(std::move(vertices), std::move(indices), std::vector<mTexture>()));
+    return (*placeholder);
+};
+
+void    ModelPlaceholder::Draw(Program* program, GLsizei instanceCount)
+{
+    // 노드 인스턴스 attribute 를 읽는 셰이더도 큐브를 제자리에 그리도록 단위 행렬을 넣어 둔다.
+    const glm::mat4 identity(1.0f);
+    for (GLuint i = 0; i < 4; ++i)
+        glVertexAttrib4fv(Mesh::INSTANCE_ATTRIB + i, glm::value_ptr(identity[i]));
+    // 큐브는 기본 재질만 쓰지만 샘플러 유닛은 모델과 똑같이 고정해야 한다.
+    Mesh::BeginMaterials(program);
+    if (instanceCount == 1)
+        Get().Draw();
+    else
+        Get().DrawInstanced(instanceCount);
+};
+
+#endif
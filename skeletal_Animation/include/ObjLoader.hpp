@@ -0,0 +1,468 @@
+#ifndef OBJLOADER_HPP
+#define OBJLOADER_HPP
+
+#include "Common.hpp"
+#include "Mesh.hpp"
+#include "MappedFile.hpp"
+#include "TangentSpace.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+// Assimp 를 거치지 않는 OBJ / MTL 로더.
+// aiProcess_Triangulate | aiProcess_FlipUVs 로 읽은 결과와 같은 정점을 만들고, 탄젠트는 TangentSpace 로 채운다.
+// 재질 하나가 메쉬 하나가 되고, 텍스처는 경로와 종류만 채워서 돌려준다. (id 는 0)
+class ObjLoader
+{
+public:
+    static bool                     CanLoad(const std::string& path);
+    static std::vector<MeshData>    Load(const std::string& path);
+private:
+    // 파일을 나누는 단위. 조각 경계는 다음 줄 시작으로 맞춘다.
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    // 면의 꼭짓점 하나. 0 부터 세는 v / vt / vn 번호, 없으면 -1
+    // relative 는 음수 인덱스라서 조각 안에서의 번호로 적어 둔 성분 (bit 0 = v, 1 = vt, 2 = vn)
+    struct Corner
+    {
+        int32_t v, t, n;
+        uint8_t relative;
+    };
+    struct MaterialSwitch
+    {
+        size_t      face;
+        std::string name;
+    };
+    struct Chunk
+    {
+        std::vector<glm::vec3>      positions;
+        std::vector<glm::vec2>      texCoords;
+        std::vector<glm::vec3>      normals;
+        std::vector<Corner>         corners;
+        // 면 i 의 꼭짓점은 corners[faceStarts[i]] 부터 faceStarts[i + 1] 전까지
+        std::vector<uint32_t>       faceStarts;
+        std::vector<MaterialSwitch> materials;
+        std::vector<std::string>    libraries;
+    };
+    // 한 재질에 속하는 면 구간
+    struct FaceRange
+    {
+        size_t  chunk;
+        size_t  begin, end;
+    };
+
+    static void         parseChunk(const char* begin, const char* end, Chunk& chunk);
+    static const char*  parseCorner(const char* p, const char* end, const Chunk& chunk, Corner& corner);
+    static const char*  parseFloat(const char* p, const char* end, float& value);
+    static const char*  parseIndex(const char* p, const char* end, int32_t count, int32_t& index, bool& relative);
+    static std::unordered_map<std::string, std::vector<mTexture>>   loadMaterials(const std::filesystem::path& directory,
+                                                                                const std::vector<std::string>& libraries);
+    static void         buildMesh(const std::vector<Chunk>& chunks, const std::vector<FaceRange>& ranges,
+                                const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& texCoords,
+                                const std::vector<glm::vec3>& normals, MeshData& data);
+};
+
+bool    ObjLoader::CanLoad(const std::string& path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (std::tolower(c)); });
+    return (extension == ".obj");
+};
+
+std::vector<MeshData>   ObjLoader::Load(const std::string& path)
+{
+    std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+    if (!file)
+        throw std::string("Error: Failed to open OBJ file: " + path);
+    const char* data = reinterpret_cast<const char*>(file->Data());
+    const char* fileEnd = data + file->Size();
+
+    // 줄 경계에서 자른 조각을 작업자 스레드마다 따로 읽는다.
+    std::vector<std::pair<const char*, const char*>>    bounds;
+    for (const char* begin = data; begin < fileEnd; )
+    {
+        const char* end = begin + std::min(CHUNK_SIZE, static_cast<size_t>(fileEnd - begin));
+        end = std::find(end, fileEnd, '\n');
+        if (end != fileEnd)
+            ++end;
+        bounds.emplace_back(begin, end);
+        begin = end;
+    }
+    std::vector<Chunk>  chunks(bounds.size());
+    ThreadPool::Get().ParallelFor(chunks.size(), 1, [&bounds, &chunks](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            parseChunk(bounds[i].first, bounds[i].second, chunks[i]);
+    });
+
+    // 앞 조각들의 v / vt / vn 개수만큼 밀어서 조각 안의 번호를 파일 전체 번호로 바꾼다.
+    std::vector<glm::vec3>  positions, normals;
+    std::vector<glm::vec2>  texCoords;
+    std::vector<glm::ivec3> offsets(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        offsets[i] = glm::ivec3(positions.size(), texCoords.size(), normals.size());
+        positions.insert(positions.end(), chunks[i].positions.begin(), chunks[i].positions.end());
+        texCoords.insert(texCoords.end(), chunks[i].texCoords.begin(), chunks[i].texCoords.end());
+        normals.insert(normals.end(), chunks[i].normals.begin(), chunks[i].normals.end());
+    }
+    ThreadPool::Get().ParallelFor(chunks.size(), 1, [&chunks, &offsets](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            for (Corner& corner : chunks[i].corners)
+            {
+                if (corner.relative & 1)
+                    corner.v += offsets[i].x;
+                if (corner.relative & 2)
+                    corner.t += offsets[i].y;
+                if (corner.relative & 4)
+                    corner.n += offsets[i].z;
+            }
+    });
+
+    // usemtl 이 바뀌는 지점으로 면을 재질별 구간으로 나눈다. usemtl 전의 면은 이름 없는 재질로 모은다.
+    std::vector<std::string>                    materialNames;
+    std::unordered_map<std::string, size_t>     materialSlots;
+    std::vector<std::vector<FaceRange>>         materialRanges;
+    std::vector<std::string>                    libraries;
+    std::string                                 current;
+    auto    addRange = [&](size_t chunk, size_t begin, size_t end)
+    {
+        if (begin == end)
+            return ;
+        auto    slot = materialSlots.find(current);
+        if (slot == materialSlots.end())
+        {
+            slot = materialSlots.emplace(current, materialNames.size()).first;
+            materialNames.push_back(current);
+            materialRanges.emplace_back();
+        }
+        materialRanges[slot->second].push_back(FaceRange { chunk, begin, end });
+    };
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        size_t  faceCount = chunks[i].faceStarts.empty() ? 0 : chunks[i].faceStarts.size() - 1;
+        size_t  first = 0;
+        for (const MaterialSwitch& material : chunks[i].materials)
+        {
+            addRange(i, first, material.face);
+            first = material.face;
+            current = material.name;
+        }
+        addRange(i, first, faceCount);
+        libraries.insert(libraries.end(), chunks[i].libraries.begin(), chunks[i].libraries.end());
+    }
+
+    std::vector<MeshData>   meshData(materialRanges.size());
+    ThreadPool::Get().ParallelFor(meshData.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            buildMesh(chunks, materialRanges[i], positions, texCoords, normals, meshData[i]);
+    });
+
+    std::unordered_map<std::string, std::vector<mTexture>>  materials =
+        loadMaterials(std::filesystem::path(path).parent_path(), libraries);
+    for (size_t i = 0; i < meshData.size(); ++i)
+    {
+        auto    material = materials.find(materialNames[i]);
+        if (material != materials.end())
+            meshData[i].textures = material->second;
+    }
+    return (meshData);
+};
+
+// 조각 하나를 줄 단위로 읽는다. v / vt / vn / f / usemtl / mtllib 외의 줄은 건너뛴다.
+void    ObjLoader::parseChunk(const char* begin, const char* end, Chunk& chunk)
+{
+    const char* p = begin;
+    chunk.faceStarts.push_back(0);
+    while (p < end)
+    {
+        const char* lineEnd = std::find(p, end, '\n');
+        while (p < lineEnd && (*p == ' ' || *p == '\t'))
+            ++p;
+        if (lineEnd - p >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            glm::vec3   position;
+            p = parseFloat(p + 2, lineEnd, position.x);
+            p = parseFloat(p, lineEnd, position.y);
+            parseFloat(p, lineEnd, position.z);
+            chunk.positions.push_back(position);
+        }
+        else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            glm::vec2   texCoord;
+            p = parseFloat(p + 3, lineEnd, texCoord.x);
+            parseFloat(p, lineEnd, texCoord.y);
+            chunk.texCoords.push_back(texCoord);
+        }
+        else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            glm::vec3   normal;
+            p = parseFloat(p + 3, lineEnd, normal.x);
+            p = parseFloat(p, lineEnd, normal.y);
+            parseFloat(p, lineEnd, normal.z);
+            chunk.normals.push_back(normal);
+        }
+        else if (lineEnd - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            size_t  first = chunk.corners.size();
+            Corner  corner;
+            for (p += 2; p < lineEnd; )
+            {
+                const char* next = parseCorner(p, lineEnd, chunk, corner);
+                if (next == p)
+                    break ;
+                chunk.corners.push_back(corner);
+                p = next;
+            }
+            // 삼각형이 안 되는 면 (선, 점) 은 Triangulate 후 Assimp 메쉬에서도 삼각형으로 남지 않으므로 버린다.
+            if (chunk.corners.size() - first < 3)
+                chunk.corners.resize(first);
+            else
+                chunk.faceStarts.push_back(static_cast<uint32_t>(chunk.corners.size()));
+        }
+        else if (lineEnd - p >= 7 && (std::strncmp(p, "usemtl ", 7) == 0 || std::strncmp(p, "mtllib ", 7) == 0))
+        {
+            const char* nameEnd = lineEnd;
+            while (nameEnd > p + 7 && std::isspace(static_cast<unsigned char>(nameEnd[-1])))
+                --nameEnd;
+            const char* name = p + 7;
+            while (name < nameEnd && (*name == ' ' || *name == '\t'))
+                ++name;
+            if (p[0] == 'u')
+                chunk.materials.push_back(MaterialSwitch { chunk.faceStarts.size() - 1, std::string(name, nameEnd) });
+            else
+                chunk.libraries.emplace_back(name, nameEnd);
+        }
+        p = lineEnd < end ? lineEnd + 1 : end;
+    }
+};
+
+// "v", "v/t", "v//n", "v/t/n" 중 하나. 읽지 못하면 p 를 그대로 돌려준다.
+const char* ObjLoader::parseCorner(const char* p, const char* end, const Chunk& chunk, Corner& corner)
+{
+    bool    relative = false;
+    corner.t = -1;
+    corner.n = -1;
+    corner.relative = 0;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        ++p;
+    const char* start = p;
+    p = parseIndex(p, end, static_cast<int32_t>(chunk.positions.size()), corner.v, relative);
+    if (p == start)
+        return (start);
+    corner.relative |= relative ? 1 : 0;
+    if (p < end && *p == '/')
+    {
+        ++p;
+        if (p < end && *p != '/')
+        {
+            p = parseIndex(p, end, static_cast<int32_t>(chunk.texCoords.size()), corner.t, relative);
+            corner.relative |= relative ? 2 : 0;
+        }
+        if (p < end && *p == '/')
+        {
+            p = parseIndex(p + 1, end, static_cast<int32_t>(chunk.normals.size()), corner.n, relative);
+            corner.relative |= relative ? 4 : 0;
+        }
+    }
+    return (p);
+};
+
+// 양수는 1 부터 세는 파일 전체 번호, 음수는 지금까지 나온 개수에서 거꾸로 센 번호다.
+// 음수는 조각 안에서의 번호 (count + index) 로 적어 두고 relative 로 표시한다.
+const char* ObjLoader::parseIndex(const char* p, const char* end, int32_t count, int32_t& index, bool& relative)
+{
+    bool    negative = false;
+    int64_t value = 0;
+    relative = false;
+    if (p < end && *p == '-')
+    {
+        negative = true;
+        ++p;
+    }
+    const char* digits = p;
+    while (p < end && *p >= '0' && *p <= '9')
+        value = value * 10 + (*p++ - '0');
+    if (p == digits)
+        return (negative ? p - 1 : p);
+    relative = negative;
+    index = negative ? count - static_cast<int32_t>(value) : static_cast<int32_t>(value) - 1;
+    return (p);
+};
+
+// 로케일을 타지 않는 실수 파서. 유효 숫자 19 자리까지 정수로 모은 뒤 10 의 거듭제곱을 한 번만 곱한다.
+const char* ObjLoader::parseFloat(const char* p, const char* end, float& value)
+{
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    bool        negative = false;
+    uint64_t    mantissa = 0;
+    int         exponent = 0, digits = 0;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa ? 1 : 0;
+        }
+        else
+            ++exponent;
+    }
+    if (p < end && *p == '.')
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa ? 1 : 0;
+                --exponent;
+            }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        bool    negativeExponent = false;
+        int     e = 0;
+        ++p;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExponent = *p++ == '-';
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+            e = std::min(e * 10 + (*p - '0'), 1000);
+        exponent += negativeExponent ? -e : e;
+    }
+    double  result = static_cast<double>(mantissa);
+    if (exponent < 0)
+        result = -exponent <= 22 ? result / powers[-exponent] : result * std::pow(10.0, exponent);
+    else if (exponent > 0)
+        result = exponent <= 22 ? result * powers[exponent] : result * std::pow(10.0, exponent);
+    value = static_cast<float>(negative ? -result : result);
+    return (p);
+};
+
+// Model::loadMeshTextures 와 같은 순서 (diffuse, specular, normal) 로 채운다.
+// Assimp 의 OBJ importer 처럼 map_Bump / bump 는 HEIGHT 로 보고 texture_normal 로 쓴다.
+std::unordered_map<std::string, std::vector<mTexture>>  ObjLoader::loadMaterials(const std::filesystem::path& directory,
+                                                                                const std::vector<std::string>& libraries)
+{
+    std::unordered_map<std::string, std::vector<mTexture>>  materials;
+    for (const std::string& library : libraries)
+    {
+        std::ifstream   file(directory / library);
+        if (!file.is_open())
+        {
+            std::cout << "Material library not found: " << library << std::endl;
+            continue ;
+        }
+        std::unordered_map<std::string, std::array<std::string, 3>> maps;
+        std::string     line, current;
+        while (std::getline(file, line))
+        {
+            std::istringstream  stream(line);
+            std::string         keyword, token, last;
+            stream >> keyword;
+            if (keyword == "newmtl")
+            {
+                std::getline(stream >> std::ws, current);
+                while (!current.empty() && std::isspace(static_cast<unsigned char>(current.back())))
+                    current.pop_back();
+                maps[current];
+                continue ;
+            }
+            int slot = keyword == "map_Kd" ? 0 : keyword == "map_Ks" ? 1
+                    : (keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump") ? 2 : -1;
+            if (slot < 0 || current.empty())
+                continue ;
+            // "-bm 1.0 normal.png" 같은 옵션 뒤의 마지막 토큰이 파일 이름이다.
+            while (stream >> token)
+                last = token;
+            if (!last.empty())
+                maps[current][slot] = last;
+        }
+        static const char*  typeNames[3] = { "texture_diffuse", "texture_specular", "texture_normal" };
+        for (const auto& material : maps)
+        {
+            std::vector<mTexture>&  textures = materials[material.first];
+            for (int i = 0; i < 3; ++i)
+                if (!material.second[i].empty())
+                    textures.push_back(mTexture { 0, typeNames[i], material.second[i], nullptr, nullptr, -1 });
+        }
+    }
+    return (materials);
+};
+
+// 면을 부채꼴로 삼각형으로 나누고, 같은 (v, vt, vn) 조합은 정점 하나로 합친다.
+void    ObjLoader::buildMesh(const std::vector<Chunk>& chunks, const std::vector<FaceRange>& ranges,
+                            const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& texCoords,
+                            const std::vector<glm::vec3>& normals, MeshData& data)
+{
+    struct CornerHash
+    {
+        // 내보내기 도구는 v 와 vt 번호를 같게 쓰는 경우가 많아서 성분을 단순 XOR 하면 충돌이 잦다.
+        size_t  operator()(const glm::ivec3& key) const
+        {
+            uint64_t    hash = static_cast<uint32_t>(key.x);
+            hash = (hash ^ (static_cast<uint64_t>(static_cast<uint32_t>(key.y)) << 32)) * 0x9E3779B97F4A7C15ull;
+            hash = (hash ^ static_cast<uint32_t>(key.z)) * 0xC2B2AE3D27D4EB4Full;
+            return (static_cast<size_t>(hash ^ (hash >> 29)));
+        };
+    };
+    size_t  cornerCount = 0;
+    for (const FaceRange& range : ranges)
+        cornerCount += chunks[range.chunk].faceStarts[range.end] - chunks[range.chunk].faceStarts[range.begin];
+    // 꼭짓점 수가 정점 수의 상한이다. 중간에 rehash 하지 않도록 미리 잡는다.
+    std::unordered_map<glm::ivec3, GLuint, CornerHash>  slots;
+    slots.reserve(cornerCount);
+    bool    hasTexCoords = false;
+    auto    addCorner = [&](const Corner& corner) -> GLuint
+    {
+        glm::ivec3  key(corner.v, corner.t, corner.n);
+        auto        slot = slots.find(key);
+        if (slot != slots.end())
+            return (slot->second);
+        if (corner.v < 0 || corner.v >= static_cast<int32_t>(positions.size())
+            || corner.t >= static_cast<int32_t>(texCoords.size()) || corner.n >= static_cast<int32_t>(normals.size()))
+            throw std::string("Error: OBJ face index out of range");
+        mVertex vertex;
+        vertex.position = positions[corner.v];
+        vertex.normal = corner.n >= 0 ? normals[corner.n] : glm::vec3(0.0f);
+        // aiProcess_FlipUVs
+        vertex.texCoords = corner.t >= 0 ? glm::vec2(texCoords[corner.t].x, 1.0f - texCoords[corner.t].y) : glm::vec2(0.0f);
+        vertex.tangent = glm::vec4(0.0f);
+        for (unsigned int j = 0; j < MAX_BONE_INFLUENCE; ++j)
+        {
+            vertex.boneIDs[j] = -1;
+            vertex.weights[j] = 0.0f;
+        }
+        hasTexCoords |= corner.t >= 0;
+        GLuint  index = static_cast<GLuint>(data.vertices.size());
+        data.vertices.push_back(vertex);
+        slots.emplace(key, index);
+        return (index);
+    };
+    for (const FaceRange& range : ranges)
+    {
+        const Chunk&    chunk = chunks[range.chunk];
+        for (size_t face = range.begin; face < range.end; ++face)
+        {
+            uint32_t    first = chunk.faceStarts[face], last = chunk.faceStarts[face + 1];
+            GLuint      origin = addCorner(chunk.corners[first]);
+            GLuint      previous = addCorner(chunk.corners[first + 1]);
+            for (uint32_t i = first + 2; i < last; ++i)
+            {
+                GLuint  index = addCorner(chunk.corners[i]);
+                data.indices.insert(data.indices.end(), { origin, previous, index });
+                previous = index;
+            }
+        }
+    }
+    if (hasTexCoords)
+        TangentSpace::GenerateTangents(data);
+};
+
+#endif
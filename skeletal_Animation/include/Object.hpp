@@ -2,14 +2,15 @@
 #define OBJECT_HPP
 
 #include "Common.hpp"
+#include "GpuMemory.hpp"
+#include "TangentGenerator.hpp"
 
 struct Vertex
 {
     glm::vec3   position;
     glm::vec3   normal;
     glm::vec2   texture_coord;
-    glm::vec3   tangent;
-    glm::vec3   bitangent;
+    glm::vec4   tangent;
 };
 
 struct Screen
@@ -19,8 +20,6 @@ struct Screen
     glm::vec2   texture_coord;
 };
 
-void        CalTangentSpace(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
-
 class Object
 {
 public:
@@ -30,9 +29,12 @@ public:
 
     ~Object();
     void    Draw(void);
+    void    DrawDepth(void);
 private:
     GLuint  VAO {0};
     GLuint  VBO {0}, EBO {0};
+    // 깊이 패스는 위치만 담은 스트림을 읽는다. (Vertex 48 바이트 중 12 바이트)
+    GLuint  depthVAO {0}, positionVBO {0};
     size_t  indexSize;
 
     Object() {};
@@ -40,6 +42,7 @@ private:
 	void	init(std::vector<Screen>& vertices, std::vector<GLuint>& indices);
     void    BindBuffer(GLenum type, GLuint name, size_t dataSize, const void* data);
     void    SetAttrib(GLuint idx, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void * pointer);
+    static void GenerateTangents(std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
 };
 
 Object::~Object()
@@ -50,6 +53,13 @@ Object::~Object()
         glDeleteBuffers(1, &VBO);
     if (EBO)
         glDeleteBuffers(1, &EBO);
+    if (depthVAO)
+        glDeleteVertexArrays(1, &depthVAO);
+    if (positionVBO)
+        glDeleteBuffers(1, &positionVBO);
+    GpuMemory::Get().Release(GpuMemory::BUFFER, VBO);
+    GpuMemory::Get().Release(GpuMemory::BUFFER, EBO);
+    GpuMemory::Get().Release(GpuMemory::BUFFER, positionVBO);
 }
 
 std::unique_ptr<Object>	Object::CreatePlane(void)
@@ -65,7 +75,7 @@ std::unique_ptr<Object>	Object::CreatePlane(void)
         1, 2, 3
     };
 	std::unique_ptr<Object>	plane = std::unique_ptr<Object>(new Object());
-    CalTangentSpace(vertices, indices);
+    GenerateTangents(vertices, indices);
     plane->init(vertices, indices);
 	return (std::move(plane));
 };
@@ -113,7 +123,7 @@ std::unique_ptr<Object>	Object::CreateBox(void)
     };
 
 	std::unique_ptr<Object>	plane = std::unique_ptr<Object>(new Object());
-    CalTangentSpace(vertices, indices);
+    GenerateTangents(vertices, indices);
     plane->init(vertices, indices);
 	return (std::move(plane));
 };
@@ -151,9 +161,20 @@ void	Object::init(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
 	SetAttrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
 	SetAttrib(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
 	SetAttrib(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texture_coord));
-	SetAttrib(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
+	SetAttrib(3, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
 
     BindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO, sizeof(GLuint) * indices.size(), indices.data());
+
+    std::vector<glm::vec3>  positions(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        positions[i] = vertices[i].position;
+	glGenVertexArrays(1, &this->depthVAO);
+    glGenBuffers(1, &this->positionVBO);
+
+    glBindVertexArray(this->depthVAO);
+    BindBuffer(GL_ARRAY_BUFFER, this->positionVBO, sizeof(glm::vec3) * positions.size(), positions.data());
+	SetAttrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
     
     glBindVertexArray(0);
 };
@@ -183,6 +204,7 @@ void    Object::BindBuffer(GLenum type, GLuint id, size_t dataSize, const void*
 {
     glBindBuffer(type, id);
     glBufferData(type, dataSize, data, GL_STATIC_DRAW);
+    GpuMemory::Get().Track(GpuMemory::BUFFER, id, dataSize, "Object");
 };
 
 void    Object::SetAttrib(GLuint idx, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void * pointer)
@@ -197,38 +219,18 @@ void    Object::Draw(void)
     glDrawElements(GL_TRIANGLES, this->indexSize, GL_UNSIGNED_INT, nullptr);
 };
 
-glm::vec3   ComputeTangentSpace(std::vector<Vertex>& vertices, GLuint i, GLuint j, GLuint k)
+// 화면 사각형은 위치 스트림이 없으므로 평소 VAO 로 그린다.
+void    Object::DrawDepth(void)
 {
-    glm::vec3   edge1 = vertices[j].position - vertices[i].position;
-    glm::vec3   edge2 = vertices[k].position - vertices[i].position;
-    glm::vec2   uv1 = vertices[j].texture_coord - vertices[i].texture_coord;
-    glm::vec2   uv2 = vertices[k].texture_coord - vertices[i].texture_coord;
-    float       det = uv1.x * uv2.y - uv1.y * uv2.x;
-
-    if (det != 0.0f)
-    {
-        float   invDet = 1.0f / det;
-        return (invDet * (uv2.y * edge1 - uv1.y * edge2));
-    }
-    else
-        return (glm::vec3(0.0f, 0.0f, 0.0f));
+    glBindVertexArray(this->depthVAO ? this->depthVAO : this->VAO);
+    glDrawElements(GL_TRIANGLES, this->indexSize, GL_UNSIGNED_INT, nullptr);
 };
 
-
-void    CalTangentSpace(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+void    Object::GenerateTangents(std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
 {
-    std::vector<glm::vec3>  tangents;
-    tangents.resize(vertices.size());
-    memset(tangents.data(), 0, tangents.size() * sizeof(glm::vec3));
-    for (size_t i = 0; i < indices.size(); i += 3)
-    {
-        tangents[indices[i]] += ComputeTangentSpace(vertices, indices[i], indices[i + 1], indices[i + 2]);
-        tangents[indices[i + 1]] += ComputeTangentSpace(vertices, indices[i + 1], indices[i + 2], indices[i]);
-        tangents[indices[i + 2]] += ComputeTangentSpace(vertices, indices[i + 2], indices[i], indices[i + 1]);
-    }
-
-    for (size_t i = 0; i < vertices.size(); ++i)
-        vertices[i].tangent = glm::normalize(tangents[i]);
+    TangentLayout   layout { sizeof(Vertex), offsetof(Vertex, position), offsetof(Vertex, normal),
+                            offsetof(Vertex, texture_coord), offsetof(Vertex, tangent) };
+    TangentGenerator::Generate(vertices.data(), vertices.size(), layout, indices.data(), indices.size());
 };
 
 #endif
\ No newline at end of file
@@ -11,6 +11,7 @@ class Program
 public:
     static std::unique_ptr<Program> Create(const std::filesystem::path& vertexShaderPath
                                         , const std::filesystem::path& fragmentShaderPath);
+    static std::unique_ptr<Program> CreateCompute(const std::filesystem::path& computeShaderPath);
 
     void    Rendering(void);
 
@@ -40,6 +41,7 @@ private:
     Program() {};
     void    init(const std::filesystem::path& vertexShaderPath
                 , const std::filesystem::path& fragmentShaderPath);
+    void    init(const std::filesystem::path& computeShaderPath);
     void    checkError(void);
 };
 
@@ -54,6 +56,13 @@ std::unique_ptr<Program> Program::Create(const std::filesystem::path& vertexShad
     return (std::move(program));
 };
 
+std::unique_ptr<Program> Program::CreateCompute(const std::filesystem::path& computeShaderPath)
+{
+    std::unique_ptr<Program>    program = std::unique_ptr<Program>(new Program());
+    program->init(computeShaderPath);
+    return (std::move(program));
+};
+
 void    Program::init(const std::filesystem::path& vertexShaderPath
                     , const std::filesystem::path& fragmentShaderPath)
 {
@@ -69,6 +78,17 @@ void    Program::init(const std::filesystem::path& vertexShaderPath
     checkError();
 };
 
+void    Program::init(const std::filesystem::path& computeShaderPath)
+{
+    std::unique_ptr<Shader> computeShader = Shader::Create(computeShaderPath, GL_COMPUTE_SHADER);
+
+    this->id = glCreateProgram();
+    glAttachShader(this->id, computeShader->Get());
+    glLinkProgram(this->id);
+
+    checkError();
+};
+
 void    Program::checkError(void)
 {
     int success;
@@ -0,0 +1,195 @@
+#ifndef TANGENTGENERATOR_HPP
+#define TANGENTGENERATOR_HPP
+
+#include "Common.hpp"
+#include "ThreadPool.hpp"
+#include <cmath>
+#include <cstring>
+
+// 정점 구조 안에서 위치 / 노멀 / UV (vec2) 와 결과 탄젠트 (vec4) 의 위치. Vertex, mVertex 모두 offsetof 로 넘긴다.
+struct TangentLayout
+{
+    size_t  stride;
+    size_t  position, normal, texCoord, tangent;
+};
+
+// MikkTSpace 와 같은 규칙으로 탄젠트를 만든다. (면 탄젠트를 정점 노멀 평면에 투영, 모서리 각도 가중, w 는 UV 방향 부호)
+// 셰이더는 B = cross(N, T.xyz) * T.w 로 쓴다.
+// 삼각형 구간과 정점 구간을 나눠서 병렬로 돌리고, 정점마다 모서리 순서대로 더하므로 스레드 수와 관계없이 결과가 같다.
+// MikkTSpace 는 거울 UV 경계의 공유 정점을 쪼개지만 여기서는 인덱스를 바꾸지 않으므로 부호가 많은 쪽을 따른다.
+class TangentGenerator
+{
+public:
+    static void Generate(void* vertices, size_t vertexCount, const TangentLayout& layout,
+                        const GLuint* indices, size_t indexCount);
+private:
+    static constexpr size_t GRAIN = 16384;
+
+    // 면 하나의 UV 방향. 넓이가 0 인 면은 sign 이 0 이고 정점에 아무것도 더하지 않는다.
+    struct FaceBasis
+    {
+        glm::vec3   tangent;
+        float       sign;
+    };
+
+    static std::vector<uint32_t>    findSharedVertices(const unsigned char* base, size_t vertexCount,
+                                                    const TangentLayout& layout);
+    static glm::vec3                projectNormalized(const glm::vec3& vector, const glm::vec3& normal);
+};
+
+void    TangentGenerator::Generate(void* vertices, size_t vertexCount, const TangentLayout& layout,
+                                const GLuint* indices, size_t indexCount)
+{
+    unsigned char*  base = static_cast<unsigned char*>(vertices);
+    auto    position = [base, &layout](size_t i) -> const glm::vec3&
+    { return (*reinterpret_cast<const glm::vec3*>(base + i * layout.stride + layout.position)); };
+    auto    normal = [base, &layout](size_t i) -> const glm::vec3&
+    { return (*reinterpret_cast<const glm::vec3*>(base + i * layout.stride + layout.normal)); };
+    auto    texCoord = [base, &layout](size_t i) -> const glm::vec2&
+    { return (*reinterpret_cast<const glm::vec2*>(base + i * layout.stride + layout.texCoord)); };
+    size_t  faceCount = indexCount / 3;
+
+    // 1. 면마다 dP/du 방향과 UV 가 뒤집혔는지
+    std::vector<FaceBasis>  faces(faceCount);
+    ThreadPool::Get().ParallelFor(faceCount, GRAIN, [&](size_t begin, size_t end)
+    {
+        for (size_t f = begin; f < end; ++f)
+        {
+            const GLuint*   face = indices + f * 3;
+            if (face[0] >= vertexCount || face[1] >= vertexCount || face[2] >= vertexCount)
+                throw std::string("Error: Tangent space index out of range");
+            glm::vec3   edge1 = position(face[1]) - position(face[0]), edge2 = position(face[2]) - position(face[0]);
+            glm::vec2   delta1 = texCoord(face[1]) - texCoord(face[0]), delta2 = texCoord(face[2]) - texCoord(face[0]);
+            float       area = delta1.x * delta2.y - delta1.y * delta2.x;
+            glm::vec3   tangent = edge1 * delta2.y - edge2 * delta1.y;
+            float       length = glm::length(tangent);
+            FaceBasis&  basis = faces[f];
+            basis.sign = std::abs(area) > 1e-20f && length > 1e-20f ? (area > 0.0f ? 1.0f : -1.0f) : 0.0f;
+            basis.tangent = basis.sign != 0.0f ? tangent * (basis.sign / length) : glm::vec3(0.0f);
+        }
+    });
+
+    // 2. MikkTSpace 처럼 위치, 노멀, UV 가 모두 같은 정점은 하나로 보고 같이 더한다.
+    //    import 결과처럼 면마다 정점이 따로 있어도 매끄러운 탄젠트가 나온다. 대표는 가장 앞 번호라서 순서가 정해져 있다.
+    std::vector<uint32_t>   shared = findSharedVertices(base, vertexCount, layout);
+
+    // 3. 대표 정점마다 자기를 쓰는 모서리 목록. 모서리 번호 순서로 채우므로 더하는 순서가 항상 같다.
+    std::vector<uint32_t>   cornerStart(vertexCount + 1, 0);
+    std::vector<uint32_t>   corners(faceCount * 3);
+    for (size_t i = 0; i < faceCount * 3; ++i)
+        ++cornerStart[shared[indices[i]] + 1];
+    for (size_t i = 0; i < vertexCount; ++i)
+        cornerStart[i + 1] += cornerStart[i];
+    {
+        std::vector<uint32_t>   cursor(cornerStart.begin(), cornerStart.end() - 1);
+        for (size_t i = 0; i < faceCount * 3; ++i)
+            corners[cursor[shared[indices[i]]]++] = static_cast<uint32_t>(i);
+    }
+
+    // 4. 노멀 평면에 투영한 면 탄젠트를 모서리 각도로 가중해서 더한다. 대표 정점에만 쓰고 나머지는 5 에서 복사한다.
+    std::vector<glm::vec4>  results(vertexCount);
+    ThreadPool::Get().ParallelFor(vertexCount, GRAIN, [&](size_t begin, size_t end)
+    {
+        for (size_t v = begin; v < end; ++v)
+        {
+            if (shared[v] != v)
+                continue ;
+            glm::vec3   n = normal(v);
+            glm::vec3   tangent(0.0f);
+            float       handedness = 0.0f;
+            for (uint32_t c = cornerStart[v]; c < cornerStart[v + 1]; ++c)
+            {
+                const FaceBasis&    basis = faces[corners[c] / 3];
+                if (basis.sign == 0.0f)
+                    continue ;
+                const GLuint*   face = indices + corners[c] / 3 * 3;
+                uint32_t        corner = corners[c] % 3;
+                glm::vec3       toNext = projectNormalized(position(face[(corner + 1) % 3]) - position(v), n);
+                glm::vec3       toPrev = projectNormalized(position(face[(corner + 2) % 3]) - position(v), n);
+                float           angle = std::acos(std::max(-1.0f, std::min(1.0f, glm::dot(toNext, toPrev))));
+                tangent += angle * projectNormalized(basis.tangent, n);
+                handedness += angle * basis.sign;
+            }
+
+            float   length = glm::length(tangent);
+            if (length > 1e-20f)
+                results[v] = glm::vec4(tangent / length, handedness < 0.0f ? -1.0f : 1.0f);
+            else
+            {
+                // UV 가 없거나 모두 퇴화한 정점은 노멀에 수직인 아무 방향이나 준다. (셰이더의 normalize 가 NaN 이 되지 않게)
+                glm::vec3   axis = std::abs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                glm::vec3   fallback = projectNormalized(axis, n);
+                results[v] = glm::vec4(glm::length(fallback) > 0.0f ? fallback : axis, 1.0f);
+            }
+        }
+    });
+
+    // 5. 모든 정점에 자기 대표의 결과를 쓴다.
+    ThreadPool::Get().ParallelFor(vertexCount, GRAIN, [&](size_t begin, size_t end)
+    {
+        for (size_t v = begin; v < end; ++v)
+            std::memcpy(base + v * layout.stride + layout.tangent, &results[shared[v]], sizeof(glm::vec4));
+    });
+};
+
+// 키 해시는 병렬로 구하고, 표에 넣는 것만 정점 순서대로 한다. (MeshOptimizer::WeldVertices 와 같은 선형 탐사)
+std::vector<uint32_t>   TangentGenerator::findSharedVertices(const unsigned char* base, size_t vertexCount,
+                                                        const TangentLayout& layout)
+{
+    auto    readKey = [base, &layout](size_t i, uint32_t* key)
+    {
+        const unsigned char*    vertex = base + i * layout.stride;
+        std::memcpy(key, vertex + layout.position, sizeof(glm::vec3));
+        std::memcpy(key + 3, vertex + layout.normal, sizeof(glm::vec3));
+        std::memcpy(key + 6, vertex + layout.texCoord, sizeof(glm::vec2));
+    };
+    std::vector<uint64_t>   hashes(vertexCount);
+    ThreadPool::Get().ParallelFor(vertexCount, GRAIN, [&](size_t begin, size_t end)
+    {
+        uint32_t    key[8];
+        for (size_t i = begin; i < end; ++i)
+        {
+            readKey(i, key);
+            uint64_t    hash = 0;
+            for (uint32_t word : key)
+                hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+            hashes[i] = hash ^ (hash >> 29);
+        }
+    });
+
+    const uint32_t          empty = static_cast<uint32_t>(-1);
+    size_t                  tableSize = 16;
+    while (tableSize < vertexCount * 2)
+        tableSize *= 2;
+    std::vector<uint32_t>   table(tableSize, empty);
+    std::vector<uint32_t>   shared(vertexCount);
+    uint32_t                key[8], other[8];
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        readKey(i, key);
+        size_t  slot = hashes[i] & (tableSize - 1);
+        while (table[slot] != empty)
+        {
+            if (hashes[table[slot]] == hashes[i])
+            {
+                readKey(table[slot], other);
+                if (std::memcmp(key, other, sizeof(key)) == 0)
+                    break ;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (table[slot] == empty)
+            table[slot] = static_cast<uint32_t>(i);
+        shared[i] = table[slot];
+    }
+    return (shared);
+};
+
+glm::vec3   TangentGenerator::projectNormalized(const glm::vec3& vector, const glm::vec3& normal)
+{
+    glm::vec3   projected = vector - normal * glm::dot(normal, vector);
+    float       length = glm::length(projected);
+    return (length > 1e-20f ? projected / length : glm::vec3(0.0f));
+};
+
+#endif
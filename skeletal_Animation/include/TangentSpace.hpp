@@ -0,0 +1,69 @@
+#ifndef TANGENTSPACE_HPP
+#define TANGENTSPACE_HPP
+
+#include "Common.hpp"
+#include "Mesh.hpp"
+#include "TangentGenerator.hpp"
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+// Assimp 를 거치지 않는 로더(OBJ, GLB)와 import 변환이 aiProcess_GenSmoothNormals / aiProcess_CalcTangentSpace 대신 쓴다.
+class TangentSpace
+{
+public:
+    static void GenerateNormals(MeshData& data);
+    static void GenerateTangents(MeshData& data);
+};
+
+// GenSmoothNormals 처럼 위치가 같은 정점끼리 면 노멀(넓이 가중)을 모은다. UV 경계에서 나뉜 정점도 같은 노멀을 받는다.
+void    TangentSpace::GenerateNormals(MeshData& data)
+{
+    struct PositionHash
+    {
+        size_t  operator()(const glm::vec3& position) const
+        {
+            uint32_t    bits[3];
+            std::memcpy(bits, &position, sizeof(bits));
+            return (static_cast<size_t>(((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u))
+                    * 0x9E3779B97F4A7C15ull >> 16));
+        };
+    };
+    struct PositionEqual
+    {
+        bool    operator()(const glm::vec3& a, const glm::vec3& b) const
+        { return (a.x == b.x && a.y == b.y && a.z == b.z); };
+    };
+    std::vector<mVertex>&   vertices = data.vertices;
+    std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual>    slots;
+    std::vector<uint32_t>   slotOf(vertices.size());
+    slots.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        slotOf[i] = slots.emplace(vertices[i].position, static_cast<uint32_t>(slots.size())).first->second;
+
+    std::vector<glm::vec3>  normals(slots.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < data.indices.size(); i += 3)
+    {
+        const glm::vec3&    p0 = vertices[data.indices[i]].position;
+        glm::vec3           normal = glm::cross(vertices[data.indices[i + 1]].position - p0,
+                                                vertices[data.indices[i + 2]].position - p0);
+        for (int corner = 0; corner < 3; ++corner)
+            normals[slotOf[data.indices[i + corner]]] += normal;
+    }
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        float   length = glm::length(normals[slotOf[i]]);
+        vertices[i].normal = length > 1e-12f ? normals[slotOf[i]] / length : glm::vec3(0.0f);
+    }
+};
+
+// LOD 가 붙어 있으면 LOD0 만 본다. 같은 정점을 쓰는 거친 LOD 가 가중치에 섞이지 않게 한다.
+void    TangentSpace::GenerateTangents(MeshData& data)
+{
+    TangentLayout   layout { sizeof(mVertex), offsetof(mVertex, position), offsetof(mVertex, normal),
+                            offsetof(mVertex, texCoords), offsetof(mVertex, tangent) };
+    size_t          indexCount = data.lods.empty() ? data.indices.size() : data.lods[0].indexCount;
+    TangentGenerator::Generate(data.vertices.data(), data.vertices.size(), layout, data.indices.data(), indexCount);
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "Common.hpp"
 #include "Program.hpp"
+#include "TextureCache.hpp"
+#include "GpuMemory.hpp"
 
 class Texture
 {
@@ -10,9 +12,10 @@ public:
     static std::unique_ptr<Texture> Create(const float& width, const float& height,
                                         const unsigned int& format, GLenum type = GL_UNSIGNED_BYTE,
                                         GLenum TextureTarget = GL_TEXTURE_2D);
-    static std::unique_ptr<Texture> Load(const std::filesystem::path& filePath,
-                                    	std::string name, GLenum TextureTarget = GL_TEXTURE_2D);
+    static std::unique_ptr<Texture> Load(const std::filesystem::path& filePath, std::string name,
+                                        GLenum TextureTarget = GL_TEXTURE_2D, int role = TextureRole::COLOR);
 
+    ~Texture();
     const GLuint&       Get(void) const
     { return (this->id); };
     const std::string&  GetName(void) const
@@ -29,10 +32,11 @@ private:
     GLfloat     width, height;
     GLuint      format;
     GLenum      target, type;
+    std::shared_ptr<TextureHandle>  handle;
 
     Texture() {};
     void    init(GLenum type, GLenum TextureTarget);
-    void    LoadFile(const std::filesystem::path& filePath, std::string name);
+    void    LoadFile(const std::filesystem::path& filePath, std::string name, int role);
     void    SetWrap(GLuint wrapS, GLuint wrapT);
     void    SetFliter(GLuint filterMin, GLuint filterMag);
     void    SetTexImage(const float& width, const float& height,
@@ -50,16 +54,28 @@ std::unique_ptr<Texture>    Texture::Create(const float& width, const float& hei
 }
 
 std::unique_ptr<Texture>    Texture::Load(const std::filesystem::path& filePath, std::string name,
-                                        GLenum TextureTarget)
+                                        GLenum TextureTarget, int role)
 {
     std::unique_ptr<Texture>	texture = std::unique_ptr<Texture>(new Texture());
-    texture->init(GL_UNSIGNED_BYTE, TextureTarget);
-    texture->SetWrap(GL_REPEAT, GL_REPEAT);
-    texture->SetFliter(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
-    texture->LoadFile(filePath, name);
+    texture->type = GL_UNSIGNED_BYTE;
+    texture->target = TextureTarget;
+    texture->LoadFile(filePath, name, role);
+    // 동기 로딩이므로 돌아갈 때는 픽셀까지 올라가 있어야 한다.
+    TextureUploader::Get().Flush();
 	return (std::move(texture));
 };
 
+// 파일에서 읽은 텍스처는 캐시의 핸들이 지운다. 직접 만든 것 (프레임버퍼 첨부 등) 만 여기서 지운다.
+Texture::~Texture()
+{
+    if (this->handle || !this->id)
+        return ;
+    TextureUploader::Get().Cancel(this->id);
+    GpuMemory::Get().Release(GpuMemory::TEXTURE, this->id);
+    if (glfwGetCurrentContext())
+        glDeleteTextures(1, &this->id);
+};
+
 void	Texture::bind(unsigned int idx)
 {
 	glActiveTexture(GL_TEXTURE0 + idx);
@@ -74,18 +90,19 @@ void    Texture::init(GLenum type, GLenum TextureTarget)
 	glBindTexture(this->target, this->id);
 };
 
-void    Texture::LoadFile(const std::filesystem::path& filePath, std::string name)
+// 같은 파일을 같은 용도로 이미 올렸다면 그 텍스처를 같이 쓴다.
+// 용도에 따라 채널 수와 sized 형식이 정해진다. (albedo 는 sRGB, 노멀은 RG 두 채널, 마스크는 R 한 채널)
+void    Texture::LoadFile(const std::filesystem::path& filePath, std::string name, int role)
 {
-    stbi_set_flip_vertically_on_load(true);
     this->name = name;
-    int width, height, channel;
-    unsigned char*  data = stbi_load(filePath.string().c_str(), &width, &height, &channel, 4);
-    if (data == nullptr)
+    this->handle = TextureCache::Get().Load(filePath, true, 0, role);
+    if (!this->handle)
         throw std::string("Error: Failed to open image: ") + filePath.string();
 
-    SetTexImage(static_cast<float>(width), static_cast<float>(height), GL_RGBA, data);
-    glGenerateMipmap(this->target);
-    stbi_image_free(data);
+    this->id = this->handle->Get();
+    this->width = static_cast<GLfloat>(this->handle->GetWidth());
+    this->height = static_cast<GLfloat>(this->handle->GetHeight());
+    this->format = this->handle->GetFormat();
 };
 
 void    Texture::SetWrap(GLuint wrapS, GLuint wrapT)
@@ -113,6 +130,9 @@ void    Texture::SetTexImage(const float& width, const float& height,
         outerformat = GL_RGBA;
     glTexImage2D(this->target, 0, this->format, this->width, this->height, 0,
                 outerformat, this->type, data);
+    GpuMemory::Get().Track(GpuMemory::TEXTURE, this->id, static_cast<size_t>(this->width)
+                        * static_cast<size_t>(this->height) * GpuMemory::GetTexelSize(this->format),
+                        this->name.empty() ? "Texture" : "Texture " + this->name);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,393 @@
+#ifndef TEXTUREARRAY_HPP
+#define TEXTUREARRAY_HPP
+
+#include "Common.hpp"
+#include "TextureCooker.hpp"
+#include "GpuMemory.hpp"
+#include <map>
+#include <unordered_map>
+
+// 크기, 형식, mip 수, 채널 수, 용도가 같은 텍스처들을 층으로 쌓은 GL_TEXTURE_2D_ARRAY 하나.
+// 모델의 재질 텍스처를 이렇게 묶어 두면 메쉬가 바뀌어도 텍스처를 다시 바인드하지 않고 층 번호만 바꿔서 그린다.
+// stream 이면 쿠킹한 mip 사슬 중 STREAM_FLOOR_SIZE 이하의 작은 mip 만 먼저 올리고,
+// 큰 mip 은 TextureStreamer 가 GL_TEXTURE_BASE_LEVEL 을 한 단계씩 내리거나 올리면서 채우고 비운다.
+class TextureArray
+{
+public:
+    // 스트리밍해도 항상 남겨 두는 가장 큰 mip 의 한 변 크기
+    static constexpr int    STREAM_FLOOR_SIZE = 128;
+
+    static std::shared_ptr<TextureArray>    Create(const std::vector<TextureSource*>& layers, bool stream = false);
+    // 1x1 RGBA8 층 하나짜리 배열. 재질에 없는 텍스처 자리를 채운다. 픽셀이 작아서 큐를 거치지 않고 바로 올린다.
+    static std::shared_ptr<TextureArray>    CreateSolid(const unsigned char (&rgba)[4]);
+
+    ~TextureArray();
+    TextureArray(const TextureArray&) = delete;
+    TextureArray&   operator=(const TextureArray&) = delete;
+
+    GLuint  Get(void) const { return (this->id); };
+    int     GetWidth(void) const { return (this->width); };
+    int     GetHeight(void) const { return (this->height); };
+    int     GetChannels(void) const { return (this->channels); };
+    GLsizei GetLayerCount(void) const { return (this->layerCount); };
+
+    // 스트리밍 상태. 레벨 번호는 0 이 가장 큰 mip 이고, residentLevel ~ 마지막 레벨이 올라가 있다.
+    bool    IsStreamed(void) const { return (!this->sources.empty()); };
+    int     GetResidentLevel(void) const { return (this->residentLevel); };
+    int     GetFloorLevel(void) const { return (this->floorLevel); };
+    size_t  GetLevelSize(int level) const;
+    size_t  GetResidentSize(void) const;
+    // 사용 기록. 그릴 때 MarkUsed, 화면 크기를 알면 RequestDetail 로 필요한 레벨을 남긴다.
+    // TakeFeedback 은 이번 프레임에 쓰였는지와 필요한 레벨을 돌려주고 기록을 지운다.
+    void    MarkUsed(void) { this->used = true; };
+    void    RequestDetail(float screenPixels);
+    bool    TakeFeedback(int& level);
+    // ReadLevel 은 작업자 스레드에서 돌 수 있도록 원본만 잡은 함수를 만든다. 결과는 층 순서로 이어 붙인 블록이다.
+    std::function<std::vector<unsigned char>()> ReadLevel(int level) const;
+    void    LoadLevel(int level, std::shared_ptr<const std::vector<unsigned char>> data);
+    void    EvictLevel(void);
+private:
+    GLuint  id { 0 };
+    int     width { 0 }, height { 0 }, channels { 0 };
+    GLsizei layerCount { 0 };
+    // 스트리밍할 때만 채운다. 캐시에서 읽은 원본은 맵핑한 파일이라 큰 mip 도 페이지 캐시에만 남는다.
+    std::vector<std::shared_ptr<const CookedTexture>>   sources;
+    // residentLevel 은 자리를 잡은 레벨, baseLevel 은 픽셀까지 올라와서 샘플링하는 레벨이다.
+    int     residentLevel { 0 }, floorLevel { 0 }, baseLevel { 0 };
+    int     requestedLevel { -1 };
+    bool    used { false };
+
+    TextureArray() {};
+    void    init(const std::vector<TextureSource*>& layers, bool stream);
+    void    uploadCooked(const std::vector<TextureSource*>& layers, int firstLevel);
+    void    uploadImages(const std::vector<TextureSource*>& layers);
+    void    enqueueLayer(int level, int layer, GLenum format, GLenum type, const void* data, size_t size,
+                        std::shared_ptr<const void> owner, std::function<void()> done);
+    void    showLevel(int level);
+    void    track(size_t size) const;
+};
+
+// 재질 텍스처 하나가 들어간 배열과 그 층
+struct TextureLayer
+{
+    std::shared_ptr<TextureArray>   array;
+    GLint                           layer { 0 };
+};
+
+// 모델 하나의 텍스처 원본을 같은 배열에 들어갈 수 있는 것끼리 모아 올린다.
+// 혼자인 텍스처도 층 하나짜리 배열로 올려서 셰이더는 항상 sampler2DArray 로 읽는다.
+class TexturePacker
+{
+public:
+    static std::unordered_map<std::string, TextureLayer>    Pack(std::map<std::string, TextureSource>& sources,
+                                                            bool stream = false);
+private:
+    TexturePacker() {};
+    ~TexturePacker() {};
+
+    static std::string  makeSignature(const TextureSource& source);
+};
+
+std::shared_ptr<TextureArray>   TextureArray::Create(const std::vector<TextureSource*>& layers, bool stream)
+{
+    std::shared_ptr<TextureArray>   array = std::shared_ptr<TextureArray>(new TextureArray());
+    array->init(layers, stream);
+    return (array);
+};
+
+std::shared_ptr<TextureArray>   TextureArray::CreateSolid(const unsigned char (&rgba)[4])
+{
+    std::shared_ptr<TextureArray>   array = std::shared_ptr<TextureArray>(new TextureArray());
+    array->width = 1;
+    array->height = 1;
+    array->channels = 4;
+    array->layerCount = 1;
+    glGenTextures(1, &array->id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array->id);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 1, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    array->track(4);
+    return (array);
+};
+
+TextureArray::~TextureArray()
+{
+    // 아직 큐에 남은 층은 버린다. 컨텍스트가 이미 내려간 뒤라면 드라이버가 함께 정리한다.
+    TextureUploader::Get().Cancel(this->id);
+    GpuMemory::Get().Release(GpuMemory::TEXTURE, this->id);
+    if (this->id && glfwGetCurrentContext())
+        glDeleteTextures(1, &this->id);
+};
+
+// 층은 모두 같은 signature 라고 가정한다. (TexturePacker 가 그렇게 묶는다)
+// 압축하지 않은 이미지는 mip 을 GL 이 만들므로 스트리밍하지 않고 전부 올린다.
+// 픽셀은 TextureUploader 큐로 넘기고, 압축하지 않은 원본의 픽셀 소유권도 큐가 가져간다.
+void    TextureArray::init(const std::vector<TextureSource*>& layers, bool stream)
+{
+    const TextureSource&    first = *layers.front();
+    this->width = first.GetWidth();
+    this->height = first.GetHeight();
+    this->channels = first.GetChannels();
+    this->layerCount = static_cast<GLsizei>(layers.size());
+
+    glGenTextures(1, &this->id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->id);
+    SetImageSwizzle(GL_TEXTURE_2D_ARRAY, this->channels, first.role);
+    if (first.cooked)
+    {
+        int lastLevel = static_cast<int>(first.cooked->mips.size()) - 1;
+        if (stream)
+        {
+            this->floorLevel = lastLevel;
+            while (this->floorLevel > 0
+                && static_cast<int>(std::max(first.cooked->mips[this->floorLevel - 1].width,
+                                            first.cooked->mips[this->floorLevel - 1].height)) <= STREAM_FLOOR_SIZE)
+                --this->floorLevel;
+            if (this->floorLevel > 0)
+                for (const TextureSource* layer : layers)
+                    this->sources.push_back(layer->cooked);
+        }
+        this->residentLevel = this->floorLevel;
+        uploadCooked(layers, this->residentLevel);
+    }
+    else
+        uploadImages(layers);
+    size_t  size = 0;
+    for (const TextureSource* layer : layers)
+        size += layer->GetVramSize();
+    track(IsStreamed() ? GetResidentSize() : size);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+};
+
+// mip 마다 전체 층 크기로 자리를 잡고, 가장 작은 mip 은 층을 이어 붙여 여기서 바로 채운다.
+// 나머지 픽셀은 작은 mip 부터 층별로 큐에 넣는다. firstLevel 보다 큰 mip 은 스트리머가 나중에 채운다.
+// base level 은 가장 작은 mip 에서 시작해서 레벨이 다 올라올 때마다 내려간다.
+void    TextureArray::uploadCooked(const std::vector<TextureSource*>& layers, int firstLevel)
+{
+    const CookedTexture&        first = *layers.front()->cooked;
+    int                         lastLevel = static_cast<int>(first.mips.size()) - 1;
+    size_t                      lastSize = first.mips[lastLevel].size;
+    std::vector<unsigned char>  smallest(lastSize * layers.size());
+    for (size_t layer = 0; layer < layers.size(); ++layer)
+        std::memcpy(&smallest[layer * lastSize], layers[layer]->cooked->GetMipData(lastLevel), lastSize);
+    for (int level = firstLevel; level <= lastLevel; ++level)
+    {
+        const CookedMip&    mip = first.mips[level];
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, first.format, mip.width, mip.height,
+                            this->layerCount, 0, static_cast<GLsizei>(mip.size * layers.size()),
+                            level == lastLevel ? smallest.data() : nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, lastLevel);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, lastLevel);
+    this->baseLevel = lastLevel;
+    for (int level = lastLevel - 1; level >= firstLevel; --level)
+        for (size_t layer = 0; layer < layers.size(); ++layer)
+            enqueueLayer(level, static_cast<int>(layer), first.format, 0, layers[layer]->cooked->GetMipData(level),
+                        first.mips[level].size, layers[layer]->cooked, layer + 1 == layers.size()
+                        ? std::function<void()>([this, level]() { showLevel(level); }) : nullptr);
+};
+
+// type 이 0 이면 압축 블록이다. done 은 보통 레벨의 마지막 층에만 붙인다.
+void    TextureArray::enqueueLayer(int level, int layer, GLenum format, GLenum type, const void* data, size_t size,
+                                std::shared_ptr<const void> owner, std::function<void()> done)
+{
+    PixelUpload upload;
+    upload.texture = this->id;
+    upload.target = GL_TEXTURE_2D_ARRAY;
+    upload.level = level;
+    upload.layer = layer;
+    upload.width = std::max(1, this->width >> level);
+    upload.height = std::max(1, this->height >> level);
+    upload.format = format;
+    upload.type = type;
+    upload.data = data;
+    upload.size = size;
+    upload.owner = std::move(owner);
+    upload.done = std::move(done);
+    TextureUploader::Get().Enqueue(std::move(upload));
+};
+
+// 레벨의 모든 층이 올라온 뒤에 부른다. 그 사이 비워진 레벨이면 무시한다.
+void    TextureArray::showLevel(int level)
+{
+    if (level < this->residentLevel || level >= this->baseLevel)
+        return ;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->id);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    this->baseLevel = level;
+};
+
+size_t  TextureArray::GetLevelSize(int level) const
+{
+    if (this->sources.empty())
+        return (0);
+    return (static_cast<size_t>(this->sources.front()->mips[level].size) * this->sources.size());
+};
+
+size_t  TextureArray::GetResidentSize(void) const
+{
+    if (this->sources.empty())
+        return (0);
+    size_t  size = 0;
+    for (int level = this->residentLevel; level < static_cast<int>(this->sources.front()->mips.size()); ++level)
+        size += GetLevelSize(level);
+    return (size);
+};
+
+// screenPixels 는 이 텍스처가 덮는 면이 화면에서 차지하는 한 변의 픽셀 수. 텍셀이 픽셀보다 두 배 많을 때마다 한 레벨 내려간다.
+// 한 프레임에 여러 메쉬가 부르면 가장 자세한 레벨을 남긴다.
+void    TextureArray::RequestDetail(float screenPixels)
+{
+    float   texelsPerPixel = static_cast<float>(std::max(this->width, this->height)) / std::max(screenPixels, 1.0f);
+    int     level = texelsPerPixel <= 1.0f ? 0 : static_cast<int>(std::floor(std::log2(texelsPerPixel)));
+    level = std::min(level, this->floorLevel);
+    this->requestedLevel = this->requestedLevel < 0 ? level : std::min(this->requestedLevel, level);
+};
+
+// 요청은 실제로 바인드됐을 때만 센다. 화면 크기 없이 그려졌으면 (MarkUsed 만) 가장 큰 mip 이 필요하다고 본다.
+bool    TextureArray::TakeFeedback(int& level)
+{
+    bool    wasUsed = this->used;
+    level = this->requestedLevel < 0 ? 0 : this->requestedLevel;
+    this->used = false;
+    this->requestedLevel = -1;
+    return (wasUsed);
+};
+
+std::function<std::vector<unsigned char>()> TextureArray::ReadLevel(int level) const
+{
+    std::vector<std::shared_ptr<const CookedTexture>>   layers = this->sources;
+    return ([layers, level]()
+    {
+        size_t                      size = layers.front()->mips[level].size;
+        std::vector<unsigned char>  data(size * layers.size());
+        for (size_t layer = 0; layer < layers.size(); ++layer)
+            std::memcpy(&data[layer * size], layers[layer]->GetMipData(level), size);
+        return (data);
+    });
+};
+
+// 바로 위 레벨만 받는다. 자리는 바로 잡고 픽셀은 층별로 큐에 넣는다. base 는 모든 층이 올라온 뒤에 내린다.
+void    TextureArray::LoadLevel(int level, std::shared_ptr<const std::vector<unsigned char>> data)
+{
+    if (level != this->residentLevel - 1 || data->size() != GetLevelSize(level))
+        return ;
+    const CookedTexture&    first = *this->sources.front();
+    const CookedMip&        mip = first.mips[level];
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->id);
+    glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, first.format, mip.width, mip.height, this->layerCount, 0,
+                        static_cast<GLsizei>(data->size()), nullptr);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    this->residentLevel = level;
+    track(GetResidentSize());
+    for (GLsizei layer = 0; layer < this->layerCount; ++layer)
+        enqueueLayer(level, layer, first.format, 0, data->data() + layer * mip.size, mip.size, data,
+                    layer + 1 == this->layerCount ? std::function<void()>([this, level]() { showLevel(level); })
+                                                : nullptr);
+};
+
+// 가장 큰 레벨 하나를 비운다. 아직 올리는 중이면 큐에서 빼고, base 를 먼저 올린 뒤
+// 그 레벨을 0 크기로 다시 정의해서 드라이버가 메모리를 놓게 한다.
+void    TextureArray::EvictLevel(void)
+{
+    if (this->residentLevel >= this->floorLevel)
+        return ;
+    const CookedTexture&    first = *this->sources.front();
+    TextureUploader::Get().Cancel(this->id, this->residentLevel);
+    this->baseLevel = std::max(this->baseLevel, this->residentLevel + 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->id);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, this->baseLevel);
+    glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, this->residentLevel, first.format, 0, 0, 0, 0, 0, nullptr);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    ++this->residentLevel;
+    track(GetResidentSize());
+};
+
+// 스트리밍하는 배열은 레벨을 올리고 내릴 때마다 올라가 있는 크기로 다시 적는다.
+void    TextureArray::track(size_t size) const
+{
+    GpuMemory::Get().Track(GpuMemory::TEXTURE, this->id, size, "TextureArray " + std::to_string(this->width) + "x"
+                        + std::to_string(this->height) + " x" + std::to_string(this->layerCount));
+};
+
+// mip 은 마지막 층이 올라온 뒤에 만든다.
+void    TextureArray::uploadImages(const std::vector<TextureSource*>& layers)
+{
+    const GLenum    formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    GLenum          format = formats[this->channels - 1];
+    GLuint          textureID = this->id;
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, layers.front()->GetInternalFormat(), this->width, this->height,
+                this->layerCount, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    for (size_t layer = 0; layer < layers.size(); ++layer)
+    {
+        DecodedImage&   image = layers[layer]->image;
+        const void*     data = image.pixels.get();
+        std::function<void()>   done;
+        if (layer + 1 == layers.size())
+            done = [textureID]()
+            {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+                glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            };
+        enqueueLayer(0, static_cast<int>(layer), format, GL_UNSIGNED_BYTE, data,
+                    static_cast<size_t>(this->width) * this->height * this->channels,
+                    std::shared_ptr<unsigned char>(image.pixels.release(), image.pixels.get_deleter()), done);
+    }
+};
+
+// 용도가 다르면 swizzle 이 달라질 수 있으므로 같은 형식이라도 따로 묶는다.
+std::string TexturePacker::makeSignature(const TextureSource& source)
+{
+    std::string signature = std::to_string(source.GetInternalFormat()) + '|' + std::to_string(source.GetWidth()) + 'x'
+                        + std::to_string(source.GetHeight()) + '|' + std::to_string(source.GetChannels())
+                        + '|' + std::to_string(source.role);
+    if (source.cooked)
+        signature += "|mips" + std::to_string(source.cooked->mips.size());
+    return (signature);
+};
+
+// sources 는 경로 순서로 정렬돼 있어서 같은 모델은 항상 같은 배열 / 층 배치가 나온다.
+// 한 배열에 들어가는 층 수는 GL_MAX_ARRAY_TEXTURE_LAYERS 를 넘지 않게 나눈다.
+// 압축하지 않은 원본의 픽셀은 업로드 큐로 넘어가므로 sources 는 이 뒤로 다시 쓰지 않는다.
+std::unordered_map<std::string, TextureLayer>   TexturePacker::Pack(std::map<std::string, TextureSource>& sources,
+                                                                bool stream)
+{
+    GLint   maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    // GL 3.3 이 보장하는 최소값
+    maxLayers = std::max(maxLayers, 256);
+
+    std::map<std::string, std::vector<const std::string*>>  groups;
+    for (const auto& source : sources)
+    {
+        if (!source.second.IsValid())
+            continue ;
+        TextureCooker::PrintReport(source.first, source.second);
+        groups[makeSignature(source.second)].push_back(&source.first);
+    }
+
+    std::unordered_map<std::string, TextureLayer>   layers;
+    for (const auto& group : groups)
+        for (size_t begin = 0; begin < group.second.size(); begin += maxLayers)
+        {
+            size_t                              end = std::min(group.second.size(), begin + maxLayers);
+            std::vector<TextureSource*>         members;
+            for (size_t i = begin; i < end; ++i)
+                members.push_back(&sources.at(*group.second[i]));
+            std::shared_ptr<TextureArray>   array = TextureArray::Create(members, stream);
+            for (size_t i = begin; i < end; ++i)
+                layers[*group.second[i]] = TextureLayer { array, static_cast<GLint>(i - begin) };
+        }
+    return (layers);
+};
+
+#endif
@@ -0,0 +1,360 @@
+#ifndef TEXTURECACHE_HPP
+#define TEXTURECACHE_HPP
+
+#include "Common.hpp"
+#include "TextureDecoder.hpp"
+#include "TextureCooker.hpp"
+#include "TextureArray.hpp"
+#include "TextureStreamer.hpp"
+#include "UploadBudget.hpp"
+#include "GpuMemory.hpp"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+// GL 텍스처 하나의 소유권. 마지막 참조가 사라지면 텍스처를 지운다. VRAM 장부에는 owner (캐시 키) 로 남는다.
+class TextureHandle
+{
+public:
+    TextureHandle(GLuint id, int width, int height, int channels, GLenum format, size_t byteSize,
+                const std::string& owner)
+        : id(id), width(width), height(height), channels(channels), format(format), byteSize(byteSize)
+    { GpuMemory::Get().Track(GpuMemory::TEXTURE, id, byteSize, owner); };
+    ~TextureHandle();
+    TextureHandle(const TextureHandle&) = delete;
+    TextureHandle&  operator=(const TextureHandle&) = delete;
+
+    GLuint  Get(void) const { return (this->id); };
+    int     GetWidth(void) const { return (this->width); };
+    int     GetHeight(void) const { return (this->height); };
+    int     GetChannels(void) const { return (this->channels); };
+    // sized 내부 형식 (압축 형식 포함) 과 mip 까지 포함한 VRAM 크기
+    GLenum  GetFormat(void) const { return (this->format); };
+    size_t  GetByteSize(void) const { return (this->byteSize); };
+private:
+    GLuint  id;
+    int     width, height, channels;
+    GLenum  format;
+    size_t  byteSize;
+};
+
+TextureHandle::~TextureHandle()
+{
+    // 아직 큐에 남은 픽셀은 버린다. 컨텍스트가 이미 내려간 뒤라면 드라이버가 함께 정리한다.
+    TextureUploader::Get().Cancel(this->id);
+    GpuMemory::Get().Release(GpuMemory::TEXTURE, this->id);
+    if (glfwGetCurrentContext())
+        glDeleteTextures(1, &this->id);
+};
+
+// 프로세스 전체에서 공유하는 이미지 텍스처 캐시. 키는 정규화한 경로 + 로드 옵션 (flip, 채널 수, 용도) 이다.
+// 캐시는 weak_ptr 만 들고 있으므로 모든 사용처가 놓으면 VRAM 에서 빠진다.
+// Find / FindLayer 는 로딩 스레드에서도 부를 수 있다. GL 호출이 있는 Load / Insert 는 컨텍스트 스레드에서만 쓴다.
+// 압축을 켜 두면 (기본) 이미지는 TextureCooker 로 BC 압축한 mip 사슬이 되어 올라간다.
+// 핸들은 바로 돌려주지만 픽셀은 TextureUploader 가 프레임마다 나눠 올린다. 다 올라가야 하면 TextureUploader::Flush
+class TextureCache
+{
+public:
+    static TextureCache&    Get(void);
+    static std::string      MakeKey(const std::filesystem::path& filePath, bool flip = true, int desiredChannels = 0,
+                                    int role = TextureRole::COLOR);
+
+    std::shared_ptr<TextureHandle>  Load(const std::filesystem::path& filePath, bool flip = true, int desiredChannels = 0,
+                                        int role = TextureRole::COLOR);
+    std::shared_ptr<TextureHandle>  Find(const std::string& key) const;
+    std::shared_ptr<TextureHandle>  Insert(const std::string& key, DecodedImage&& image, int role = TextureRole::COLOR);
+    std::shared_ptr<TextureHandle>  Insert(const std::string& key, TextureSource&& source);
+    // 텍스처 배열에 묶어 올린 층. 키는 MakeKey 와 같고, 배열도 weak_ptr 로만 든다.
+    TextureLayer    FindLayer(const std::string& key) const;
+    void            InsertLayer(const std::string& key, const TextureLayer& layer);
+
+    size_t  GetLiveCount(void) const;
+    void    SetCompression(bool enable) { this->compression = enable; };
+    // BC1 / BC3 는 S3TC 확장이 있어야 올릴 수 있다. 없으면 원본 그대로 올린다.
+    bool    IsCompressed(void) const { return (this->compression && GLAD_GL_EXT_texture_compression_s3tc); };
+    // BPTC 는 GL 4.2 부터라 그보다 낮은 컨텍스트에서는 BC1 / BC3 로 쿠킹한다.
+    static bool AllowBC7(void) { return (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc); };
+private:
+    struct LayerEntry
+    {
+        std::weak_ptr<TextureArray> array;
+        GLint                       layer;
+    };
+
+    std::unordered_map<std::string, std::weak_ptr<TextureHandle>>   entries;
+    std::unordered_map<std::string, LayerEntry>                     layers;
+    std::atomic<bool>   compression { true };
+    size_t              sweepThreshold { 64 };
+    mutable std::mutex  mutex;
+
+    TextureCache() {};
+    void    Sweep(void);
+};
+
+TextureCache&   TextureCache::Get(void)
+{
+    static TextureCache cache;
+    return (cache);
+};
+
+std::string TextureCache::MakeKey(const std::filesystem::path& filePath, bool flip, int desiredChannels, int role)
+{
+    std::error_code         error;
+    std::filesystem::path   normalized = std::filesystem::weakly_canonical(filePath, error);
+    if (error)
+        normalized = filePath.lexically_normal();
+    return (normalized.generic_string() + '|' + (flip ? '1' : '0') + std::to_string(desiredChannels)
+            + '|' + TextureRole::GetName(role));
+};
+
+std::shared_ptr<TextureHandle>  TextureCache::Load(const std::filesystem::path& filePath, bool flip, int desiredChannels,
+                                                int role)
+{
+    std::string                     key = MakeKey(filePath, flip, desiredChannels, role);
+    std::shared_ptr<TextureHandle>  handle = Find(key);
+    if (handle)
+        return (handle);
+    TextureSource   source = TextureCooker::LoadSource(filePath.string(), flip, desiredChannels, role, IsCompressed(),
+                                                    AllowBC7());
+    if (!source.IsValid())
+        return (nullptr);
+    return (Insert(key, std::move(source)));
+};
+
+std::shared_ptr<TextureHandle>  TextureCache::Find(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto    entry = this->entries.find(key);
+    if (entry == this->entries.end())
+        return (nullptr);
+    return (entry->second.lock());
+};
+
+// 같은 키를 두 곳에서 동시에 디코딩했으면 먼저 올라간 쪽을 쓰고 나중 것은 버린다.
+std::shared_ptr<TextureHandle>  TextureCache::Insert(const std::string& key, DecodedImage&& image, int role)
+{
+    std::shared_ptr<TextureHandle>  handle = Find(key);
+    if (handle)
+        return (handle);
+    int     width = image.width, height = image.height, channels = image.channels;
+    GLuint  id = UploadImage(std::move(image), role);
+    handle = std::make_shared<TextureHandle>(id, width, height, channels, TextureRole::GetInternalFormat(channels, role),
+                                            static_cast<size_t>(width) * height * channels * 4 / 3, key);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries[key] = handle;
+    if (this->entries.size() >= this->sweepThreshold)
+        Sweep();
+    return (handle);
+};
+
+// 새로 올릴 때마다 용도별 형식으로 아낀 VRAM 을 찍는다.
+std::shared_ptr<TextureHandle>  TextureCache::Insert(const std::string& key, TextureSource&& source)
+{
+    std::shared_ptr<TextureHandle>  handle = Find(key);
+    if (handle)
+        return (handle);
+    TextureCooker::PrintReport(key.substr(0, key.find('|')), source);
+    if (!source.cooked)
+        return (Insert(key, std::move(source.image), source.role));
+    const CookedTexture&    cooked = *source.cooked;
+    handle = std::make_shared<TextureHandle>(TextureCooker::Upload(source.cooked), cooked.width, cooked.height,
+                                            cooked.channels, cooked.format, cooked.GetByteSize(), key);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries[key] = handle;
+    if (this->entries.size() >= this->sweepThreshold)
+        Sweep();
+    return (handle);
+};
+
+TextureLayer    TextureCache::FindLayer(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto    entry = this->layers.find(key);
+    if (entry == this->layers.end())
+        return (TextureLayer {});
+    return (TextureLayer { entry->second.array.lock(), entry->second.layer });
+};
+
+// Insert 와 마찬가지로 같은 키가 살아 있으면 먼저 올라간 쪽을 남긴다.
+void    TextureCache::InsertLayer(const std::string& key, const TextureLayer& layer)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    LayerEntry& entry = this->layers[key];
+    if (!entry.array.expired())
+        return ;
+    entry = LayerEntry { layer.array, layer.layer };
+    if (this->entries.size() + this->layers.size() >= this->sweepThreshold)
+        Sweep();
+};
+
+size_t  TextureCache::GetLiveCount(void) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    size_t  count = 0;
+    for (const auto& entry : this->entries)
+        count += entry.second.expired() ? 0 : 1;
+    for (const auto& entry : this->layers)
+        count += entry.second.array.expired() ? 0 : 1;
+    return (count);
+};
+
+// Insert / InsertLayer 가 잠금을 쥔 채로 부른다.
+void    TextureCache::Sweep(void)
+{
+    for (auto entry = this->entries.begin(); entry != this->entries.end();)
+    {
+        if (entry->second.expired())
+            entry = this->entries.erase(entry);
+        else
+            ++entry;
+    }
+    for (auto entry = this->layers.begin(); entry != this->layers.end();)
+    {
+        if (entry->second.array.expired())
+            entry = this->layers.erase(entry);
+        else
+            ++entry;
+    }
+    this->sweepThreshold = std::max<size_t>(64, (this->entries.size() + this->layers.size()) * 2);
+};
+
+// 모델 하나가 참조하는 텍스처들을 메쉬 변환과 동시에 작업자 스레드에서 디코딩 / 쿠킹해 두고,
+// 메쉬 변환이 끝나면 컨텍스트 스레드에서 한꺼번에 업로드한다. 이미 캐시에 있으면 디코딩하지 않는다.
+// packLayers 면 모든 원본이 모인 뒤 TexturePacker 로 텍스처 배열에 묶어 올리고, 층을 캐시에 남긴다.
+// 다른 모델이 이미 올린 층이 캐시에 있으면 그 배열과 층을 그대로 쓴다.
+// 스트리밍을 켜 두면 (기본) 배열에는 작은 mip 만 올리고 나머지는 TextureStreamer 에 맡긴다.
+class TextureBatch
+{
+public:
+    TextureBatch(const std::string& directory, bool packLayers = false)
+        : directory(directory), packLayers(packLayers) {};
+    ~TextureBatch() {};
+
+    void    Request(const std::string& path, int role = TextureRole::COLOR);
+    void    Request(const std::string& path, int role, std::shared_ptr<const void> owner, const unsigned char* data,
+                    size_t size);
+    bool    UploadReady(UploadBudget& budget);
+    std::unordered_map<std::string, std::shared_ptr<TextureHandle>> UploadAll(void);
+    std::unordered_map<std::string, TextureLayer>   TakeLayers(void) { return (std::move(this->layers)); };
+private:
+    struct Pending
+    {
+        std::string                 path;
+        std::string                 key;
+        std::future<TextureSource>  source;
+    };
+
+    std::string directory;
+    bool        packLayers;
+    std::vector<Pending>    pending;
+    std::unordered_map<std::string, std::shared_ptr<TextureHandle>> ready;
+    std::map<std::string, TextureSource>            sources;
+    std::unordered_map<std::string, std::string>    keys;
+    std::unordered_map<std::string, TextureLayer>   layers;
+
+    bool    findCached(const std::string& path, const std::string& key);
+    void    finish(Pending& request, UploadBudget* budget);
+};
+
+void    TextureBatch::Request(const std::string& path, int role)
+{
+    std::string filename = this->directory + '/' + path;
+    std::string key = TextureCache::MakeKey(filename, true, 0, role);
+    if (findCached(path, key))
+        return ;
+    bool    compress = TextureCache::Get().IsCompressed(), allowBC7 = TextureCache::AllowBC7();
+    this->pending.push_back(Pending { path, key, ThreadPool::Get().Submit([filename, role, compress, allowBC7]()
+                            { return (TextureCooker::LoadSource(filename, true, 0, role, compress, allowBC7)); }) });
+};
+
+// 파일 안에 든 이미지. owner 는 data 를 가진 객체(맵핑된 GLB 등)로, 디코딩이 끝날 때까지 잡아 둔다.
+// 키는 directory / path 로 만들므로 path 는 원본 파일마다 달라야 한다.
+void    TextureBatch::Request(const std::string& path, int role, std::shared_ptr<const void> owner,
+                            const unsigned char* data, size_t size)
+{
+    std::string key = TextureCache::MakeKey(this->directory + '/' + path, true, 0, role);
+    if (findCached(path, key))
+        return ;
+    bool    compress = TextureCache::Get().IsCompressed(), allowBC7 = TextureCache::AllowBC7();
+    this->pending.push_back(Pending { path, key, ThreadPool::Get().Submit([owner, data, size, role, compress, allowBC7]()
+                            { return (TextureCooker::LoadSource(data, size, true, role, compress, allowBC7)); }) });
+};
+
+// 묶어 올리는 배치는 층을, 아니면 낱장 텍스처를 찾는다.
+bool    TextureBatch::findCached(const std::string& path, const std::string& key)
+{
+    if (this->packLayers)
+    {
+        TextureLayer    layer = TextureCache::Get().FindLayer(key);
+        if (!layer.array)
+            return (false);
+        this->layers[path] = layer;
+        return (true);
+    }
+    std::shared_ptr<TextureHandle>  handle = TextureCache::Get().Find(key);
+    if (!handle)
+        return (false);
+    this->ready[path] = handle;
+    return (true);
+};
+
+// 묶어 올릴 때는 여기서 원본만 모아 두고 GL 업로드는 UploadAll 에서 한 번에 한다.
+void    TextureBatch::finish(Pending& request, UploadBudget* budget)
+{
+    TextureSource   source = request.source.get();
+    if (!source.IsValid())
+        std::cout << "Texture failed to load at path: " << request.path << std::endl;
+    else if (this->packLayers)
+    {
+        this->sources[request.path] = std::move(source);
+        this->keys[request.path] = request.key;
+    }
+    else
+    {
+        if (budget)
+            budget->Consume(source.GetByteSize());
+        this->ready[request.path] = TextureCache::Get().Insert(request.key, std::move(source));
+    }
+};
+
+// 디코딩이 끝난 것만 예산 안에서 올린다. 남은 요청이 없으면 true
+bool    TextureBatch::UploadReady(UploadBudget& budget)
+{
+    for (auto request = this->pending.begin(); request != this->pending.end() && !budget.IsSpent();)
+    {
+        if (request->source.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++request;
+            continue ;
+        }
+        finish(*request, &budget);
+        request = this->pending.erase(request);
+    }
+    return (this->pending.empty());
+};
+
+// 묶어 올린 결과는 TakeLayers 로 가져간다. 이때 돌려주는 핸들은 비어 있다.
+std::unordered_map<std::string, std::shared_ptr<TextureHandle>> TextureBatch::UploadAll(void)
+{
+    for (auto& request : this->pending)
+        finish(request, nullptr);
+    if (this->packLayers)
+    {
+        std::unordered_map<std::string, TextureLayer>   packed = TexturePacker::Pack(this->sources,
+                                                                            TextureStreamer::Get().IsEnabled());
+        for (const auto& layer : packed)
+        {
+            TextureStreamer::Get().Register(layer.second.array);
+            TextureCache::Get().InsertLayer(this->keys[layer.first], layer.second);
+            this->layers[layer.first] = layer.second;
+        }
+    }
+    std::unordered_map<std::string, std::shared_ptr<TextureHandle>> handles = std::move(this->ready);
+    this->pending.clear();
+    this->ready.clear();
+    this->sources.clear();
+    this->keys.clear();
+    return (handles);
+};
+
+#endif
@@ -0,0 +1,558 @@
+#ifndef TEXTURECOOKER_HPP
+#define TEXTURECOOKER_HPP
+
+#include "Common.hpp"
+#include "TextureDecoder.hpp"
+#include "BlockEncoder.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include <functional>
+#include <thread>
+
+// 압축한 mip 한 단계. offset 은 CookedTexture 바이트 안의 위치
+struct CookedMip
+{
+    uint32_t    width, height;
+    uint64_t    offset, size;
+};
+
+// BC 로 압축한 mip 사슬 전체. 쿠킹 직후에는 data 가, 캐시에서 읽었으면 맵핑한 file 이 바이트를 가진다.
+struct CookedTexture
+{
+    GLenum                      format { 0 };
+    int                         width { 0 }, height { 0 }, channels { 0 };
+    int                         role { TextureRole::COLOR };
+    std::vector<CookedMip>      mips;
+    std::vector<unsigned char>  data;
+    std::unique_ptr<MappedFile> file;
+
+    const unsigned char*    GetMipData(size_t level) const
+    { return ((this->file ? this->file->Data() : this->data.data()) + this->mips[level].offset); };
+    size_t                  GetByteSize(void) const
+    { return (this->mips.empty() ? 0 : this->mips.back().offset + this->mips.back().size - this->mips.front().offset); };
+};
+
+// 작업자 스레드가 만들어 컨텍스트 스레드에 넘기는 텍스처 원본. 쿠킹했으면 cooked, 아니면 디코딩한 image 를 쓴다.
+struct TextureSource
+{
+    DecodedImage                            image;
+    std::shared_ptr<const CookedTexture>    cooked;
+    int                                     role { TextureRole::COLOR };
+
+    bool    IsValid(void) const { return (this->cooked || this->image.pixels); };
+    size_t  GetByteSize(void) const
+    {
+        return (this->cooked ? this->cooked->GetByteSize()
+                            : static_cast<size_t>(this->image.width) * this->image.height * this->image.channels);
+    };
+    // 올린 뒤 mip 까지 포함한 VRAM 크기. 압축하지 않은 이미지는 glGenerateMipmap 이 1/3 을 더 쓴다.
+    size_t  GetVramSize(void) const
+    { return (this->cooked ? this->cooked->GetByteSize() : GetByteSize() * 4 / 3); };
+    GLenum  GetInternalFormat(void) const
+    { return (this->cooked ? this->cooked->format : TextureRole::GetInternalFormat(this->image.channels, this->role)); };
+    int     GetWidth(void) const { return (this->cooked ? this->cooked->width : this->image.width); };
+    int     GetHeight(void) const { return (this->cooked ? this->cooked->height : this->image.height); };
+    int     GetChannels(void) const { return (this->cooked ? this->cooked->channels : this->image.channels); };
+};
+
+// 파일 구조: header | mips | (압축 블록) * mipCount. 블록 구간은 16 바이트 정렬이다.
+struct CookedTextureHeader
+{
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    format;
+    int32_t     width, height, channels;
+    int32_t     role;
+    uint32_t    mipCount;
+    uint32_t    flip;
+    uint64_t    sourceSize;
+    int64_t     sourceTime;
+};
+
+// 이미지를 CPU 에서 mip 사슬로 줄이고 BC1 / BC3 / BC4 / BC5 / BC7 로 압축한다. GL 없이 돌고, Upload 만 컨텍스트 스레드에서 부른다.
+// 용도 (TextureRole) 에 따라 albedo 는 sRGB 형식으로 선형 공간에서 줄이고, 노멀은 RG 두 채널로 줄이면서 다시 정규화한다.
+// 원본 옆의 .ctex 파일에 결과를 남겨 두고, 원본 크기 / 수정 시간이 같으면 다음부터는 맵핑해서 바로 올린다.
+class TextureCooker
+{
+public:
+    // GL_COMPRESSED_RGBA_S3TC_DXT1/DXT5_EXT, GL_COMPRESSED_RED/RG_RGTC1/2, GL_COMPRESSED_RGBA_BPTC_UNORM
+    static constexpr GLenum     BC1 = 0x83F1, BC3 = 0x83F3, BC4 = 0x8DBB, BC5 = 0x8DBD, BC7 = 0x8E8C;
+    // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+    static constexpr GLenum     BC1_SRGB = 0x8C4C, BC3_SRGB = 0x8C4F, BC7_SRGB = 0x8E8D;
+    // 3: 회색조 albedo 를 RGB 로 늘려서 sRGB 형식으로 쿠킹한다.
+    static constexpr uint32_t   VERSION = 3;
+
+    static GLenum       ChooseFormat(const DecodedImage& image, bool allowBC7, int role = TextureRole::COLOR);
+    static size_t       GetBlockSize(GLenum format)
+    { return (format == BC1 || format == BC1_SRGB || format == BC4 ? 8 : 16); };
+    static const char*  GetFormatName(GLenum format);
+    static void         PrintReport(const std::string& name, const TextureSource& source);
+
+    static std::shared_ptr<CookedTexture>   Cook(const DecodedImage& image, GLenum format, int role = TextureRole::COLOR);
+    static std::shared_ptr<CookedTexture>   Open(const std::string& sourcePath, bool flip, int role, bool allowBC7);
+    static bool                             Write(const std::string& sourcePath, bool flip, const CookedTexture& texture);
+    static TextureSource    LoadSource(const std::string& filename, bool flip, int desiredChannels, int role,
+                                    bool compress, bool allowBC7);
+    static TextureSource    LoadSource(const unsigned char* data, size_t size, bool flip, int role, bool compress,
+                                    bool allowBC7);
+    static GLuint           Upload(const std::shared_ptr<const CookedTexture>& texture);
+private:
+    // 필터링 중간 결과. 채널 수와 관계없이 RGBA 로 펼쳐 둔다. (없는 색 채널은 0, 없는 알파는 255)
+    struct MipImage
+    {
+        int                         width { 0 }, height { 0 };
+        std::vector<unsigned char>  rgba;
+    };
+
+    static constexpr size_t GRAIN = 16384;
+
+    static std::string  GetCachePath(const std::string& sourcePath)
+    { return (sourcePath + ".ctex"); };
+    static bool         GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time);
+    static size_t       Align(size_t offset)
+    { return ((offset + 15) & ~static_cast<size_t>(15)); };
+
+    static MipImage     expand(const DecodedImage& image);
+    static MipImage     downsample(const MipImage& source, bool weightAlpha, int role);
+    static const float* getLinearTable(void);
+    static unsigned char    encodeSrgb(float linear);
+    static void         encode(const MipImage& image, GLenum format, unsigned char* out);
+};
+
+// 알파가 실제로 쓰이는지는 픽셀을 봐야 안다. 다 255 면 BC1 로 충분하다.
+GLenum  TextureCooker::ChooseFormat(const DecodedImage& image, bool allowBC7, int role)
+{
+    bool    srgb = role == TextureRole::ALBEDO;
+    if (image.channels == 1)
+        return (BC4);
+    if (image.channels == 2)
+        return (BC5);
+    if (allowBC7)
+        return (srgb ? BC7_SRGB : BC7);
+    if (image.channels == 4)
+    {
+        size_t                  count = static_cast<size_t>(image.width) * image.height;
+        const unsigned char*    pixels = image.pixels.get();
+        for (size_t i = 0; i < count; ++i)
+            if (pixels[i * 4 + 3] != 255)
+                return (srgb ? BC3_SRGB : BC3);
+    }
+    return (srgb ? BC1_SRGB : BC1);
+};
+
+const char* TextureCooker::GetFormatName(GLenum format)
+{
+    switch (format)
+    {
+        case BC1: return ("BC1");
+        case BC3: return ("BC3");
+        case BC4: return ("BC4");
+        case BC5: return ("BC5");
+        case BC7: return ("BC7");
+        case BC1_SRGB: return ("BC1_SRGB");
+        case BC3_SRGB: return ("BC3_SRGB");
+        case BC7_SRGB: return ("BC7_SRGB");
+        case GL_R8: return ("R8");
+        case GL_RG8: return ("RG8");
+        case GL_RGB8: return ("RGB8");
+        case GL_SRGB8: return ("SRGB8");
+        case GL_RGBA8: return ("RGBA8");
+        case GL_SRGB8_ALPHA8: return ("SRGB8_ALPHA8");
+        default: return ("unknown");
+    }
+};
+
+// 용도와 형식, mip 까지 포함한 VRAM 크기를 RGBA8 + glGenerateMipmap 으로 올렸을 때와 비교해 찍는다.
+void    TextureCooker::PrintReport(const std::string& name, const TextureSource& source)
+{
+    double  used = source.GetVramSize() / 1024.0;
+    double  baseline = static_cast<double>(source.GetWidth()) * source.GetHeight() * 4 * 4 / 3 / 1024.0;
+    std::cout << "Texture " << name << ": " << source.GetWidth() << "x" << source.GetHeight() << " "
+            << TextureRole::GetName(source.role) << " " << GetFormatName(source.GetInternalFormat()) << " "
+            << static_cast<size_t>(used) << " KB (RGBA8 " << static_cast<size_t>(baseline) << " KB, saved "
+            << static_cast<int>(baseline > 0.0 ? 100.0 * (1.0 - used / baseline) : 0.0) << "%)" << std::endl;
+};
+
+// sRGB 8 비트 값 -> 0 ~ 255 범위의 선형 값
+const float*    TextureCooker::getLinearTable(void)
+{
+    static const std::array<float, 256> table = []()
+    {
+        std::array<float, 256>  values;
+        for (int i = 0; i < 256; ++i)
+        {
+            float   c = i / 255.0f;
+            values[i] = 255.0f * (c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f));
+        }
+        return (values);
+    }();
+    return (table.data());
+};
+
+unsigned char   TextureCooker::encodeSrgb(float linear)
+{
+    float   c = std::max(0.0f, std::min(1.0f, linear / 255.0f));
+    c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    return (static_cast<unsigned char>(c * 255.0f + 0.5f));
+};
+
+TextureCooker::MipImage TextureCooker::expand(const DecodedImage& image)
+{
+    MipImage    result;
+    result.width = image.width;
+    result.height = image.height;
+    result.rgba.resize(static_cast<size_t>(image.width) * image.height * 4);
+    const unsigned char*    pixels = image.pixels.get();
+    int                     channels = image.channels;
+    ThreadPool::Get().ParallelFor(static_cast<size_t>(image.width) * image.height, GRAIN, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            unsigned char   texel[4] = { 0, 0, 0, 255 };
+            std::memcpy(texel, pixels + i * channels, channels);
+            std::memcpy(&result.rgba[i * 4], texel, 4);
+        }
+    });
+    return (result);
+};
+
+// 원본 텍셀이 목적 텍셀에 겹치는 넓이로 가중하는 면적 필터. 짝수 크기면 2x2 상자, 홀수면 경계 텍셀을 나눠 갖는다.
+// 알파를 쓰는 이미지는 색을 알파로 가중해서 투명한 텍셀의 색이 가장자리로 번지지 않게 한다.
+// albedo 는 sRGB 를 선형으로 풀어서 평균하고, 노멀은 z 를 되살린 단위 벡터로 평균한 뒤 다시 정규화한다.
+TextureCooker::MipImage TextureCooker::downsample(const MipImage& source, bool weightAlpha, int role)
+{
+    struct Tap
+    {
+        int     index[3];
+        float   weight[3];
+        int     count;
+    };
+    auto    makeTaps = [](int sourceSize, int targetSize)
+    {
+        std::vector<Tap>    taps(targetSize);
+        float               scale = static_cast<float>(sourceSize) / targetSize;
+        for (int x = 0; x < targetSize; ++x)
+        {
+            float   begin = x * scale, end = (x + 1) * scale;
+            Tap&    tap = taps[x];
+            tap.count = 0;
+            for (int s = static_cast<int>(begin); s < end && s < sourceSize && tap.count < 3; ++s)
+            {
+                float   overlap = std::min(end, s + 1.0f) - std::max(begin, static_cast<float>(s));
+                if (overlap <= 0.0f)
+                    continue ;
+                tap.index[tap.count] = s;
+                tap.weight[tap.count++] = overlap / scale;
+            }
+        }
+        return (taps);
+    };
+
+    MipImage    result;
+    result.width = std::max(1, source.width / 2);
+    result.height = std::max(1, source.height / 2);
+    result.rgba.resize(static_cast<size_t>(result.width) * result.height * 4);
+    std::vector<Tap>    columns = makeTaps(source.width, result.width);
+    std::vector<Tap>    rows = makeTaps(source.height, result.height);
+    size_t              rowGrain = std::max<size_t>(1, GRAIN / result.width);
+    const float*        linear = getLinearTable();
+    ThreadPool::Get().ParallelFor(result.height, rowGrain, [&](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+            for (int x = 0; x < result.width; ++x)
+            {
+                float   sum[4] = {}, weighted[3] = {};
+                for (int j = 0; j < rows[y].count; ++j)
+                    for (int i = 0; i < columns[x].count; ++i)
+                    {
+                        const unsigned char*    texel = &source.rgba[(static_cast<size_t>(rows[y].index[j]) * source.width
+                                                                    + columns[x].index[i]) * 4];
+                        float   weight = rows[y].weight[j] * columns[x].weight[i];
+                        float   value[4];
+                        for (int c = 0; c < 4; ++c)
+                            value[c] = static_cast<float>(texel[c]);
+                        if (role == TextureRole::ALBEDO)
+                            for (int c = 0; c < 3; ++c)
+                                value[c] = linear[texel[c]];
+                        else if (role == TextureRole::NORMAL)
+                        {
+                            value[0] = texel[0] / 127.5f - 1.0f;
+                            value[1] = texel[1] / 127.5f - 1.0f;
+                            value[2] = std::sqrt(std::max(0.0f, 1.0f - value[0] * value[0] - value[1] * value[1]));
+                        }
+                        for (int c = 0; c < 4; ++c)
+                            sum[c] += weight * value[c];
+                        for (int c = 0; c < 3; ++c)
+                            weighted[c] += weight * value[c] * texel[3];
+                    }
+                unsigned char*  target = &result.rgba[(y * result.width + x) * 4];
+                if (role == TextureRole::NORMAL)
+                {
+                    glm::vec3   normal(sum[0], sum[1], sum[2]);
+                    float       length = glm::length(normal);
+                    normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+                    target[0] = static_cast<unsigned char>(std::min(255.0f, (normal.x + 1.0f) * 127.5f + 0.5f));
+                    target[1] = static_cast<unsigned char>(std::min(255.0f, (normal.y + 1.0f) * 127.5f + 0.5f));
+                    target[2] = 0;
+                    target[3] = static_cast<unsigned char>(std::min(255.0f, sum[3] + 0.5f));
+                    continue ;
+                }
+                for (int c = 0; c < 4; ++c)
+                {
+                    float   value = sum[c];
+                    if (weightAlpha && c < 3 && sum[3] > 0.0f)
+                        value = weighted[c] / sum[3];
+                    if (role == TextureRole::ALBEDO && c < 3)
+                        target[c] = encodeSrgb(value);
+                    else
+                        target[c] = static_cast<unsigned char>(std::min(255.0f, value + 0.5f));
+                }
+            }
+    });
+    return (result);
+};
+
+// 가장자리 블록은 마지막 행 / 열을 반복해서 채운다. 블록 행 단위로 나눠 돌린다.
+void    TextureCooker::encode(const MipImage& image, GLenum format, unsigned char* out)
+{
+    size_t  blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+    size_t  blockSize = GetBlockSize(format);
+    ThreadPool::Get().ParallelFor(blocksY, std::max<size_t>(1, GRAIN / 16 / blocksX), [&](size_t begin, size_t end)
+    {
+        unsigned char   block[64];
+        for (size_t by = begin; by < end; ++by)
+            for (size_t bx = 0; bx < blocksX; ++bx)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    size_t  x = std::min<size_t>(bx * 4 + i % 4, image.width - 1);
+                    size_t  y = std::min<size_t>(by * 4 + i / 4, image.height - 1);
+                    std::memcpy(block + i * 4, &image.rgba[(y * image.width + x) * 4], 4);
+                }
+                unsigned char*  target = out + (by * blocksX + bx) * blockSize;
+                if (format == BC1 || format == BC1_SRGB)
+                    BlockEncoder::EncodeBC1(block, target);
+                else if (format == BC3 || format == BC3_SRGB)
+                    BlockEncoder::EncodeBC3(block, target);
+                else if (format == BC4)
+                    BlockEncoder::EncodeBC4(block, 0, target);
+                else if (format == BC5)
+                    BlockEncoder::EncodeBC5(block, target);
+                else
+                    BlockEncoder::EncodeBC7(block, target);
+            }
+    });
+};
+
+// 1x1 까지 mip 을 만들면서 단계마다 바로 압축한다. 이전 단계만 들고 있으므로 추가 메모리는 RGBA 두 단계 분이다.
+std::shared_ptr<CookedTexture>  TextureCooker::Cook(const DecodedImage& image, GLenum format, int role)
+{
+    std::shared_ptr<CookedTexture>  texture = std::make_shared<CookedTexture>();
+    texture->format = format;
+    texture->width = image.width;
+    texture->height = image.height;
+    texture->channels = image.channels;
+    texture->role = role;
+
+    MipImage    level = expand(image);
+    size_t      offset = 0;
+    while (true)
+    {
+        CookedMip   mip;
+        mip.width = static_cast<uint32_t>(level.width);
+        mip.height = static_cast<uint32_t>(level.height);
+        mip.offset = offset;
+        mip.size = ((level.width + 3) / 4) * ((level.height + 3) / 4) * GetBlockSize(format);
+        texture->mips.push_back(mip);
+        texture->data.resize(offset + mip.size);
+        encode(level, format, texture->data.data() + offset);
+        offset = Align(offset + mip.size);
+        if (level.width == 1 && level.height == 1)
+            break ;
+        level = downsample(level, image.channels == 4, role);
+    }
+    return (texture);
+};
+
+bool    TextureCooker::GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time)
+{
+    std::error_code error;
+    size = std::filesystem::file_size(sourcePath, error);
+    if (error)
+        return (false);
+    time = std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+    return (!error);
+};
+
+// 버전, 원본 크기 / 수정 시간, flip, 용도 중 하나라도 다르거나 BC7 을 쓸 수 없는데 BC7 이면 다시 쿠킹한다.
+std::shared_ptr<CookedTexture>  TextureCooker::Open(const std::string& sourcePath, bool flip, int role, bool allowBC7)
+{
+    uint64_t    sourceSize;
+    int64_t     sourceTime;
+    if (!GetSourceStamp(sourcePath, sourceSize, sourceTime))
+        return (nullptr);
+    std::unique_ptr<MappedFile> file = MappedFile::Open(GetCachePath(sourcePath));
+    if (!file || file->Size() < sizeof(CookedTextureHeader))
+        return (nullptr);
+    const CookedTextureHeader*  header = reinterpret_cast<const CookedTextureHeader*>(file->Data());
+    if (std::memcmp(header->magic, "CTEX", 4) != 0 || header->version != VERSION
+        || header->sourceSize != sourceSize || header->sourceTime != sourceTime
+        || header->flip != static_cast<uint32_t>(flip) || header->role != role
+        || ((header->format == BC7 || header->format == BC7_SRGB) && !allowBC7)
+        || sizeof(CookedTextureHeader) + sizeof(CookedMip) * header->mipCount > file->Size())
+        return (nullptr);
+
+    std::shared_ptr<CookedTexture>  texture = std::make_shared<CookedTexture>();
+    texture->format = header->format;
+    texture->width = header->width;
+    texture->height = header->height;
+    texture->channels = header->channels;
+    texture->role = header->role;
+    const CookedMip*    mips = reinterpret_cast<const CookedMip*>(file->Data() + sizeof(CookedTextureHeader));
+    texture->mips.assign(mips, mips + header->mipCount);
+    for (const CookedMip& mip : texture->mips)
+        if (mip.offset + mip.size > file->Size())
+            return (nullptr);
+    texture->file = std::move(file);
+    return (texture);
+};
+
+// 쓰는 도중에 죽어도 깨진 캐시가 남지 않도록 임시 파일에 쓰고 바꿔치기한다.
+// 같은 텍스처를 두 모델이 동시에 쿠킹할 수 있으므로 임시 파일 이름에 스레드를 붙인다.
+bool    TextureCooker::Write(const std::string& sourcePath, bool flip, const CookedTexture& texture)
+{
+    CookedTextureHeader header {};
+    std::memcpy(header.magic, "CTEX", 4);
+    header.version = VERSION;
+    header.format = texture.format;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.channels = texture.channels;
+    header.role = texture.role;
+    header.mipCount = static_cast<uint32_t>(texture.mips.size());
+    header.flip = flip;
+    if (!GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+        return (false);
+
+    size_t                  base = Align(sizeof(CookedTextureHeader) + sizeof(CookedMip) * texture.mips.size());
+    std::vector<CookedMip>  mips = texture.mips;
+    for (CookedMip& mip : mips)
+        mip.offset += base - texture.mips.front().offset;
+
+    std::string cachePath = GetCachePath(sourcePath);
+    std::string tempPath = cachePath + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    bool        written = false;
+    {
+        std::ofstream   ofs(tempPath, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open())
+            return (false);
+        const char  padding[16] = { 0 };
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(mips.data()), sizeof(CookedMip) * mips.size());
+        ofs.write(padding, base - sizeof(CookedTextureHeader) - sizeof(CookedMip) * mips.size());
+        ofs.write(reinterpret_cast<const char*>(texture.GetMipData(0)), texture.GetByteSize());
+        ofs.close();
+        written = !ofs.fail();
+    }
+    // 쓰기에 실패했거나, 대상 캐시가 아직 맵핑돼 있어서 (Windows) 바꿔치지 못하면 임시 파일을 지운다.
+    std::error_code error;
+    if (written)
+        std::filesystem::rename(tempPath, cachePath, error);
+    if (!written || error)
+    {
+        std::error_code ignored;
+        std::filesystem::remove(tempPath, ignored);
+        return (false);
+    }
+    return (true);
+};
+
+// 작업자 스레드에서 부른다. 캐시가 맞으면 맵핑만 하고, 아니면 디코딩해서 용도에 맞게 채널을 줄이고 쿠킹한 뒤 캐시를 쓴다.
+// 채널 수를 강제로 바꿔 읽는 요청은 원본 그대로 올린다.
+TextureSource   TextureCooker::LoadSource(const std::string& filename, bool flip, int desiredChannels, int role,
+                                        bool compress, bool allowBC7)
+{
+    TextureSource   source;
+    source.role = role;
+    compress = compress && desiredChannels == 0;
+    if (compress && (source.cooked = Open(filename, flip, role, allowBC7)))
+        return (source);
+    source.image = DecodeImage(filename, flip, desiredChannels);
+    if (!source.image.pixels)
+        return (source);
+    if (desiredChannels == 0)
+        TextureRole::Apply(source.image, role);
+    if (!compress)
+        return (source);
+    std::shared_ptr<CookedTexture>  cooked = Cook(source.image, ChooseFormat(source.image, allowBC7, role), role);
+    Write(filename, flip, *cooked);
+    source.cooked = std::move(cooked);
+    source.image.pixels.reset();
+    return (source);
+};
+
+// GLB 처럼 파일 안에 든 이미지는 원본 파일 하나에 여러 장이라 캐시 파일 없이 매번 쿠킹한다.
+TextureSource   TextureCooker::LoadSource(const unsigned char* data, size_t size, bool flip, int role, bool compress,
+                                        bool allowBC7)
+{
+    TextureSource   source;
+    source.role = role;
+    source.image = DecodeImage(data, size, flip);
+    if (!source.image.pixels)
+        return (source);
+    TextureRole::Apply(source.image, role);
+    if (!compress)
+        return (source);
+    source.cooked = Cook(source.image, ChooseFormat(source.image, allowBC7, role), role);
+    source.image.pixels.reset();
+    return (source);
+};
+
+// 만들어 둔 mip 을 그대로 올리므로 glGenerateMipmap 을 부르지 않는다.
+// 모든 레벨의 자리를 잡고, 가장 작은 mip 은 몇 바이트뿐이라 여기서 바로 채운다. 나머지는 작은 mip 부터 TextureUploader 큐에 넣는다.
+// 레벨 하나가 올라갈 때마다 base level 을 그 레벨로 내려서, 큰 mip 이 오기 전에도 흐린 텍스처로 보인다.
+GLuint  TextureCooker::Upload(const std::shared_ptr<const CookedTexture>& texture)
+{
+    GLuint  textureID;
+    GLint   lastLevel = static_cast<GLint>(texture->mips.size()) - 1;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    SetImageSwizzle(GL_TEXTURE_2D, texture->channels, texture->role);
+    for (GLint level = 0; level <= lastLevel; ++level)
+    {
+        const CookedMip&    mip = texture->mips[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, texture->format, mip.width, mip.height, 0,
+                            static_cast<GLsizei>(mip.size), level == lastLevel ? texture->GetMipData(level) : nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, lastLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    for (GLint level = lastLevel - 1; level >= 0; --level)
+    {
+        const CookedMip&    mip = texture->mips[level];
+        PixelUpload         upload;
+        upload.texture = textureID;
+        upload.level = level;
+        upload.width = mip.width;
+        upload.height = mip.height;
+        upload.format = texture->format;
+        upload.data = texture->GetMipData(level);
+        upload.size = mip.size;
+        upload.owner = texture;
+        upload.done = [textureID, level]()
+        {
+            glBindTexture(GL_TEXTURE_2D, textureID);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        };
+        TextureUploader::Get().Enqueue(std::move(upload));
+    }
+    return (textureID);
+};
+
+#endif
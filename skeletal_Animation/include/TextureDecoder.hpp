@@ -0,0 +1,204 @@
+#ifndef TEXTUREDECODER_HPP
+#define TEXTUREDECODER_HPP
+
+#include "Common.hpp"
+#include "ThreadPool.hpp"
+#include "TextureUploader.hpp"
+#include <limits>
+
+// stb 로 디코딩한 픽셀. 작업자 스레드에서 만들고 컨텍스트 스레드에서 업로드한다.
+struct DecodedImage
+{
+    std::unique_ptr<unsigned char, void(*)(void*)>  pixels { nullptr, stbi_image_free };
+    int     width { 0 }, height { 0 }, channels { 0 };
+};
+
+// 텍스처가 셰이더에서 쓰이는 용도. 올릴 채널 수와 sized 형식, mip 필터링 방식을 정한다.
+// COLOR 는 용도를 모르는 이미지로, 원본 채널 그대로 선형 값으로 올린다.
+class TextureRole
+{
+public:
+    static constexpr int    COLOR = 0, ALBEDO = 1, NORMAL = 2, MASK = 3;
+
+    static int          FromType(const std::string& type);
+    static const char*  GetName(int role);
+    static void         Apply(DecodedImage& image, int role);
+    static GLenum       GetInternalFormat(int channels, int role);
+private:
+    TextureRole() {};
+    ~TextureRole() {};
+};
+
+DecodedImage    DecodeImage(const std::string& filename, bool flip = true, int desiredChannels = 0);
+DecodedImage    DecodeImage(const unsigned char* data, size_t size, bool flip = true, int desiredChannels = 0);
+void            FlipImage(DecodedImage& image);
+GLuint          UploadImage(DecodedImage&& image, int role = TextureRole::COLOR);
+void            SetImageSwizzle(GLenum target, int channels, int role);
+
+// 모델 재질의 텍스처 종류 (mTexture::type) 에서 용도를 고른다. height 는 한 채널짜리 값으로 본다.
+int     TextureRole::FromType(const std::string& type)
+{
+    if (type == "texture_diffuse")
+        return (ALBEDO);
+    if (type == "texture_normal")
+        return (NORMAL);
+    if (type == "texture_specular" || type == "texture_height")
+        return (MASK);
+    return (COLOR);
+};
+
+const char* TextureRole::GetName(int role)
+{
+    static const char*  names[4] = { "color", "albedo", "normal", "mask" };
+    return (role >= 0 && role < 4 ? names[role] : "unknown");
+};
+
+// 용도에 필요 없는 채널을 버린다. 노멀은 x, y 만 남기고 z 는 셰이더가 다시 만든다. 마스크는 첫 채널만 쓴다.
+// 한 / 두 채널 sRGB 형식은 core 에 없으므로 회색조 albedo 는 RGB (알파가 있으면 RGBA) 로 늘려서 sRGB 로 올린다.
+void    TextureRole::Apply(DecodedImage& image, int role)
+{
+    int target = image.channels;
+    if (role == NORMAL && image.channels >= 3)
+        target = 2;
+    else if (role == MASK && image.channels > 1)
+        target = 1;
+    else if (role == ALBEDO && image.channels < 3)
+        target = image.channels + 2;
+    if (!image.pixels || target == image.channels)
+        return ;
+
+    size_t          count = static_cast<size_t>(image.width) * image.height;
+    unsigned char*  pixels = static_cast<unsigned char*>(std::malloc(count * target));
+    if (!pixels)
+        throw std::string("Error: Out of memory while converting image");
+    const unsigned char*    source = image.pixels.get();
+    if (target > image.channels)
+        for (size_t i = 0; i < count; ++i)
+        {
+            const unsigned char*    texel = source + i * image.channels;
+            std::memset(pixels + i * target, texel[0], 3);
+            if (target == 4)
+                pixels[i * target + 3] = texel[1];
+        }
+    else
+        for (size_t i = 0; i < count; ++i)
+            std::memcpy(pixels + i * target, source + i * image.channels, target);
+    image.pixels.reset(pixels);
+    image.channels = target;
+};
+
+// 한 / 두 채널은 마스크 / 노멀이라 선형이다. albedo 는 Apply 에서 세 채널 이상으로 늘어난다.
+GLenum  TextureRole::GetInternalFormat(int channels, int role)
+{
+    if (channels == 1)
+        return (GL_R8);
+    if (channels == 2)
+        return (GL_RG8);
+    if (channels == 3)
+        return (role == ALBEDO ? GL_SRGB8 : GL_RGB8);
+    return (role == ALBEDO ? GL_SRGB8_ALPHA8 : GL_RGBA8);
+};
+
+// stbi_set_flip_vertically_on_load 는 전역 상태라 스레드에서 쓸 수 없으므로 직접 뒤집는다.
+DecodedImage    DecodeImage(const std::string& filename, bool flip, int desiredChannels)
+{
+    DecodedImage    image;
+    int             fileChannels;
+    image.pixels.reset(stbi_load(filename.c_str(), &image.width, &image.height, &fileChannels, desiredChannels));
+    if (!image.pixels)
+        return (image);
+    image.channels = desiredChannels ? desiredChannels : fileChannels;
+    if (flip)
+        FlipImage(image);
+    return (image);
+};
+
+// GLB 처럼 파일 안에 들어 있는 이미지. data 는 디코딩이 끝날 때까지 살아 있어야 한다.
+DecodedImage    DecodeImage(const unsigned char* data, size_t size, bool flip, int desiredChannels)
+{
+    DecodedImage    image;
+    int             fileChannels;
+    if (size > static_cast<size_t>(std::numeric_limits<int>::max()))
+        return (image);
+    image.pixels.reset(stbi_load_from_memory(data, static_cast<int>(size), &image.width, &image.height,
+                                            &fileChannels, desiredChannels));
+    if (!image.pixels)
+        return (image);
+    image.channels = desiredChannels ? desiredChannels : fileChannels;
+    if (flip)
+        FlipImage(image);
+    return (image);
+};
+
+void    FlipImage(DecodedImage& image)
+{
+    size_t                      rowSize = static_cast<size_t>(image.width) * image.channels;
+    std::vector<unsigned char>  row(rowSize);
+    unsigned char*              pixels = image.pixels.get();
+    for (int y = 0; y < image.height / 2; ++y)
+    {
+        unsigned char*  top = pixels + y * rowSize;
+        unsigned char*  bottom = pixels + (image.height - 1 - y) * rowSize;
+        std::memcpy(row.data(), top, rowSize);
+        std::memcpy(top, bottom, rowSize);
+        std::memcpy(bottom, row.data(), rowSize);
+    }
+};
+
+// 회색조 이미지도 RGBA 로 풀어 읽은 것과 같은 값이 샘플링되도록 채널을 펼친다.
+// 노멀은 RG 를 그대로 읽어 z 를 만들어야 하므로 펼치지 않는다.
+void    SetImageSwizzle(GLenum target, int channels, int role)
+{
+    if ((channels != 1 && channels != 2) || role == TextureRole::NORMAL)
+        return ;
+    GLint   alpha = channels == 1 ? GL_ONE : GL_GREEN;
+    GLint   swizzle[4] = { GL_RED, GL_RED, GL_RED, alpha };
+    glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+};
+
+// 저장 공간만 잡고 픽셀은 TextureUploader 큐로 넘긴다. mip 은 올라간 뒤에 만들고, 그 전까지는 불완전한 텍스처라 검게 보인다.
+GLuint  UploadImage(DecodedImage&& image, int role)
+{
+    unsigned int    textureID;
+    glGenTextures(1, &textureID);
+    if (!image.pixels)
+        return (textureID);
+
+    GLenum format = GL_RGBA;
+    if (image.channels == 1)
+        format = GL_RED;
+    else if (image.channels == 2)
+        format = GL_RG;
+    else if (image.channels == 3)
+        format = GL_RGB;
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    SetImageSwizzle(GL_TEXTURE_2D, image.channels, role);
+    glTexImage2D(GL_TEXTURE_2D, 0, TextureRole::GetInternalFormat(image.channels, role), image.width, image.height, 0,
+                format, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    PixelUpload upload;
+    upload.texture = textureID;
+    upload.width = image.width;
+    upload.height = image.height;
+    upload.format = format;
+    upload.type = GL_UNSIGNED_BYTE;
+    upload.size = static_cast<size_t>(image.width) * image.height * image.channels;
+    upload.data = image.pixels.get();
+    upload.owner = std::shared_ptr<unsigned char>(image.pixels.release(), image.pixels.get_deleter());
+    upload.done = [textureID]()
+    {
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    };
+    TextureUploader::Get().Enqueue(std::move(upload));
+    return (textureID);
+};
+
+#endif
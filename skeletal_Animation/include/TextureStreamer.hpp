@@ -0,0 +1,166 @@
+#ifndef TEXTURESTREAMER_HPP
+#define TEXTURESTREAMER_HPP
+
+#include "Common.hpp"
+#include "TextureArray.hpp"
+#include "ThreadPool.hpp"
+#include "UploadBudget.hpp"
+
+// 스트리밍하는 텍스처 배열의 큰 mip 을 VRAM 예산 안에서 올리고 내린다.
+// 컨텍스트 스레드에서 그리기가 끝난 뒤 매 프레임 Update 를 부른다. 그 프레임의 사용 기록으로 배열마다 필요한 레벨을 정하고,
+// 모자란 레벨은 한 단계씩 작업자 스레드에서 읽어 둔 뒤 다음 Update 들에서 예산 안에서 TextureUploader 큐에 넣는다.
+// 예산을 넘으면 가장 오래 안 쓴 배열의 가장 큰 mip 부터 내린다. 항상 남겨 두는 작은 mip 은 내리지 않는다.
+class TextureStreamer
+{
+public:
+    static TextureStreamer& Get(void);
+
+    void    Register(const std::shared_ptr<TextureArray>& array);
+    void    Update(UploadBudget& uploadBudget);
+
+    void    SetEnabled(bool enable) { this->enabled = enable; };
+    bool    IsEnabled(void) const { return (this->enabled); };
+    void    SetBudget(size_t bytes) { this->budget = bytes; };
+    size_t  GetBudget(void) const { return (this->budget); };
+    // 마지막 Update 기준으로 스트리밍하는 배열이 차지하는 VRAM 과 읽는 중인 레벨 수
+    size_t  GetResidentSize(void) const { return (this->residentSize); };
+    size_t  GetPendingCount(void) const;
+private:
+    struct Entry
+    {
+        std::weak_ptr<TextureArray> array;
+        int                         wantedLevel { 0 };
+        uint64_t                    lastUsed { 0 };
+        int                         pendingLevel { -1 };
+        std::future<std::vector<unsigned char>> pending;
+    };
+
+    std::vector<Entry>  entries;
+    bool                enabled { true };
+    size_t              budget { static_cast<size_t>(256) << 20 };
+    size_t              residentSize { 0 };
+    uint64_t            frame { 0 };
+
+    TextureStreamer() {};
+    bool    makeRoom(size_t size, const TextureArray* keep);
+};
+
+TextureStreamer&    TextureStreamer::Get(void)
+{
+    static TextureStreamer  streamer;
+    return (streamer);
+};
+
+// 작은 mip 만 올라간 배열만 받는다. 같은 배열을 두 번 넣으면 무시한다.
+void    TextureStreamer::Register(const std::shared_ptr<TextureArray>& array)
+{
+    if (!array || !array->IsStreamed())
+        return ;
+    for (const Entry& entry : this->entries)
+        if (entry.array.lock() == array)
+            return ;
+    Entry   entry;
+    entry.array = array;
+    entry.wantedLevel = array->GetResidentLevel();
+    entry.lastUsed = this->frame;
+    this->residentSize += array->GetResidentSize();
+    this->entries.push_back(std::move(entry));
+};
+
+void    TextureStreamer::Update(UploadBudget& uploadBudget)
+{
+    ++this->frame;
+    // 사라진 배열을 빼고 이번 프레임의 사용 기록을 모은다.
+    this->residentSize = 0;
+    for (auto entry = this->entries.begin(); entry != this->entries.end();)
+    {
+        std::shared_ptr<TextureArray>   array = entry->array.lock();
+        if (!array)
+        {
+            entry = this->entries.erase(entry);
+            continue ;
+        }
+        int level;
+        if (array->TakeFeedback(level))
+        {
+            entry->wantedLevel = level;
+            entry->lastUsed = this->frame;
+        }
+        this->residentSize += array->GetResidentSize();
+        ++entry;
+    }
+    // 예산을 줄였거나 필요 없어진 레벨이 남아 있으면 먼저 예산 안으로 맞춘다.
+    makeRoom(0, nullptr);
+
+    // 읽기가 끝난 레벨을 올린다. 그 사이 예산 때문에 내려갔으면 이어지지 않으므로 버린다.
+    for (Entry& entry : this->entries)
+    {
+        if (uploadBudget.IsSpent())
+            break ;
+        if (entry.pendingLevel < 0 || entry.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue ;
+        std::shared_ptr<const std::vector<unsigned char>>   data =
+            std::make_shared<const std::vector<unsigned char>>(entry.pending.get());
+        int                             level = entry.pendingLevel;
+        std::shared_ptr<TextureArray>   array = entry.array.lock();
+        entry.pendingLevel = -1;
+        if (level != array->GetResidentLevel() - 1 || !makeRoom(data->size(), array.get()))
+            continue ;
+        array->LoadLevel(level, data);
+        this->residentSize += data->size();
+        uploadBudget.Consume(data->size());
+    }
+
+    // 이번 프레임에 쓴 배열 중 더 큰 mip 이 필요한 것은 바로 위 레벨을 읽기 시작한다.
+    // 자리는 읽기 전에 만들어 두어서, 예산 안에 들어갈 수 없으면 읽지도 않는다.
+    for (Entry& entry : this->entries)
+    {
+        std::shared_ptr<TextureArray>   array = entry.array.lock();
+        int                             level = array->GetResidentLevel() - 1;
+        if (entry.pendingLevel >= 0 || entry.lastUsed != this->frame || level < entry.wantedLevel)
+            continue ;
+        if (!makeRoom(array->GetLevelSize(level), array.get()))
+            continue ;
+        entry.pendingLevel = level;
+        entry.pending = ThreadPool::Get().Submit(array->ReadLevel(level));
+    }
+};
+
+size_t  TextureStreamer::GetPendingCount(void) const
+{
+    size_t  count = 0;
+    for (const Entry& entry : this->entries)
+        count += entry.pendingLevel >= 0 ? 1 : 0;
+    return (count);
+};
+
+// 이번 프레임에 쓰지 않은 배열은 오래된 순서로, 쓴 배열은 필요한 레벨보다 더 올라가 있는 만큼만 내린다.
+// keep (자리를 원하는 배열) 은 내리지 않는다. 더 내릴 것이 없는데도 모자라면 false
+bool    TextureStreamer::makeRoom(size_t size, const TextureArray* keep)
+{
+    while (this->residentSize + size > this->budget)
+    {
+        Entry*                          victim = nullptr;
+        std::shared_ptr<TextureArray>   victimArray;
+        for (Entry& entry : this->entries)
+        {
+            std::shared_ptr<TextureArray>   array = entry.array.lock();
+            if (!array || array.get() == keep || array->GetResidentLevel() >= array->GetFloorLevel())
+                continue ;
+            if (entry.lastUsed == this->frame && array->GetResidentLevel() >= entry.wantedLevel)
+                continue ;
+            if (!victim || entry.lastUsed < victim->lastUsed)
+            {
+                victim = &entry;
+                victimArray = array;
+            }
+        }
+        if (!victim)
+            return (false);
+        this->residentSize -= victimArray->GetLevelSize(victimArray->GetResidentLevel());
+        victimArray->EvictLevel();
+    }
+    return (true);
+};
+
+#endif
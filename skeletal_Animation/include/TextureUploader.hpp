@@ -0,0 +1,257 @@
+#ifndef TEXTUREUPLOADER_HPP
+#define TEXTUREUPLOADER_HPP
+
+#include "Common.hpp"
+#include "GpuMemory.hpp"
+#include "UploadBudget.hpp"
+#include <array>
+#include <cstring>
+#include <deque>
+#include <functional>
+
+// 텍스처 한 레벨 (배열이면 한 층) 의 픽셀. 저장 공간은 부르는 쪽이 미리 glTexImage* 에 nullptr 로 잡아 둔다.
+// type 이 0 이면 format 은 압축 형식이고 data 는 블록 그대로다. owner 는 data 를 가진 객체로, 올릴 때까지 잡아 둔다.
+struct PixelUpload
+{
+    GLuint      texture { 0 };
+    GLenum      target { GL_TEXTURE_2D };
+    GLint       level { 0 }, layer { 0 };
+    GLsizei     width { 0 }, height { 0 };
+    GLenum      format { 0 }, type { 0 };
+    const void* data { nullptr };
+    size_t      size { 0 };
+    std::shared_ptr<const void> owner;
+    // GL 명령을 낸 바로 뒤 컨텍스트 스레드에서 부른다. (mip 생성, base level 조정 등)
+    std::function<void()>       done;
+};
+
+// 디코딩 / 쿠킹한 픽셀을 영구 맵핑한 PBO 고리에 복사하고, 텍스처 업로드는 그 PBO 에서 낸다.
+// PBO 하나를 다 채우면 fence 를 넣고 다음 것으로 넘어간다. GPU 가 그 fence 를 지나야 같은 PBO 를 다시 채운다.
+// Update 는 매 프레임 budget 만큼만 올리고, 다음 PBO 의 fence 가 아직이면 기다리지 않고 다음 프레임으로 미룬다.
+// 큐는 들어온 순서대로만 처리하므로 작은 mip 부터 넣으면 done 도 그 순서로 불린다.
+// GL 4.4 / ARB_buffer_storage 가 없거나 PBO 보다 큰 항목은 예전처럼 클라이언트 메모리에서 바로 올린다.
+// 모든 함수는 컨텍스트 스레드에서만 부른다.
+class TextureUploader
+{
+public:
+    static constexpr size_t SEGMENT_SIZE = static_cast<size_t>(8) << 20;
+    static constexpr int    SEGMENT_COUNT = 4;
+
+    static TextureUploader& Get(void);
+
+    ~TextureUploader();
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader&    operator=(const TextureUploader&) = delete;
+
+    void    Enqueue(PixelUpload&& upload);
+    void    Update(UploadBudget& budget);
+    void    Flush(void);
+    // 텍스처를 지우기 전에 부른다. level 이 -1 이면 그 텍스처의 모든 레벨을 뺀다.
+    void    Cancel(GLuint texture, GLint level = -1);
+
+    bool    IsIdle(void) const { return (this->queue.empty()); };
+    size_t  GetQueuedSize(void) const { return (this->queuedSize); };
+    // 마지막 Update / Flush 에서 올린 바이트 수
+    size_t  GetUploadedSize(void) const { return (this->uploadedSize); };
+    bool    IsPersistent(void) const { return (this->persistent); };
+private:
+    struct Segment
+    {
+        GLuint          buffer { 0 };
+        unsigned char*  mapped { nullptr };
+        size_t          used { 0 };
+        GLsync          fence { nullptr };
+    };
+
+    std::deque<PixelUpload>                 queue;
+    std::array<Segment, SEGMENT_COUNT>      segments;
+    int     current { 0 };
+    bool    initialized { false }, persistent { false };
+    size_t  queuedSize { 0 }, uploadedSize { 0 };
+
+    TextureUploader() {};
+    void            init(void);
+    void            process(UploadBudget* budget, bool wait);
+    unsigned char*  reserve(size_t size, bool wait, size_t& offset);
+    void            fenceCurrent(void);
+    void            issue(const PixelUpload& upload, const void* pixels);
+    static size_t   Align(size_t offset)
+    { return ((offset + 15) & ~static_cast<size_t>(15)); };
+};
+
+TextureUploader&    TextureUploader::Get(void)
+{
+    static TextureUploader  uploader;
+    return (uploader);
+};
+
+TextureUploader::~TextureUploader()
+{
+    // 컨텍스트가 이미 내려간 뒤라면 드라이버가 함께 정리한다.
+    if (!glfwGetCurrentContext())
+        return ;
+    for (Segment& segment : this->segments)
+    {
+        if (segment.fence)
+            glDeleteSync(segment.fence);
+        if (!segment.buffer)
+            continue ;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, segment.buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &segment.buffer);
+    }
+};
+
+// 처음 올릴 때 PBO 고리를 만든다. 하나라도 맵핑에 실패하면 전부 놓고 클라이언트 메모리로 올린다.
+void    TextureUploader::init(void)
+{
+    this->initialized = true;
+    if (!GLAD_GL_VERSION_4_4 && !GLAD_GL_ARB_buffer_storage)
+        return ;
+    GLbitfield  flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    this->persistent = true;
+    for (Segment& segment : this->segments)
+    {
+        glGenBuffers(1, &segment.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, segment.buffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, SEGMENT_SIZE, nullptr, flags);
+        GpuMemory::Get().Track(GpuMemory::BUFFER, segment.buffer, SEGMENT_SIZE, "TextureUploader ring");
+        segment.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, SEGMENT_SIZE, flags));
+        this->persistent = this->persistent && segment.mapped;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (this->persistent)
+        return ;
+    for (Segment& segment : this->segments)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, segment.buffer);
+        if (segment.mapped)
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &segment.buffer);
+        GpuMemory::Get().Release(GpuMemory::BUFFER, segment.buffer);
+        segment = Segment();
+    }
+};
+
+void    TextureUploader::Enqueue(PixelUpload&& upload)
+{
+    this->queuedSize += upload.size;
+    this->queue.push_back(std::move(upload));
+};
+
+void    TextureUploader::Update(UploadBudget& budget)
+{
+    process(&budget, false);
+};
+
+// 동기 로딩용. 큐가 빌 때까지 올리고, PBO 가 모자라면 fence 를 기다린다.
+void    TextureUploader::Flush(void)
+{
+    process(nullptr, true);
+};
+
+void    TextureUploader::Cancel(GLuint texture, GLint level)
+{
+    for (auto upload = this->queue.begin(); upload != this->queue.end();)
+    {
+        if (upload->texture != texture || (level >= 0 && upload->level != level))
+        {
+            ++upload;
+            continue ;
+        }
+        this->queuedSize -= upload->size;
+        upload = this->queue.erase(upload);
+    }
+};
+
+void    TextureUploader::process(UploadBudget* budget, bool wait)
+{
+    if (!this->initialized)
+        init();
+    this->uploadedSize = 0;
+    while (!this->queue.empty() && !(budget && budget->IsSpent()))
+    {
+        PixelUpload&    upload = this->queue.front();
+        if (this->persistent && upload.size <= SEGMENT_SIZE)
+        {
+            size_t          offset = 0;
+            unsigned char*  target = reserve(upload.size, wait, offset);
+            if (!target)
+                break ;
+            std::memcpy(target, upload.data, upload.size);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->segments[this->current].buffer);
+            issue(upload, reinterpret_cast<const void*>(offset));
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        else
+            issue(upload, upload.data);
+        // done 이 Cancel 로 큐를 지울 수 있으므로 먼저 꺼내고 부른다.
+        PixelUpload finished = std::move(upload);
+        this->queue.pop_front();
+        if (budget)
+            budget->Consume(finished.size);
+        this->uploadedSize += finished.size;
+        this->queuedSize -= finished.size;
+        if (finished.done)
+            finished.done();
+    }
+    // 이번에 채운 PBO 는 여기서 닫아서 다음 프레임의 복사가 GPU 가 읽는 중인 곳을 덮지 않게 한다.
+    fenceCurrent();
+};
+
+// 지금 PBO 에 자리가 없으면 다음 PBO 로 넘어간다. 그 PBO 를 GPU 가 아직 읽고 있으면 wait 일 때만 기다린다.
+unsigned char*  TextureUploader::reserve(size_t size, bool wait, size_t& offset)
+{
+    if (this->segments[this->current].used + size > SEGMENT_SIZE)
+        fenceCurrent();
+    Segment&    segment = this->segments[this->current];
+    while (segment.fence)
+    {
+        GLenum  state = glClientWaitSync(segment.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                        wait ? static_cast<GLuint64>(1000000) : 0);
+        if (state == GL_TIMEOUT_EXPIRED && wait)
+            continue ;
+        if (state == GL_TIMEOUT_EXPIRED)
+            return (nullptr);
+        glDeleteSync(segment.fence);
+        segment.fence = nullptr;
+        segment.used = 0;
+    }
+    offset = segment.used;
+    segment.used = Align(segment.used + size);
+    return (segment.mapped + offset);
+};
+
+void    TextureUploader::fenceCurrent(void)
+{
+    Segment&    segment = this->segments[this->current];
+    if (!segment.used || segment.fence)
+        return ;
+    segment.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->current = (this->current + 1) % SEGMENT_COUNT;
+};
+
+// pixels 는 PBO 가 바인드돼 있으면 그 안의 오프셋, 아니면 클라이언트 메모리 주소다.
+void    TextureUploader::issue(const PixelUpload& upload, const void* pixels)
+{
+    glBindTexture(upload.target, upload.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (upload.target == GL_TEXTURE_2D_ARRAY && upload.type == 0)
+        glCompressedTexSubImage3D(upload.target, upload.level, 0, 0, upload.layer, upload.width, upload.height, 1,
+                                upload.format, static_cast<GLsizei>(upload.size), pixels);
+    else if (upload.target == GL_TEXTURE_2D_ARRAY)
+        glTexSubImage3D(upload.target, upload.level, 0, 0, upload.layer, upload.width, upload.height, 1,
+                        upload.format, upload.type, pixels);
+    else if (upload.type == 0)
+        glCompressedTexSubImage2D(upload.target, upload.level, 0, 0, upload.width, upload.height, upload.format,
+                                static_cast<GLsizei>(upload.size), pixels);
+    else
+        glTexSubImage2D(upload.target, upload.level, 0, 0, upload.width, upload.height, upload.format, upload.type,
+                        pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(upload.target, 0);
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include "Common.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+// 로딩 작업(디코딩, 정점 변환 등)을 돌리는 작업자 스레드 풀. GL 호출은 넣지 않는다.
+class ThreadPool
+{
+public:
+    static ThreadPool&  Get(void);
+
+    ~ThreadPool();
+
+    template <typename F>
+    auto    Submit(F&& task) -> std::future<decltype(task())>;
+    template <typename F>
+    void    ParallelFor(size_t count, size_t grain, F&& body);
+
+    size_t  GetWorkerCount(void) const { return (this->workers.size()); };
+private:
+    std::vector<std::thread>            workers;
+    std::queue<std::function<void()>>   tasks;
+    std::mutex                          mutex;
+    std::condition_variable             condition;
+    bool                                stopping { false };
+
+    ThreadPool(size_t workerCount);
+    void    WorkerLoop(void);
+};
+
+ThreadPool& ThreadPool::Get(void)
+{
+    // hardware_concurrency 는 알 수 없으면 0 을 돌려준다. 그때도 작업자는 하나 둔다.
+    static unsigned int hw = std::thread::hardware_concurrency();
+    static ThreadPool   pool(hw > 1 ? hw - 1 : 1);
+    return (pool);
+};
+
+ThreadPool::ThreadPool(size_t workerCount)
+{
+    for (size_t i = 0; i < workerCount; ++i)
+        this->workers.emplace_back(&ThreadPool::WorkerLoop, this);
+};
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->condition.notify_all();
+    for (auto& worker : this->workers)
+        worker.join();
+};
+
+template <typename F>
+auto    ThreadPool::Submit(F&& task) -> std::future<decltype(task())>
+{
+    using Result = decltype(task());
+    auto    packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    std::future<Result> future = packaged->get_future();
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->tasks.push([packaged]() { (*packaged)(); });
+    }
+    this->condition.notify_one();
+    return (future);
+};
+
+// [0, count) 를 grain 크기 구간으로 나눠 body(begin, end) 를 작업자와 부른 스레드가 같이 돌린다.
+// 부른 스레드도 구간을 가져가므로 작업자 스레드 안에서 (중첩해서) 불러도 서로 기다리다 멈추지 않는다.
+// 남은 구간이 없을 때 시작된 도우미 작업은 body 를 건드리지 않고 바로 끝난다.
+template <typename F>
+void    ThreadPool::ParallelFor(size_t count, size_t grain, F&& body)
+{
+    grain = std::max<size_t>(grain, 1);
+    size_t  chunks = (count + grain - 1) / grain;
+    if (chunks <= 1 || this->workers.empty())
+    {
+        if (count)
+            body(0, count);
+        return ;
+    }
+
+    struct Shared
+    {
+        std::atomic<size_t>     next { 0 };
+        std::atomic<size_t>     done { 0 };
+        std::mutex              mutex;
+        std::condition_variable finished;
+        std::exception_ptr      error;
+    };
+    std::shared_ptr<Shared> shared = std::make_shared<Shared>();
+    auto    run = [shared, chunks, count, grain, &body]()
+    {
+        size_t  chunk;
+        while ((chunk = shared->next.fetch_add(1)) < chunks)
+        {
+            try
+            {
+                body(chunk * grain, std::min(count, (chunk + 1) * grain));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                if (!shared->error)
+                    shared->error = std::current_exception();
+            }
+            if (shared->done.fetch_add(1) + 1 == chunks)
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->finished.notify_all();
+            }
+        }
+    };
+    size_t  helpers = std::min(chunks - 1, this->workers.size());
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (size_t i = 0; i < helpers; ++i)
+            this->tasks.push(run);
+    }
+    this->condition.notify_all();
+    run();
+
+    std::unique_lock<std::mutex>    lock(shared->mutex);
+    shared->finished.wait(lock, [&shared, chunks]() { return (shared->done.load() == chunks); });
+    if (shared->error)
+        std::rethrow_exception(shared->error);
+};
+
+void    ThreadPool::WorkerLoop(void)
+{
+    while (true)
+    {
+        std::function<void()>   task;
+        {
+            std::unique_lock<std::mutex>    lock(this->mutex);
+            this->condition.wait(lock, [this]() { return (this->stopping || !this->tasks.empty()); });
+            if (this->stopping && this->tasks.empty())
+                return ;
+            task = std::move(this->tasks.front());
+            this->tasks.pop();
+        }
+        task();
+    }
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef UPLOADBUDGET_HPP
+#define UPLOADBUDGET_HPP
+
+#include "Common.hpp"
+#include <limits>
+
+// 한 프레임에 컨텍스트 스레드에서 GPU 로 보낼 수 있는 바이트 수.
+// 항목 하나는 나누지 않으므로 마지막 항목이 예산을 조금 넘을 수 있다.
+struct UploadBudget
+{
+    size_t  remaining { std::numeric_limits<size_t>::max() };
+
+    UploadBudget() {};
+    UploadBudget(size_t bytes) : remaining(bytes) {};
+
+    bool    IsSpent(void) const { return (this->remaining == 0); };
+    void    Consume(size_t bytes) { this->remaining -= std::min(bytes, this->remaining); };
+};
+
+#endif
@@ -1,12 +1,14 @@
 #version 460 core
 
 in vec2     TexCoords;
+// diffuse, specular, normal, height 텍스처 배열의 층 번호
+flat in ivec4   MaterialLayers;
 
 out vec4    FragColor;
 
-uniform sampler2D   texture_diffuse;
+uniform sampler2DArray  texture_diffuse;
 
 void    main()
 {
-    FragColor = texture(texture_diffuse, TexCoords);
-}
\ No newline at end of file
+    FragColor = texture(texture_diffuse, vec3(TexCoords, MaterialLayers.x));
+}
@@ -3,11 +3,13 @@
 layout (location = 0) in vec3   aPosition;
 layout (location = 1) in vec3   aNormal;
 layout (location = 2) in vec2   aTexCoord;
-layout (location = 3) in vec3   aTangent;
+layout (location = 3) in vec4   aTangent;
 layout (location = 4) in ivec4  boneIds;
 layout (location = 5) in vec4   weights;
+layout (location = 10) in ivec4 aMaterialLayers;
 
 out vec2    TexCoords;
+flat out ivec4  MaterialLayers;
 
 const int   MAX_BONES = 100;
 const int   MAX_BONE_INFLUENCE = 4;
@@ -34,4 +36,5 @@ void    main()
     }
     gl_Position = view * model * totalPos;
     TexCoords = aTexCoord;
+    MaterialLayers = aMaterialLayers;
 }
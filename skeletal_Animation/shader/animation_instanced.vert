@@ -0,0 +1,41 @@
+#version 460 core
+
+layout (location = 0) in vec3   aPosition;
+layout (location = 1) in vec3   aNormal;
+layout (location = 2) in vec2   aTexCoord;
+layout (location = 3) in vec4   aTangent;
+layout (location = 4) in ivec4  boneIds;
+layout (location = 5) in vec4   weights;
+layout (location = 10) in ivec4 aMaterialLayers;
+
+out vec2    TexCoords;
+flat out ivec4  MaterialLayers;
+
+const int   MAX_BONE_INFLUENCE = 4;
+
+layout (std430, binding = 6) readonly buffer Palettes { mat4 palettes[]; };
+layout (std430, binding = 7) readonly buffer Instances { mat4 instanceModels[]; };
+
+uniform mat4	view;
+uniform mat4	model;
+uniform int     boneCount;
+
+void    main()
+{
+    int     paletteBase = gl_InstanceID * boneCount;
+	vec4    totalPos = vec4(0.0);
+    for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
+    {
+        if (boneIds[i] == -1)
+            continue;
+        if (boneIds[i] >= boneCount)
+        {
+            totalPos = vec4(aPosition, 1.0);
+            break ;
+        }
+        totalPos += palettes[paletteBase + boneIds[i]] * vec4(aPosition, 1.0) * weights[i];
+    }
+    gl_Position = view * model * instanceModels[gl_InstanceID] * totalPos;
+    TexCoords = aTexCoord;
+    MaterialLayers = aMaterialLayers;
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+layout (location = 0) in vec3   aPosition;
+layout (location = 6) in mat4   aInstanceModel;
+
+uniform mat4	view;
+uniform mat4	model;
+
+// 깊이 프리패스 뒤 GL_LEQUAL 로 그리는 색 패스 (model_instanced.vert) 와 깊이가 같도록 같은 식으로 계산한다.
+invariant gl_Position;
+
+void    main()
+{
+	mat4	world = model * aInstanceModel;
+	gl_Position = view * vec4((world * vec4(aPosition, 1.0)).xyz, 1.0);
+}
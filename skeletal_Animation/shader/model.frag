@@ -0,0 +1,77 @@
+#version 330 core
+
+in vec3     FragPos;
+in vec2     TexCoords;
+in vec3     Normal;
+in vec4     Tangent;
+// diffuse, specular, normal, height 텍스처 배열의 층 번호
+flat in ivec4   MaterialLayers;
+
+out vec4    FragColor;
+
+struct PointLight
+{
+    vec3	position;
+    vec3	ambient;
+    vec3	diffuse;
+    vec3	specular;
+};
+
+uniform int             numPointLight;
+uniform PointLight		pointLight[100];
+
+// 재질 자리마다 고정한 유닛에 묶인 텍스처 배열 (Mesh::BeginMaterials)
+uniform sampler2DArray  texture_diffuse;
+uniform sampler2DArray  texture_specular;
+uniform sampler2DArray  texture_normal;
+uniform float           shininess;
+
+uniform vec3	viewPos;
+
+vec3	CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, vec3 specularMask);
+
+void    main()
+{
+    // 노멀 맵은 RG 두 채널만 올라오므로 z 는 단위 길이에서 다시 만든다.
+    vec2    xy = texture(texture_normal, vec3(TexCoords, MaterialLayers.z)).rg * 2.0 - 1.0;
+    vec3    norm = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+    vec3    T = normalize(Tangent.xyz);
+    vec3    N = normalize(Normal);
+    vec3    B = cross(N, T) * Tangent.w;
+    mat3    TBN = mat3(T, B, N);
+    norm = normalize(TBN * norm);
+
+    vec3    albedo = texture(texture_diffuse, vec3(TexCoords, MaterialLayers.x)).rgb;
+    vec3    specularMask = texture(texture_specular, vec3(TexCoords, MaterialLayers.y)).rgb;
+    vec3	viewDir = normalize(viewPos - FragPos);
+	vec3	result = vec3(0.0);
+
+    for (int i = 0; i < numPointLight; ++i)
+	    result += CalcPointLight(pointLight[i], norm, FragPos, viewDir, albedo, specularMask);
+    FragColor = vec4(result, 1.0);
+}
+
+vec3	CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, vec3 specularMask)
+{
+	float	constant = 1.0f;
+    float   linear = 0.09f;
+    float   quadratic = 0.032f;
+
+    vec3	lightDir = normalize(light.position - fragPos);
+
+    float	diff = max(dot(normal, lightDir), 0.0);
+
+    vec3	halfwayDir = normalize(lightDir + viewDir);
+    float	spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
+
+    float	distance = length(light.position - fragPos);
+    float	attenuation = 1.0 / (constant + (linear * distance) + (quadratic * distance * distance));
+
+    vec3	ambient = light.ambient  * albedo;
+    vec3	diffuse = light.diffuse  * diff * albedo;
+    vec3	specular = light.specular * spec * specularMask;
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+};
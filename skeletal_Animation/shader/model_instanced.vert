@@ -0,0 +1,33 @@
+#version 330 core
+
+layout (location = 0) in vec3   aPosition;
+layout (location = 1) in vec3   aNormal;
+layout (location = 2) in vec2   aTexCoord;
+layout (location = 3) in vec4   aTangent;
+layout (location = 6) in mat4   aInstanceModel;
+layout (location = 10) in ivec4 aMaterialLayers;
+
+out	vec3	FragPos;
+out vec2    TexCoords;
+out vec3	Normal;
+out vec4	Tangent;
+flat out ivec4	MaterialLayers;
+
+uniform mat4	view;
+uniform mat4	model;
+
+// 깊이 프리패스 (depth_instanced.vert) 와 깊이가 같아야 GL_LEQUAL 로 통과한다.
+invariant gl_Position;
+
+void    main()
+{
+	mat4	world = model * aInstanceModel;
+	FragPos = (world * vec4(aPosition, 1.0)).xyz;
+	gl_Position = view * vec4(FragPos, 1.0);
+	TexCoords = aTexCoord;
+	MaterialLayers = aMaterialLayers;
+
+	mat4	InverseModel = transpose(inverse(world));
+	Normal = (InverseModel * vec4(aNormal, 0.0)).xyz;
+	Tangent = vec4((InverseModel * vec4(aTangent.xyz, 0.0)).xyz, aTangent.w);
+}
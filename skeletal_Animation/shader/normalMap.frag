@@ -3,7 +3,7 @@
 in vec3     FragPos;
 in vec2     TexCoords;
 in vec3     Normal;
-in vec3     Tangent;
+in vec4     Tangent;
 
 out vec4    FragColor;
 
@@ -54,11 +54,12 @@ vec3	CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 void    main()
 {
-    vec3    norm = texture(material.normal, TexCoords).rgb;
-    norm = normalize(norm * 2.0 - 1.0);
-    vec3    T = normalize(Tangent);
+    // 노멀 맵은 RG 두 채널만 올라오므로 z 는 단위 길이에서 다시 만든다.
+    vec2    xy = texture(material.normal, TexCoords).rg * 2.0 - 1.0;
+    vec3    norm = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+    vec3    T = normalize(Tangent.xyz);
     vec3    N = normalize(Normal);
-    vec3    B = cross(N, T);
+    vec3    B = cross(N, T) * Tangent.w;
     mat3    TBN = mat3(T, B, N);
     norm = normalize(TBN * norm);
 
@@ -3,12 +3,12 @@
 layout (location = 0) in vec3   aPosition;
 layout (location = 1) in vec3   aNormal;
 layout (location = 2) in vec2   aTexCoord;
-layout (location = 3) in vec3   aTangent;
+layout (location = 3) in vec4   aTangent;
 
 out	vec3	FragPos;
 out vec2    TexCoords;
 out vec3	Normal;
-out vec3	Tangent;
+out vec4	Tangent;
 
 uniform mat4	view;
 uniform mat4	model;
@@ -21,5 +21,5 @@ void    main()
 
 	mat4	InverseModel = transpose(inverse(model));
 	Normal = (InverseModel * vec4(aNormal, 0.0)).xyz;
-	Tangent = (InverseModel * vec4(aTangent, 0.0)).xyz;
+	Tangent = vec4((InverseModel * vec4(aTangent.xyz, 0.0)).xyz, aTangent.w);
 }
@@ -6,8 +6,12 @@
 #include "../include/Light.hpp"
 #include "../include/Object.hpp"
 #include "../include/MathOP.hpp"
+#include "../include/Model.hpp"
 #include "../include/AniModel.hpp"
 #include "../include/Animator.hpp"
+#include "../include/GPUAnimation.hpp"
+#include "../include/ClipLibrary.hpp"
+#include "../include/GpuMemory.hpp"
 
 using namespace std;
 
@@ -20,6 +24,12 @@ void    key_manager(GLFWwindow *window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+    // F1 을 누를 때마다 VRAM 장부를 큰 자원부터 찍는다.
+    static bool dumpHeld = false;
+    bool        dumpPressed = glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS;
+    if (dumpPressed && !dumpHeld)
+        GpuMemory::Get().Dump();
+    dumpHeld = dumpPressed;
     auto	camera = reinterpret_cast<Camera*>(glfwGetWindowUserPointer(window));
     camera->moveCamera(window);
 };
@@ -35,6 +45,8 @@ GLFWwindow* init_window(void)
     if (!glfwInit())
         throw string("Error: Failed to initialize GLFW");
     glfwWindowHint(GLFW_SAMPLES, 4);
+    // albedo 텍스처를 sRGB 로 올리므로 셰이더 출력도 선형 값으로 보고 기본 프레임버퍼에서 sRGB 로 바꾼다.
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -52,6 +64,7 @@ GLFWwindow* init_window(void)
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
         throw string("Error: Failed to initialize GLAD");
     glEnable(GL_DEPTH_TEST);
+    glEnable(GL_FRAMEBUFFER_SRGB);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); 
     return (window);
 };
@@ -62,8 +75,10 @@ int main_process()
 
     // Floor
     std::unique_ptr<Program>    objectProgram = Program::Create("./shader/normalMap.vert", "./shader/normalMap_point.frag");
-    std::unique_ptr<Texture>    floordiffuse = Texture::Load("./image/stone_wall_diff.png","material.diffuse");
-    std::unique_ptr<Texture>    floornormal = Texture::Load("./image/stone_wall_nor.png","material.normal");
+    std::unique_ptr<Texture>    floordiffuse = Texture::Load("./image/stone_wall_diff.png", "material.diffuse",
+                                                            GL_TEXTURE_2D, TextureRole::ALBEDO);
+    std::unique_ptr<Texture>    floornormal = Texture::Load("./image/stone_wall_nor.png", "material.normal",
+                                                            GL_TEXTURE_2D, TextureRole::NORMAL);
     std::unique_ptr<Object>     floor = Object::CreatePlane();
 
     // Lighting
@@ -75,11 +90,42 @@ int main_process()
     light->setUniform(objectProgram.get(), 0);
     objectProgram->setUniform(1, "numPointLight");
 
+    // Static Model. 작업자 스레드에서 읽고 프레임마다 예산 안에서 올린다. 다 올라오기 전에는 자리 표시 큐브를 그린다.
+    std::unique_ptr<Program>    modelProgram = Program::Create("./shader/model_instanced.vert", "./shader/model.frag");
+    std::unique_ptr<Program>    depthProgram = Program::Create("./shader/depth_instanced.vert", "./shader/depth.frag");
+    std::unique_ptr<Model>      backpack = Model::LoadModelAsync("./image/backpack/backpack.obj");
+
+    light->setUniform(modelProgram.get(), 0);
+    modelProgram->setUniform(1, "numPointLight");
+
     // Animation Model
     std::unique_ptr<Program>    skeleton = Program::Create("./shader/animation.vert", "./shader/animation.frag");
     std::unique_ptr<AniModel>   vampire = AniModel::LoadModel("./image/vampire/dancing_vampire.dae");
-    Animation   danceingAnimation("./image/vampire/dancing_vampire.dae", vampire.get());
-    Animator    animator(&danceingAnimation);
+    std::unique_ptr<ClipLibrary>    clips = ClipLibrary::Create();
+    Animation*                      danceingAnimation = clips->Load("./image/vampire/dancing_vampire.dae");
+    const BoneRemap*                vampireRemap = clips->GetRemap(vampire.get(), danceingAnimation);
+    Animator                        animator(danceingAnimation, vampireRemap);
+
+    // GPU Animation (compute shader 는 GL 4.3 이상에서만 쓸 수 있다)
+    std::unique_ptr<Program>        sampleProgram, crowdProgram;
+    std::unique_ptr<GPUAnimation>   crowd;
+    if (GLAD_GL_VERSION_4_3)
+    {
+        sampleProgram = Program::CreateCompute("./shader/animation_sample.comp");
+        crowdProgram = Program::Create("./shader/animation_instanced.vert", "./shader/animation.frag");
+        crowd = GPUAnimation::Create(danceingAnimation, 100, vampireRemap);
+        for (int i = 0; i < crowd->GetInstanceCount(); ++i)
+        {
+            glm::vec3   offset((i % 10 - 4.5f) * 4.0f, 0.0f, -(i / 10 + 1) * 4.0f);
+            crowd->SetInstance(i, glm::translate(glm::mat4(1.0f), offset), i / 100.0f);
+        }
+        crowd->UpdateAnimation(0.0f);
+        crowd->Dispatch(sampleProgram.get());
+#ifdef VALIDATE_GPU_ANIMATION
+        // 팔레트를 CPU 로 되읽어 비교하므로 검증할 때만 켠다. (-DVALIDATE_GPU_ANIMATION)
+        std::cout << "GPU animation max error: " << crowd->Validate() << std::endl;
+#endif
+    }
 
     // Camera
     double  x, y;
@@ -98,7 +144,16 @@ int main_process()
 
         key_manager(window);
 
+        // 한 프레임에 올리는 모델 데이터는 4MB 까지
+        UploadBudget    modelBudget(static_cast<size_t>(4) << 20);
+        backpack->Update(modelBudget);
+
         animator.UpdateAnimation(deltaTime);
+        if (crowd)
+        {
+            crowd->UpdateAnimation(deltaTime);
+            crowd->Dispatch(sampleProgram.get());
+        }
 
         glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -131,11 +186,30 @@ int main_process()
         objectProgram->setUniform(camera->getPosition(), "viewPos");
         floor->Draw();
 
+        // Static Model. 깊이만 먼저 그리고, 색 패스는 LOD 와 meshlet 컬링을 거쳐 같은 깊이인 조각만 칠한다.
+        model = glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 1.0f, 0.0f));
+        model = glm::scale(model, glm::vec3(0.5f));
+        depthProgram->Use();
+        depthProgram->setUniform(view, "view");
+        depthProgram->setUniform(model, "model");
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        backpack->drawDepth(model, camera->getPosition());
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+        glDepthFunc(GL_LEQUAL);
+        modelProgram->Use();
+        modelProgram->setUniform(view, "view");
+        modelProgram->setUniform(model, "model");
+        modelProgram->setUniform(camera->getPosition(), "viewPos");
+        modelProgram->setUniform(64.0f, "shininess");
+        backpack->drawCulled(modelProgram.get(), model, view, camera->getPosition());
+        glDepthFunc(GL_LESS);
+
         skeleton->Use();
         skeleton->setUniform(view, "view");
 
         auto    transforms = animator.GetFinalBoneMatrices();
-        for (int i = 0; i < transforms.size(); ++i)
+        for (size_t i = 0; i < transforms.size(); ++i)
         {
             std::string name = "finalBonesMatrices[" + std::to_string(i) + "]";
             skeleton->setUniform(transforms[i], name);
@@ -143,7 +217,25 @@ int main_process()
         model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
         model = glm::scale(model, glm::vec3(0.5f));
         skeleton->setUniform(model, "model");
-        vampire->draw(skeleton.get());
+        vampire->draw(skeleton.get(), model, camera->getPosition());
+
+        if (crowd)
+        {
+            crowdProgram->Use();
+            crowdProgram->setUniform(view, "view");
+            crowdProgram->setUniform(model, "model");
+            crowd->Bind(crowdProgram.get());
+            // 텍스처 상세도는 카메라에 가장 가까운 인스턴스 기준으로 요청한다.
+            vampire->drawInstanced(crowdProgram.get(), crowd->GetInstanceCount(),
+                                crowd->GetNearestInstance(model, camera->getPosition()), camera->getPosition());
+        }
+
+        // 이번 프레임에 그린 텍스처 기록으로 큰 mip 을 올리거나 내린다. 한 프레임에 올리는 양은 8MB 까지
+        UploadBudget    streamBudget(static_cast<size_t>(8) << 20);
+        TextureStreamer::Get().Update(streamBudget);
+        // 큐에 쌓인 텍스처 픽셀을 PBO 를 거쳐 올린다. 한 프레임에 PBO 하나 크기까지
+        UploadBudget    uploadBudget(TextureUploader::SEGMENT_SIZE);
+        TextureUploader::Get().Update(uploadBudget);
 
         glfwSwapBuffers(window);
         glfwPollEvents();